@@ -15,5 +15,7 @@ in order to use MSP-EXP430F5438 HAL.
 
 #include "hal_led.h"
 #include "hal_board.h"
+#include "hal_cycle.h"
+#include "hal_clock.h"
 
 #endif /* HAL_ETF5438A_H */
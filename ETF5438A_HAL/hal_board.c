@@ -6,6 +6,8 @@
 #include "msp430.h"
 #include "hal_ETF5438A.h"
 
+/* MCLK and SMCLK frequency set by hal430SetSystemClock() or hal430SetSystemClockXT2() */
+static unsigned long ulSystemClock = 0;
 
 /**********************************************************************//**
  * @brief  Initializes all GPIO configurations.
@@ -41,33 +43,133 @@ void halBoardInit(void)
 }
 
 /**********************************************************************//**
- * @brief  Set function for MCLK frequency.
+ * @brief  Set MCLK frequency, optionally waiting for the FLL to settle.
+ *
+ * VCore is raised before the clock goes up and lowered only after it has
+ * come down, so the core never runs faster than its supply allows.
  *
+ * @param  settle  Nonzero to return only once the DCO runs at the frequency
  *
  * @return none
  *************************************************************************/
-void hal430SetSystemClock(unsigned long req_clock_rate, unsigned long ref_clock_rate)
+static void halSetSystemClock(unsigned long req_clock_rate, unsigned long ref_clock_rate,
+                              unsigned char settle)
 {
   /* Convert a Hz value to a KHz value, as required
    *  by the Init_FLL_Settle() function. */
   unsigned long ulCPU_Clock_KHz = req_clock_rate / 1000UL;
+  unsigned long ulRatio;
+  unsigned char ucVCore;
 
   //Make sure we aren't overclocking
   if(ulCPU_Clock_KHz > 25000L)
   {
     ulCPU_Clock_KHz = 25000L;
   }
+  ulRatio = ( ulCPU_Clock_KHz * 1000UL ) / ref_clock_rate;
 
-  //Set VCore to a level sufficient for the requested clock speed.
+  //Find a VCore level sufficient for the requested clock speed.
   if(ulCPU_Clock_KHz <= 8000L)
   {
-    SetVCore(PMMCOREV_0);
+    ucVCore = PMMCOREV_0;
   }
   else if(ulCPU_Clock_KHz <= 12000L)
   {
-    SetVCore(PMMCOREV_1);
+    ucVCore = PMMCOREV_1;
   }
   else if(ulCPU_Clock_KHz <= 20000L)
+  {
+    ucVCore = PMMCOREV_2;
+  }
+  else
+  {
+    ucVCore = PMMCOREV_3;
+  }
+
+  //Raise VCore before the clock, lower it after
+  if(ulCPU_Clock_KHz * 1000UL >= ulSystemClock)
+  {
+    SetVCore(ucVCore);
+  }
+
+  //Set the DCO
+  if(settle)
+  {
+    Init_FLL_Settle( ( unsigned short )ulCPU_Clock_KHz, ( unsigned short )ulRatio );
+  }
+  else
+  {
+    Init_FLL_Start( ( unsigned short )ulCPU_Clock_KHz, ( unsigned short )ulRatio );
+  }
+
+  if(ulCPU_Clock_KHz * 1000UL < ulSystemClock)
+  {
+    SetVCore(ucVCore);
+  }
+
+  //Above 16 MHz Init_FLL() runs MCLK from DCOCLK with half the multiplier
+  //doubled, below from DCOCLKDIV with the whole multiplier
+  if(ulCPU_Clock_KHz > 16000L)
+  {
+    ulRatio &= ~1UL;
+  }
+  ulSystemClock = ulRatio * ref_clock_rate;
+}
+
+/**********************************************************************//**
+ * @brief  Set function for MCLK frequency.
+ *
+ * Returns once the FLL has settled. Can be called again while the system
+ * runs.
+ *
+ * @return none
+ *************************************************************************/
+void hal430SetSystemClock(unsigned long req_clock_rate, unsigned long ref_clock_rate)
+{
+  halSetSystemClock(req_clock_rate, ref_clock_rate, 1);
+}
+
+/**********************************************************************//**
+ * @brief  Start MCLK towards a frequency without waiting for the FLL.
+ *
+ * For the boot, where the wait can overlap other work. Until the FLL has
+ * settled, HAL_FLL_SETTLE_MS at most, MCLK and SMCLK run below or near the
+ * frequency hal430GetSystemClock() reports, so nothing that depends on the
+ * exact SMCLK frequency may be started, and the FLL must not be stopped by
+ * LPM1 or deeper.
+ *
+ * @return none
+ *************************************************************************/
+void hal430StartSystemClock(unsigned long req_clock_rate, unsigned long ref_clock_rate)
+{
+  halSetSystemClock(req_clock_rate, ref_clock_rate, 0);
+}
+
+/**********************************************************************//**
+ * @brief  Run MCLK and SMCLK from the XT2 crystal.
+ *
+ * VCore is raised for the crystal frequency before XT2 is started. If the
+ * crystal does not start within the timeout, MCLK and SMCLK are left on the
+ * DCO.
+ *
+ * @param  xt2_clock_rate  Frequency of the XT2 crystal in Hz, 4 to 25 MHz
+ *
+ * @return UCS_STATUS_OK if MCLK and SMCLK run from XT2, UCS_STATUS_ERROR if not
+ *************************************************************************/
+unsigned int hal430SetSystemClockXT2(unsigned long xt2_clock_rate)
+{
+  unsigned int uiDrive;
+
+  //Set VCore to a level sufficient for the crystal
+  if(xt2_clock_rate <= 8000000UL)
+  {
+    SetVCore(PMMCOREV_0);
+  }
+  else if(xt2_clock_rate <= 12000000UL)
+  {
+    SetVCore(PMMCOREV_1);
+  }
+  else if(xt2_clock_rate <= 20000000UL)
   {
     SetVCore(PMMCOREV_2);
   }
@@ -76,6 +178,47 @@ void hal430SetSystemClock(unsigned long req_clock_rate, unsigned long ref_clock_
     SetVCore(PMMCOREV_3);
   }
 
-  //Set the DCO
-  Init_FLL_Settle( ( unsigned short )ulCPU_Clock_KHz, req_clock_rate / ref_clock_rate );
+  //Drive strength by crystal range: 4-8, 8-16, 16-24, 24-32 MHz
+  if(xt2_clock_rate <= 8000000UL)
+  {
+    uiDrive = XT2DRIVE_0;
+  }
+  else if(xt2_clock_rate <= 16000000UL)
+  {
+    uiDrive = XT2DRIVE_1;
+  }
+  else if(xt2_clock_rate <= 24000000UL)
+  {
+    uiDrive = XT2DRIVE_2;
+  }
+  else
+  {
+    uiDrive = XT2DRIVE_3;
+  }
+
+  //XT2IN and XT2OUT
+  P5SEL |= BIT2 + BIT3;
+
+  if(XT2_Start_Timeout(uiDrive, 50000) != UCS_STATUS_OK)
+  {
+    //Switch the crystal off again so it does not hold the fault flag
+    UCSCTL6 |= XT2OFF;
+    return UCS_STATUS_ERROR;
+  }
+
+  SELECT_MCLK_SMCLK(SELM__XT2CLK + SELS__XT2CLK);
+  ulSystemClock = xt2_clock_rate;
+
+  return UCS_STATUS_OK;
+}
+
+/**********************************************************************//**
+ * @brief  Get the frequency MCLK and SMCLK run at.
+ *
+ * @return Frequency in Hz set by hal430SetSystemClock() or
+ *         hal430SetSystemClockXT2(), 0 before either ran
+ *************************************************************************/
+unsigned long hal430GetSystemClock(void)
+{
+  return ulSystemClock;
 }
@@ -6,11 +6,17 @@
 #ifndef HAL_BOARD_H
 #define HAL_BOARD_H
 
+//Worst-case FLL settling time, 32 x 32 FLLREFCLK cycles at 32768 Hz
+#define HAL_FLL_SETTLE_MS   32
+
 /*----------------------------------------------------------------
  *                  Function Prototypes
  *----------------------------------------------------------------
  */
 extern void halBoardInit(void);
 void hal430SetSystemClock(unsigned long req_clock_rate, unsigned long ref_clock_rate);
+void hal430StartSystemClock(unsigned long req_clock_rate, unsigned long ref_clock_rate);
+unsigned int hal430SetSystemClockXT2(unsigned long xt2_clock_rate);
+unsigned long hal430GetSystemClock(void);
 
 #endif /* HAL_BOARD_H */
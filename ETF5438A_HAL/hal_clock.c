@@ -0,0 +1,129 @@
+/**
+ * @file hal_clock.c
+ * @brief Clock profiles
+ */
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "msp430.h"
+#include "hal_ETF5438A.h"
+#include "hal_clock.h"
+
+/* Loop count to wait for a crystal to start, about half a second at the
+DCO frequency after reset */
+#define halclockXT_TIMEOUT      ( 50000U )
+
+/* Fastest ADC12 clock, the 5.4 MHz of the data sheet with some margin */
+#define halclockADC_MAX_HZ      ( 5000000UL )
+
+/* Profile set up by eHALClockInit() */
+static HALClockProfile_t eCurrentProfile = eHALClockRefoFll;
+
+/* pdTRUE from starting the DCO, at boot or for a change, until vHALClockSettled() */
+static volatile BaseType_t xSettling = pdFALSE;
+
+/**
+ * @brief Start the 32768 Hz crystal and take ACLK and the FLL reference from it
+ * @return pdPASS if the crystal runs, pdFAIL if REFO is used instead
+ *
+ * P7.0 and P7.1 must already be set to their XT1 function.
+ */
+static BaseType_t prvStartXT1( void )
+{
+    /* XT1 on in low frequency mode */
+    UCSCTL6 &= ~( XT1OFF | XTS );
+
+    if( LFXT_Start_Timeout( XT1DRIVE_0, halclockXT_TIMEOUT ) != UCS_STATUS_OK )
+    {
+        /* Off again, so the fault flag does not hide the state of XT2 */
+        UCSCTL6 |= XT1OFF;
+        return pdFAIL;
+    }
+
+    SELECT_FLLREF( SELREF__XT1CLK );
+    SELECT_ACLK( SELA__XT1CLK );
+
+    return pdPASS;
+}
+
+HALClockProfile_t eHALClockInit( HALClockProfile_t eProfile )
+{
+    BaseType_t xXT1 = pdFAIL;
+
+    /* XT1 pins */
+    P7SEL |= BIT0 + BIT1;
+
+    if( ( eProfile == eHALClockXt1Fll ) || ( eProfile == eHALClockXt2Xt1 ) )
+    {
+        xXT1 = prvStartXT1();
+    }
+
+    if( xXT1 != pdPASS )
+    {
+        SELECT_FLLREF( SELREF__REFOCLK );
+        SELECT_ACLK( SELA__REFOCLK );
+    }
+
+    if( ( ( eProfile == eHALClockXt2 ) || ( eProfile == eHALClockXt2Xt1 ) ) &&
+        ( hal430SetSystemClockXT2( configXT2_CLOCK_HZ ) == UCS_STATUS_OK ) )
+    {
+        eCurrentProfile = ( xXT1 == pdPASS ) ? eHALClockXt2Xt1 : eHALClockXt2;
+    }
+    else
+    {
+        /* The DCO is locked to whichever 32768 Hz reference ACLK got; the
+        FLL settles while the boot goes on */
+        hal430StartSystemClock( configCPU_CLOCK_HZ, configLFXT_CLOCK_HZ );
+        xSettling = pdTRUE;
+        eCurrentProfile = ( xXT1 == pdPASS ) ? eHALClockXt1Fll : eHALClockRefoFll;
+    }
+
+    return eCurrentProfile;
+}
+
+HALClockProfile_t eHALClockGetProfile( void )
+{
+    return eCurrentProfile;
+}
+
+void vHALClockStartChange( uint32_t ulClockHz )
+{
+    /* Set first, so the idle task does not stop the FLL in LPM3 */
+    xSettling = pdTRUE;
+    hal430StartSystemClock( ulClockHz, configLFXT_CLOCK_HZ );
+}
+
+void vHALClockSettled( void )
+{
+    xSettling = pdFALSE;
+}
+
+BaseType_t xHALClockIsSettling( void )
+{
+    return xSettling;
+}
+
+uint16_t usHALClockAdcSource( void )
+{
+    uint32_t ulDivider;
+
+    if( ( eCurrentProfile == eHALClockRefoFll ) || ( eCurrentProfile == eHALClockXt1Fll ) )
+    {
+        /* MODOSC, independent of any later change of MCLK */
+        return ADC12SSEL_0 | ADC12DIV_0;
+    }
+
+    /* SMCLK divided down to the fastest clock the ADC12 accepts, 1 to 8 */
+    ulDivider = ( hal430GetSystemClock() + halclockADC_MAX_HZ - 1UL ) / halclockADC_MAX_HZ;
+    if( ulDivider < 1UL )
+    {
+        ulDivider = 1UL;
+    }
+    else if( ulDivider > 8UL )
+    {
+        ulDivider = 8UL;
+    }
+
+    return ( uint16_t ) ( ADC12SSEL_3 | ( ( uint16_t ) ( ulDivider - 1UL ) * ADC12DIV_1 ) );
+}
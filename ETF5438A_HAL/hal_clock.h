@@ -0,0 +1,93 @@
+/**
+ * @file hal_clock.h
+ * @brief Clock profiles
+ *
+ * A profile selects the sources of MCLK, SMCLK, ACLK and the FLL reference:
+ *
+ *     eHALClockRefoFll   DCO at configCPU_CLOCK_HZ, FLL and ACLK from REFO
+ *     eHALClockXt1Fll    DCO at configCPU_CLOCK_HZ, FLL and ACLK from XT1
+ *     eHALClockXt2       MCLK and SMCLK from XT2 at configXT2_CLOCK_HZ, ACLK from REFO
+ *     eHALClockXt2Xt1    MCLK and SMCLK from XT2, ACLK from XT1
+ *
+ * ACLK is 32768 Hz in every profile, so the kernel tick on Timer_A0 runs at
+ * the same rate whichever is chosen; with XT1 it is as accurate as the
+ * crystal. The UART ports compute their bit clocks from
+ * hal430GetSystemClock(), which every profile sets.
+ *
+ * Only the FLL profiles can change MCLK afterwards with
+ * vHALClockStartChange(). The ADC12 is clocked from MODOSC under them, so
+ * conversion timing does not move with the clock; under the XT2 profiles it
+ * runs from SMCLK divided down to at most 5 MHz, as accurate as the crystal.
+ */
+
+#ifndef HAL_CLOCK_H
+#define HAL_CLOCK_H
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+/** @brief Clock profile */
+typedef enum
+{
+    eHALClockRefoFll = 0,       /**< DCO locked to REFO, no crystal needed */
+    eHALClockXt1Fll,            /**< DCO locked to the 32768 Hz crystal */
+    eHALClockXt2,               /**< XT2 crystal, ACLK from REFO */
+    eHALClockXt2Xt1             /**< XT2 crystal, ACLK from the 32768 Hz crystal */
+} HALClockProfile_t;
+
+/**
+ * @brief Set up the clock system for a profile
+ * @param eProfile profile to set up
+ * @return profile actually set up
+ *
+ * Called once at boot with interrupts disabled. A crystal that does not start
+ * within its timeout is replaced: XT1 by REFO, XT2 by the DCO at
+ * configCPU_CLOCK_HZ, so the returned profile may differ from @p eProfile.
+ *
+ * Under the FLL profiles the DCO is only started, see
+ * hal430StartSystemClock(): for HAL_FLL_SETTLE_MS the UART ports must not be
+ * opened, and once that time has passed vHALClockSettled() must be called.
+ */
+extern HALClockProfile_t eHALClockInit( HALClockProfile_t eProfile );
+
+/**
+ * @brief Get the profile set up by eHALClockInit()
+ * @return current profile
+ */
+extern HALClockProfile_t eHALClockGetProfile( void );
+
+/**
+ * @brief Start moving MCLK and SMCLK to another frequency
+ * @param ulClockHz new frequency in Hz
+ *
+ * Only under the FLL profiles. Like at boot the DCO is only started, see
+ * hal430StartSystemClock(), so the caller can sleep while the FLL settles
+ * instead of spinning: for HAL_FLL_SETTLE_MS nothing may depend on the exact
+ * SMCLK frequency, and once that time has passed vHALClockSettled() must be
+ * called. VCore is raised before the clock or lowered after it.
+ */
+extern void vHALClockStartChange( uint32_t ulClockHz );
+
+/**
+ * @brief Report that HAL_FLL_SETTLE_MS have passed since eHALClockInit() or
+ * vHALClockStartChange()
+ */
+extern void vHALClockSettled( void );
+
+/**
+ * @brief Check whether the FLL is still settling
+ * @return pdTRUE from the start of the DCO until vHALClockSettled() has been called
+ *
+ * The FLL stops in LPM1 and deeper, so it settles only while the CPU runs or
+ * sleeps in LPM0.
+ */
+extern BaseType_t xHALClockIsSettling( void );
+
+/**
+ * @brief Get the ADC12 clock selection of the current profile
+ * @return ADC12SSEL and ADC12DIV bits to OR into ADC12CTL1
+ */
+extern uint16_t usHALClockAdcSource( void );
+
+#endif /* HAL_CLOCK_H */
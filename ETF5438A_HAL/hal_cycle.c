@@ -0,0 +1,19 @@
+/**
+ * @file hal_cycle.c
+ * @brief Free running cycle counter
+ */
+
+#include <stdint.h>
+
+#include "msp430.h"
+#include "hal_cycle.h"
+
+void vHALInitCycleCounter( void )
+{
+    /* Stop the timer and clear the count */
+    TA1CTL = TACLR;
+    /* No capture/compare interrupts are needed */
+    TA1CCTL0 = 0;
+    /* SMCLK, no divider, continuous mode */
+    TA1CTL = TASSEL_2 | ID_0 | MC_2;
+}
@@ -0,0 +1,25 @@
+/**
+ * @file hal_cycle.h
+ * @brief Free running cycle counter
+ *
+ * Timer_A1 is clocked from SMCLK in continuous mode. Under every clock
+ * profile SMCLK and MCLK run from the same source, so one count is one CPU
+ * cycle. The counter is 16 bits wide and wraps every 65536 cycles,
+ * so differences of two readings are only valid for shorter intervals.
+ */
+
+#ifndef HAL_CYCLE_H
+#define HAL_CYCLE_H
+
+/**
+ * @brief Initialize cycle counter
+ *
+ * Start Timer_A1 from SMCLK in continuous mode. Timer_A0 is left for the
+ * kernel tick.
+ */
+extern void vHALInitCycleCounter( void );
+
+/* Read current cycle count */
+#define halCYCLE_COUNT()		( ( uint16_t ) TA1R )
+
+#endif /* HAL_CYCLE_H */
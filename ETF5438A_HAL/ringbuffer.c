@@ -4,91 +4,397 @@
  * @date 2016
  * @brief Ringbuffer implementation
  *
- * Ringbuffer implementation which allows Byte sized elements to be stored and
- * retrieved.
+ * Single-producer/single-consumer ringbuffer of bytes, see ringbuffer.h.
  */
 
+/* Standard includes. */
+#include <string.h>
+
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 
 #include "ringbuffer.h"
 
+/** @brief Largest distance between head and tail the 16-bit indexes can represent */
+#define ringbufferMAX_DISTANCE	( 0xFFFFUL )
+
+/**
+ * @brief Copy bytes into buffer memory at free running index @p usIndex
+ *
+ * Wraps at the end of buffer memory, so at most two memcpy calls are made.
+ */
+static void prvCopyIn( RingBuffer_t *pxRingBuffer, uint16_t usIndex, const uint8_t *pucData, uint16_t usLength )
+{
+	uint16_t usOffset = usIndex & pxRingBuffer->usMask;
+	uint16_t usFirst = ( pxRingBuffer->usMask + 1 ) - usOffset;
+
+	if( usFirst > usLength )
+	{
+		usFirst = usLength;
+	}
+
+	memcpy( pxRingBuffer->pucBuffer + usOffset, pucData, usFirst );
+	memcpy( pxRingBuffer->pucBuffer, pucData + usFirst, usLength - usFirst );
+}
 
-RingBufferHandle_t xRingBufferCreate( uint8_t ucSize )
+/**
+ * @brief Copy bytes out of buffer memory from free running index @p usIndex
+ */
+static void prvCopyOut( const RingBuffer_t *pxRingBuffer, uint16_t usIndex, uint8_t *pucData, uint16_t usLength )
 {
-	/* allocate buffer memory using pvPortMalloc */
-	uint8_t *pucBuffer = ( uint8_t * ) pvPortMalloc( ucSize );
-	/* allocate RingBuffer_t struct memory using pvPortMalloc */
-	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) pvPortMalloc( sizeof( RingBuffer_t ) );
+	uint16_t usOffset = usIndex & pxRingBuffer->usMask;
+	uint16_t usFirst = ( pxRingBuffer->usMask + 1 ) - usOffset;
+
+	if( usFirst > usLength )
+	{
+		usFirst = usLength;
+	}
 
-	/* initialize pointers and counts */
-	pxRingBuffer->pucBuffer = pucBuffer;
-	pxRingBuffer->pucHead = pucBuffer;
-	pxRingBuffer->pucTail = pucBuffer;
-	pxRingBuffer->pucEnd = pucBuffer + ucSize - 1;
-	pxRingBuffer->ucCount = 0;
-	pxRingBuffer->ucMaxCount = ucSize - 1;
+	memcpy( pucData, pxRingBuffer->pucBuffer + usOffset, usFirst );
+	memcpy( pucData + usFirst, pxRingBuffer->pucBuffer, usLength - usFirst );
+}
+
+/**
+ * @brief Number of bytes the producer may have overwritten from index @p usTail on
+ *
+ * Consumer side. Everything older than one buffer length before the end of the
+ * producer's current write is, or is about to be, overwritten.
+ */
+static uint16_t prvOverwrittenFrom( const RingBuffer_t *pxRingBuffer, uint16_t usTail )
+{
+	uint16_t usDistance = pxRingBuffer->usReserved - usTail;
+	uint16_t usSize = pxRingBuffer->usMask + 1;
+
+	return ( usDistance > usSize ) ? ( usDistance - usSize ) : 0;
+}
+
+RingBufferHandle_t xRingBufferCreate( uint16_t usSize, RingBufferPolicy_t ePolicy )
+{
+	RingBuffer_t *pxRingBuffer = NULL;
+
+	/* size must be a power of two for the indexes to be masked */
+	if( ( usSize >= 2 ) && ( ( usSize & ( usSize - 1 ) ) == 0 ) )
+	{
+		/* allocate RingBuffer_t struct and buffer memory using one pvPortMalloc */
+		pxRingBuffer = ( RingBuffer_t * ) portMALLOC_TAGGED( sizeof( RingBuffer_t ) + usSize, eHeapTagRingBuffer );
+	}
+
+	if( pxRingBuffer != NULL )
+	{
+		/* initialize indexes and counts */
+		pxRingBuffer->pucBuffer = ( uint8_t * ) ( pxRingBuffer + 1 );
+		pxRingBuffer->usHead = 0;
+		pxRingBuffer->usTail = 0;
+		pxRingBuffer->usReserved = 0;
+		pxRingBuffer->usMask = usSize - 1;
+		pxRingBuffer->ePolicy = ePolicy;
+		pxRingBuffer->usRejected = 0;
+		pxRingBuffer->usOverwritten = 0;
+	}
 
 	/* return handle */
 	return pxRingBuffer;
 }
 
-UBaseType_t xRingBufferEnqueue( RingBufferHandle_t xRingBuffer, uint8_t ucData )
+void vRingBufferDelete( RingBufferHandle_t xRingBuffer )
 {
-	RingBuffer_t *pxRingBuffer = ( RingBuffer_t *) xRingBuffer;
+	vPortFree( xRingBuffer );
+}
 
-	/* store item at head location */
-	*pxRingBuffer->pucHead = ucData;
+uint16_t usRingBufferCount( RingBufferHandle_t xRingBuffer )
+{
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+	uint16_t usCount = pxRingBuffer->usHead - pxRingBuffer->usTail;
 
-	/* wrap head pointer if end of buffer is reached, or just increment it */
-	if( pxRingBuffer->pucHead == pxRingBuffer->pucEnd )
+	/* with eRingBufferOverwrite the head may have run ahead of the tail by more
+	 * than the buffer holds; only the newest bytes are still there */
+	if( usCount > pxRingBuffer->usMask )
 	{
-		pxRingBuffer->pucHead = pxRingBuffer->pucBuffer;
+		usCount = pxRingBuffer->usMask + 1;
+	}
+
+	return usCount;
+}
+
+uint16_t usRingBufferWriteIndex( RingBufferHandle_t xRingBuffer )
+{
+	return ( ( RingBuffer_t * ) xRingBuffer )->usHead;
+}
+
+uint16_t usRingBufferReadIndex( RingBufferHandle_t xRingBuffer )
+{
+	return ( ( RingBuffer_t * ) xRingBuffer )->usTail;
+}
+
+uint16_t usRingBufferFree( RingBufferHandle_t xRingBuffer )
+{
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+
+	return ( pxRingBuffer->usMask + 1 ) - usRingBufferCount( xRingBuffer );
+}
+
+uint16_t usRingBufferWrite( RingBufferHandle_t xRingBuffer, const uint8_t *pucData, uint16_t usLength )
+{
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+	uint16_t usHead = pxRingBuffer->usHead;
+	uint16_t usSize = pxRingBuffer->usMask + 1;
+	uint16_t usDistance = usHead - pxRingBuffer->usTail;
+	uint16_t usStored = usLength;
+
+	if( pxRingBuffer->ePolicy == eRingBufferReject )
+	{
+		/* store what fits */
+		if( usStored > usSize - usDistance )
+		{
+			usStored = usSize - usDistance;
+		}
+	}
+	else if( ( uint32_t ) usDistance + usLength > ringbufferMAX_DISTANCE )
+	{
+		/* consumer is so far behind the indexes would lap it */
+		usStored = ( uint16_t ) ( ringbufferMAX_DISTANCE - usDistance );
+	}
+
+	pxRingBuffer->usRejected += usLength - usStored;
+
+	if( pxRingBuffer->ePolicy == eRingBufferOverwrite )
+	{
+		/* tell the consumer how far this write reaches before touching memory */
+		pxRingBuffer->usReserved = usHead + usStored;
+
+		/* only the last usSize bytes survive, skip the rest */
+		if( usStored > usSize )
+		{
+			prvCopyIn( pxRingBuffer, usHead + usStored - usSize, pucData + usStored - usSize, usSize );
+		}
+		else
+		{
+			prvCopyIn( pxRingBuffer, usHead, pucData, usStored );
+		}
 	}
 	else
 	{
-		pxRingBuffer->pucHead++;
+		prvCopyIn( pxRingBuffer, usHead, pucData, usStored );
 	}
 
-	/* increment number of items in queue */
-	if( ( pxRingBuffer->ucCount + 1) < pxRingBuffer->ucMaxCount )
+	/* publish the data to the consumer */
+	pxRingBuffer->usHead = usHead + usStored;
+
+	return usStored;
+}
+
+uint16_t usRingBufferRead( RingBufferHandle_t xRingBuffer, uint8_t *pucData, uint16_t usLength )
+{
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+	uint16_t usTail = pxRingBuffer->usTail;
+	uint16_t usCount = pxRingBuffer->usHead - usTail;
+	uint16_t usLost;
+
+	if( pxRingBuffer->ePolicy == eRingBufferOverwrite )
 	{
-		pxRingBuffer->ucCount++;
+		/* skip bytes the producer has already overwritten */
+		usLost = prvOverwrittenFrom( pxRingBuffer, usTail );
+
+		if( usLost > usCount )
+		{
+			usLost = usCount;
+		}
+
+		usTail += usLost;
+		usCount -= usLost;
+		pxRingBuffer->usOverwritten += usLost;
 	}
 
+	if( usLength > usCount )
+	{
+		usLength = usCount;
+	}
+
+	prvCopyOut( pxRingBuffer, usTail, pucData, usLength );
+
+	if( pxRingBuffer->ePolicy == eRingBufferOverwrite )
+	{
+		/* discard whatever the producer started to overwrite during the copy */
+		usLost = prvOverwrittenFrom( pxRingBuffer, usTail );
+
+		if( usLost > usLength )
+		{
+			usLost = usLength;
+		}
+
+		if( usLost > 0 )
+		{
+			memmove( pucData, pucData + usLost, usLength - usLost );
+			usTail += usLost;
+			usLength -= usLost;
+			pxRingBuffer->usOverwritten += usLost;
+		}
+	}
+
+	/* give the space back to the producer */
+	pxRingBuffer->usTail = usTail + usLength;
+
+	return usLength;
+}
+
+UBaseType_t xRingBufferEnqueue( RingBufferHandle_t xRingBuffer, uint8_t ucData )
+{
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+	uint16_t usHead = pxRingBuffer->usHead;
+
+	if( pxRingBuffer->ePolicy == eRingBufferOverwrite )
+	{
+		return ( usRingBufferWrite( xRingBuffer, &ucData, 1 ) == 1 ) ? pdPASS : pdFAIL;
+	}
+
+	if( ( uint16_t ) ( usHead - pxRingBuffer->usTail ) > pxRingBuffer->usMask )
+	{
+		/* if buffer is full, reject */
+		pxRingBuffer->usRejected++;
+		return pdFAIL;
+	}
+
+	/* store item at head location, then publish it */
+	pxRingBuffer->pucBuffer[ usHead & pxRingBuffer->usMask ] = ucData;
+	pxRingBuffer->usHead = usHead + 1;
+
 	return pdPASS;
 }
 
 UBaseType_t xRingBufferDequeue( RingBufferHandle_t xRingBuffer, uint8_t *pucData )
 {
-	RingBuffer_t *pxRingBuffer = ( RingBuffer_t *) xRingBuffer;
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+	uint16_t usTail = pxRingBuffer->usTail;
 
-	if( ( pxRingBuffer->pucHead == pxRingBuffer->pucTail ) && ( pxRingBuffer->ucCount == 0 ) )
+	if( pxRingBuffer->ePolicy == eRingBufferOverwrite )
+	{
+		return ( usRingBufferRead( xRingBuffer, pucData, 1 ) == 1 ) ? pdPASS : pdFAIL;
+	}
+
+	if( pxRingBuffer->usHead == usTail )
 	{
 		/* if buffer is empty, return pdFAIL */
 		return pdFAIL;
 	}
+
+	/* get data from tail location, then free it */
+	*pucData = pxRingBuffer->pucBuffer[ usTail & pxRingBuffer->usMask ];
+	pxRingBuffer->usTail = usTail + 1;
+
+	return pdPASS;
+}
+
+uint16_t usRingBufferWriteSpan( RingBufferHandle_t xRingBuffer, uint8_t **ppucSpan )
+{
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+	uint16_t usHead = pxRingBuffer->usHead;
+	uint16_t usOffset = usHead & pxRingBuffer->usMask;
+	uint16_t usSpan = ( pxRingBuffer->usMask + 1 ) - usOffset;
+	uint16_t usDistance = usHead - pxRingBuffer->usTail;
+
+	if( pxRingBuffer->ePolicy == eRingBufferReject )
+	{
+		/* span ends at the tail or at the end of buffer memory */
+		if( usSpan > ( pxRingBuffer->usMask + 1 ) - usDistance )
+		{
+			usSpan = ( pxRingBuffer->usMask + 1 ) - usDistance;
+		}
+	}
 	else
 	{
-		/* if there is data, get data from tail location */
-		*pucData = *pxRingBuffer->pucTail;
+		if( ( uint32_t ) usDistance + usSpan > ringbufferMAX_DISTANCE )
+		{
+			usSpan = ( uint16_t ) ( ringbufferMAX_DISTANCE - usDistance );
+		}
+
+		/* the span may be written at any time from now on */
+		pxRingBuffer->usReserved = usHead + usSpan;
+	}
+
+	*ppucSpan = pxRingBuffer->pucBuffer + usOffset;
+
+	return usSpan;
+}
+
+void vRingBufferCommit( RingBufferHandle_t xRingBuffer, uint16_t usLength )
+{
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+	uint16_t usHead = pxRingBuffer->usHead + usLength;
+
+	pxRingBuffer->usHead = usHead;
+
+	if( pxRingBuffer->ePolicy == eRingBufferOverwrite )
+	{
+		/* release the unused part of the span */
+		pxRingBuffer->usReserved = usHead;
+	}
+}
+
+uint16_t usRingBufferReadSpan( RingBufferHandle_t xRingBuffer, uint8_t **ppucSpan )
+{
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+	uint16_t usTail = pxRingBuffer->usTail;
+	uint16_t usCount = pxRingBuffer->usHead - usTail;
+	uint16_t usLost, usSpan;
+
+	if( pxRingBuffer->ePolicy == eRingBufferOverwrite )
+	{
+		/* skip bytes the producer has already overwritten */
+		usLost = prvOverwrittenFrom( pxRingBuffer, usTail );
 
-		/* wrap tail pointer if at end of buffer, or just increment it */
-		if( pxRingBuffer->pucTail == pxRingBuffer->pucEnd )
+		if( usLost > usCount )
 		{
-			pxRingBuffer->pucTail = pxRingBuffer->pucBuffer;
+			usLost = usCount;
 		}
-		else
+
+		if( usLost > 0 )
 		{
-			pxRingBuffer->pucTail++;
+			usTail += usLost;
+			usCount -= usLost;
+			pxRingBuffer->usOverwritten += usLost;
+			pxRingBuffer->usTail = usTail;
 		}
+	}
+
+	/* span ends at the head or at the end of buffer memory */
+	usSpan = ( pxRingBuffer->usMask + 1 ) - ( usTail & pxRingBuffer->usMask );
+
+	if( usSpan > usCount )
+	{
+		usSpan = usCount;
+	}
+
+	*ppucSpan = pxRingBuffer->pucBuffer + ( usTail & pxRingBuffer->usMask );
+
+	return usSpan;
+}
 
-		/* decrement item count */
-		if( pxRingBuffer->ucCount > 0 )
+UBaseType_t xRingBufferConsume( RingBufferHandle_t xRingBuffer, uint16_t usLength )
+{
+	RingBuffer_t *pxRingBuffer = ( RingBuffer_t * ) xRingBuffer;
+	uint16_t usTail = pxRingBuffer->usTail;
+	uint16_t usLost = 0;
+
+	if( pxRingBuffer->ePolicy == eRingBufferOverwrite )
+	{
+		/* was any of the span overwritten while it was in use? */
+		usLost = prvOverwrittenFrom( pxRingBuffer, usTail );
+
+		if( usLost > ( uint16_t ) ( pxRingBuffer->usHead - usTail ) )
 		{
-			pxRingBuffer->ucCount--;
+			usLost = pxRingBuffer->usHead - usTail;
+		}
+
+		if( usLost > usLength )
+		{
+			/* overwriting went past the span, skip to the oldest intact byte */
+			pxRingBuffer->usOverwritten += usLost - usLength;
+			usLength = usLost;
 		}
 	}
 
-	return pdPASS;
+	/* give the space back to the producer */
+	pxRingBuffer->usTail = usTail + usLength;
+
+	return ( usLost == 0 ) ? pdPASS : pdFAIL;
 }
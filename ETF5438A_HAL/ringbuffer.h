@@ -4,8 +4,26 @@
  * @date 2016
  * @brief Ringbuffer implementation
  *
- * Ringbuffer implementation which allows Byte sized elements to be stored and
- * retrieved.
+ * Single-producer/single-consumer ringbuffer of bytes.
+ *
+ * Capacity is a power of two up to 32768 bytes. Head and tail are free running
+ * 16-bit indexes masked into the buffer, so all of the buffer is usable and the
+ * fill level is simply head - tail. Only the producer writes the head and only
+ * the consumer writes the tail; on the MSP430 each is read and written with a
+ * single instruction, so one task or ISR may produce while another consumes
+ * without any critical section.
+ *
+ * Bytes can be moved one at a time, in bulk with two memcpy() calls at most, or
+ * in place through contiguous spans: the producer asks for the free span at the
+ * head, fills it and commits, the consumer asks for the filled span at the tail,
+ * uses it and consumes.
+ *
+ * What happens when the buffer is full is chosen at creation, see
+ * RingBufferPolicy_t. With eRingBufferOverwrite the producer still never writes
+ * the tail: it lets the head run ahead and the consumer skips whatever was
+ * overwritten. Before writing, the producer publishes how far it is about to
+ * write, so after copying bytes out the consumer can tell which of them may
+ * have been overwritten meanwhile and discards those.
  */
 
 #ifndef RINGBUFFER_H_
@@ -14,14 +32,23 @@
 /* Standard includes. */
 #include <stdio.h>
 
+/** @brief Behaviour of a full Ringbuffer */
+typedef enum
+{
+	eRingBufferReject,		/**< bytes that do not fit are rejected; lock-free in both directions */
+	eRingBufferOverwrite	/**< the oldest bytes are dropped to make room; the producer never waits */
+} RingBufferPolicy_t;
+
 /** @brief Ringbuffer structure */
 typedef struct {
-	uint8_t *pucBuffer; /**< pointer to buffer memory */
-	uint8_t *pucHead;   /**< pointer to current buffer head */
-	uint8_t *pucTail;   /**< pointer to current buffer tail */
-	uint8_t *pucEnd;    /**< pointer to end of buffer memory */
-	uint8_t ucCount;    /**< current count of items in buffer */
-	uint8_t ucMaxCount; /**< max number of items in buffer */
+	uint8_t *pucBuffer;				/**< pointer to buffer memory */
+	volatile uint16_t usHead;		/**< free running write index, written by the producer only */
+	volatile uint16_t usTail;		/**< free running read index, written by the consumer only */
+	volatile uint16_t usReserved;	/**< end of the bytes the producer is writing, eRingBufferOverwrite only */
+	uint16_t usMask;				/**< size of buffer memory minus one */
+	RingBufferPolicy_t ePolicy;		/**< behaviour when full */
+	volatile uint16_t usRejected;	/**< bytes rejected by the producer */
+	volatile uint16_t usOverwritten;	/**< overwritten bytes skipped by the consumer */
 } RingBuffer_t;
 
 /** @brief Ringbuffer handle */
@@ -29,23 +56,33 @@ typedef void * RingBufferHandle_t;
 
 /**
  * @brief Initialize Ringbuffer
- * @param ucSize number of elements in buffer
- * @return handle of created Ringbuffer
+ * @param usSize number of bytes in buffer, a power of two from 2 to 32768
+ * @param ePolicy behaviour when the buffer is full
+ * @return handle of created Ringbuffer, NULL if @p usSize is not valid or memory
+ * could not be allocated
+ *
+ * Create and initialize Ringbuffer. Structure and buffer memory are allocated
+ * together with one call to pvPortMalloc.
+ */
+extern RingBufferHandle_t xRingBufferCreate( uint16_t usSize, RingBufferPolicy_t ePolicy );
+
+/**
+ * @brief Delete Ringbuffer
+ * @param xRingBuffer Handle of Ringbuffer to delete
  *
- * Create and initialize Ringbuffer. Function allocates memory needed for buffer according to
- * @p ucSize and initializes all pointers. Returns handle of created Ringbuffer.
+ * Frees the memory of xRingBufferCreate. Neither side may use the buffer
+ * afterwards.
  */
-extern RingBufferHandle_t xRingBufferCreate( uint8_t ucSize );
+extern void vRingBufferDelete( RingBufferHandle_t xRingBuffer );
 
 /**
  * @brief Enqueue data to Ringbuffer
  * @param xRingBuffer Handle of Ringbuffer where to enqueue
  * @param ucData Data to be enqueued
- * @return pdPASS
- *
- * Enqueue one data item to Ringbuffer. If buffer is full first written item will be overwritten.
+ * @return pdPASS if stored, pdFAIL if the buffer is full and rejects
  *
- * TODO: Add handling if buffer is full
+ * Enqueue one byte. With eRingBufferOverwrite the byte is always stored and
+ * the oldest byte is dropped if the buffer was full. Producer side only.
  */
 extern UBaseType_t xRingBufferEnqueue( RingBufferHandle_t xRingBuffer, uint8_t ucData );
 
@@ -55,9 +92,101 @@ extern UBaseType_t xRingBufferEnqueue( RingBufferHandle_t xRingBuffer, uint8_t u
  * @param pucData Pointer to buffer where dequeued data will be placed
  * @return pdPASS if successful, pdFAIL if not
  *
- * Dequeue one data item from Ringbuffer. If buffer is empty, function will return
- * pdFAIL.
+ * Dequeue one byte. If buffer is empty, function will return pdFAIL.
+ * Consumer side only.
  */
 extern UBaseType_t xRingBufferDequeue( RingBufferHandle_t xRingBuffer, uint8_t *pucData );
 
+/**
+ * @brief Enqueue a block of bytes
+ * @param xRingBuffer Handle of Ringbuffer where to enqueue
+ * @param pucData Bytes to be enqueued
+ * @param usLength Number of bytes
+ * @return number of bytes stored
+ *
+ * With eRingBufferReject as many bytes as fit are stored and the rest are
+ * counted in usRejected. With eRingBufferOverwrite all bytes are stored; if there
+ * are more than the buffer holds only the last ones are kept. The only exception
+ * is a consumer so far behind that the 16-bit indexes would lap it, then bytes
+ * are rejected until it catches up. Producer side only.
+ */
+extern uint16_t usRingBufferWrite( RingBufferHandle_t xRingBuffer, const uint8_t *pucData, uint16_t usLength );
+
+/**
+ * @brief Dequeue a block of bytes
+ * @param xRingBuffer Handle of Ringbuffer from which to dequeue
+ * @param pucData Buffer where dequeued bytes will be placed
+ * @param usLength Size of @p pucData
+ * @return number of bytes dequeued
+ *
+ * Consumer side only.
+ */
+extern uint16_t usRingBufferRead( RingBufferHandle_t xRingBuffer, uint8_t *pucData, uint16_t usLength );
+
+/**
+ * @brief Get the contiguous free span at the head
+ * @param xRingBuffer Handle of Ringbuffer
+ * @param ppucSpan Set to the first free byte
+ * @return number of bytes that can be written at @p *ppucSpan
+ *
+ * The span ends at the end of the buffer memory, so a second call after
+ * vRingBufferCommit() may return the rest. With eRingBufferOverwrite the span
+ * may cover unread bytes, which are dropped on commit. Producer side only.
+ */
+extern uint16_t usRingBufferWriteSpan( RingBufferHandle_t xRingBuffer, uint8_t **ppucSpan );
+
+/**
+ * @brief Publish bytes written into the span from usRingBufferWriteSpan()
+ * @param xRingBuffer Handle of Ringbuffer
+ * @param usLength Number of bytes written, at most the span length
+ */
+extern void vRingBufferCommit( RingBufferHandle_t xRingBuffer, uint16_t usLength );
+
+/**
+ * @brief Get the contiguous filled span at the tail
+ * @param xRingBuffer Handle of Ringbuffer
+ * @param ppucSpan Set to the oldest byte
+ * @return number of bytes that can be read at @p *ppucSpan
+ *
+ * The span ends at the end of the buffer memory, so a second call after
+ * xRingBufferConsume() may return the rest. Consumer side only.
+ */
+extern uint16_t usRingBufferReadSpan( RingBufferHandle_t xRingBuffer, uint8_t **ppucSpan );
+
+/**
+ * @brief Release bytes used from the span from usRingBufferReadSpan()
+ * @param xRingBuffer Handle of Ringbuffer
+ * @param usLength Number of bytes used, at most the span length
+ * @return pdPASS, or pdFAIL if with eRingBufferOverwrite the producer
+ * overwrote part of the span while it was in use
+ */
+extern UBaseType_t xRingBufferConsume( RingBufferHandle_t xRingBuffer, uint16_t usLength );
+
+/**
+ * @brief Number of bytes waiting to be dequeued
+ * @param xRingBuffer Handle of Ringbuffer
+ */
+extern uint16_t usRingBufferCount( RingBufferHandle_t xRingBuffer );
+
+/**
+ * @brief Number of bytes that can be enqueued without rejecting or overwriting
+ * @param xRingBuffer Handle of Ringbuffer
+ */
+extern uint16_t usRingBufferFree( RingBufferHandle_t xRingBuffer );
+
+/**
+ * @brief Free running index of the next byte to be enqueued
+ * @param xRingBuffer Handle of Ringbuffer
+ *
+ * Lets the producer mark a position in the stream of bytes; the consumer has
+ * dequeued every byte before the mark once usRingBufferReadIndex() reaches it.
+ */
+extern uint16_t usRingBufferWriteIndex( RingBufferHandle_t xRingBuffer );
+
+/**
+ * @brief Free running index of the next byte to be dequeued
+ * @param xRingBuffer Handle of Ringbuffer
+ */
+extern uint16_t usRingBufferReadIndex( RingBufferHandle_t xRingBuffer );
+
 #endif /* RINGBUFFER_H_ */
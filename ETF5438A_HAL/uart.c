@@ -4,169 +4,1179 @@
  * @date 2016
  * @brief OS-aware UART communication
  *
- * Implementation of UART communication using FreeRTOS.
- * UART Task is created which handles all UART data communication.
- * Other tasks communicate with UART Task using "UART Queue".
+ * Implementation of UART communication using FreeRTOS on USCI_A0 to USCI_A3.
+ * Every open port has its own state: tasks either copy bytes into its TX
+ * Ringbuffer, or lend a buffer that is queued on its "UART Queue" and handed
+ * back once it has been sent. Received bytes are placed into its RX stream
+ * buffer, which wakes the one reader task. Transmission runs entirely in interrupts: on USCI_A0
+ * and USCI_A1 longer runs of bytes are transmitted by DMA channel 0 and 1
+ * straight from the Ringbuffer or the lent buffer, with one interrupt per run
+ * instead of one per byte. USCI_A2 and USCI_A3 have no DMA trigger and send
+ * one byte per TX interrupt.
+ * A sender that finds no room in the TX Ringbuffer blocks on a semaphore the
+ * TX path gives once enough has been sent. With XON/XOFF flow control the RX
+ * interrupt picks XON and XOFF out of the received bytes, and a pending XON or
+ * XOFF of our own is sent ahead of everything else.
+ * The bit clock settings are computed from the SMCLK frequency rather than
+ * taken from a table, so they follow the clock the system actually runs at.
  */
 
 /* Standard includes. */
+#include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "semphr.h"
 #include "uart.h"
 #include "ringbuffer.h"
+#include "stream_buffer.h"
 
 /* Hardware includes. */
 #include "msp430.h"
 #include "hal_ETF5438A.h"
 
-/** @brief UART message enum */
-typedef enum
+/**
+ * @brief Shortest Ringbuffer span sent by DMA
+ *
+ * Shorter spans are sent one byte per TX interrupt, where setting up DMA would
+ * cost more than it saves.
+ */
+#define uartDMA_MIN_LENGTH			( 8 )
+
+/** @brief Fewest BRCLK cycles per bit in oversampling mode */
+#define uartOS16_MIN_CYCLES			( 16 )
+
+/** @brief Fewest BRCLK cycles per bit in low-frequency mode */
+#define uartLF_MIN_CYCLES			( 3 )
+
+/** @brief Fill level of the RX stream buffer, in quarters, that sends XOFF */
+#define uartXOFF_QUARTERS			( 3 )
+
+/** @brief Fill level of the RX stream buffer, in quarters, that sends XON again */
+#define uartXON_QUARTERS			( 1 )
+
+/** @brief Port has no DMA channel */
+#define uartNO_DMA					( 0xFF )
+
+/** @brief USCI_Ax registers in UART mode, the same layout at every base address */
+typedef struct
+{
+	volatile uint8_t ucCTL1;		/**< 0x00 UCAxCTL1 */
+	volatile uint8_t ucCTL0;		/**< 0x01 UCAxCTL0 */
+	uint8_t ucReserved0[ 4 ];
+	volatile uint16_t usBRW;		/**< 0x06 UCAxBRW */
+	volatile uint8_t ucMCTL;		/**< 0x08 UCAxMCTL */
+	uint8_t ucReserved1;
+	volatile uint8_t ucSTAT;		/**< 0x0A UCAxSTAT */
+	uint8_t ucReserved2;
+	volatile uint8_t ucRXBUF;		/**< 0x0C UCAxRXBUF */
+	uint8_t ucReserved3;
+	volatile uint8_t ucTXBUF;		/**< 0x0E UCAxTXBUF */
+	uint8_t ucReserved4;
+	volatile uint8_t ucABCTL;		/**< 0x10 UCAxABCTL */
+	uint8_t ucReserved5;
+	volatile uint16_t usIRCTL;		/**< 0x12 UCAxIRCTL */
+	uint8_t ucReserved6[ 8 ];
+	volatile uint8_t ucIE;			/**< 0x1C UCAxIE */
+	volatile uint8_t ucIFG;			/**< 0x1D UCAxIFG */
+	volatile uint16_t usIV;			/**< 0x1E UCAxIV */
+} UsciA_t;
+
+/** @brief DMA channel registers, the same layout for every channel */
+typedef struct
+{
+	volatile uint16_t usCTL;		/**< 0x00 DMAxCTL */
+	volatile uint16_t usSA[ 2 ];	/**< 0x02 DMAxSA, 20-bit */
+	volatile uint16_t usDA[ 2 ];	/**< 0x06 DMAxDA, 20-bit */
+	volatile uint16_t usSZ;			/**< 0x0A DMAxSZ */
+} DmaChannel_t;
+
+/** @brief Hardware of a port */
+typedef struct
 {
-	UART_MSG_STR,	/**< message contains string to be sent to PC */
-	UART_MSG_CMD,	/**< message contains command; not used at the moment */
-	UART_MSG_DAT	/**< message contains data; not used at the moment */
-} UartMsgType_t;
+	UsciA_t *pxUsci;				/**< USCI_Ax registers */
+	volatile uint8_t *pucPinSelect;	/**< PxSEL of the TXD and RXD pins */
+	uint8_t ucPins;					/**< TXD and RXD bits in PxSEL */
+	uint8_t ucDmaChannel;			/**< DMA channel sending for the port, or uartNO_DMA */
+	uint8_t ucDmaTrigger;			/**< DMA trigger number of UCAxTXIFG */
+	DmaChannel_t *pxDma;			/**< registers of the DMA channel, or NULL */
+} UartHardware_t;
 
-/** @brief UART message structure */
+/** @brief Borrowed buffer waiting for, or in, transmission */
 typedef struct
 {
-	UartMsgType_t eMsgType;	/**< message type enum */
-	uint8_t *pucMsgData;	/**< message data buffer */
-} UARTMessage_t;
+	const uint8_t *pucData;					/**< first byte of the buffer */
+	uint16_t usLength;						/**< number of bytes to send */
+	uint16_t usMarker;						/**< Ringbuffer write index when queued; bytes before it are sent first */
+	UartTxCompleteCallback_t pxCallback;	/**< called when the buffer is released, or NULL */
+	void *pvContext;						/**< passed to pxCallback */
+	TaskHandle_t xTaskToNotify;				/**< notified when the buffer is released if there is no callback */
+} UartTxBuffer_t;
+
+/** @brief State of an open port */
+typedef struct
+{
+	const UartHardware_t *pxHardware;	/**< hardware of the port, NULL while the port is closed */
+	RingBufferHandle_t xTxBuffer;		/**< UART TX Ringbuffer handle */
+	uint16_t usTxBufferSize;			/**< size of xTxBuffer */
+	uint32_t ulBaudRate;				/**< requested baud rate */
+	QueueHandle_t xUARTQueue;			/**< UART Queue handle, holds borrowed buffers in order, or NULL */
+	SemaphoreHandle_t xTxMutex;			/**< serializes senders, the Ringbuffer has a single producer */
+	SemaphoreHandle_t xTxSpace;			/**< given by the TX path when usTxWanted bytes are free */
+	volatile uint16_t usTxWanted;		/**< free bytes the waiting sender needs, 0 if none waits */
+	StreamBufferHandle_t xRxBuffer;		/**< UART RX stream buffer, filled by the RX interrupt, or NULL */
+	uint16_t usRxBufferSize;			/**< size of xRxBuffer */
+	UartTxBuffer_t xActiveBuffer;		/**< borrowed buffer being sent */
+	volatile BaseType_t xBufferActive;	/**< pdTRUE while xActiveBuffer rather than a Ringbuffer span is sent */
+	const uint8_t *pucCursor;			/**< next byte of xActiveBuffer, ports without DMA */
+	uint16_t usRemaining;				/**< bytes of xActiveBuffer left to send, ports without DMA */
+	volatile uint16_t usDmaLength;		/**< length of the span or buffer DMA is sending, 0 when DMA is idle */
+	UartFlowControl_t eFlowControl;		/**< flow control */
+	volatile BaseType_t xTxStopped;		/**< pdTRUE from a received XOFF until XON */
+	volatile BaseType_t xRxStopped;		/**< pdTRUE from our XOFF until our XON */
+	volatile uint8_t ucTxControl;		/**< XON or XOFF to send before anything else, 0 if none */
+	volatile BaseType_t xClockChanging;	/**< pdTRUE while the port is held for a change of SMCLK */
+	volatile uint16_t usTxDropped;		/**< see UartStats_t */
+	volatile uint16_t usRxDropped;		/**< see UartStats_t */
+	volatile uint16_t usRxOverrun;		/**< see UartStats_t */
+} UartPort_t;
+
+/** @brief Hardware of every port; only UCA0TXIFG (17) and UCA1TXIFG (21) can trigger DMA */
+static const UartHardware_t xUartHardware[ eUartPortCount ] =
+{
+	{ ( UsciA_t * ) &UCA0CTLW0, &P3SEL, BIT4 | BIT5, 0, 17, ( DmaChannel_t * ) &DMA0CTL },
+	{ ( UsciA_t * ) &UCA1CTLW0, &P5SEL, BIT6 | BIT7, 1, 21, ( DmaChannel_t * ) &DMA1CTL },
+	{ ( UsciA_t * ) &UCA2CTLW0, &P9SEL, BIT4 | BIT5, uartNO_DMA, 0, NULL },
+	{ ( UsciA_t * ) &UCA3CTLW0, &P10SEL, BIT4 | BIT5, uartNO_DMA, 0, NULL }
+};
+
+/** @brief State of every port */
+static UartPort_t xUartPorts[ eUartPortCount ];
+
+/**
+ * @brief Restart transmission if it is idle
+ *
+ * Bytes are sent from ISR context only: either the TX interrupt is enabled, or
+ * DMA is sending and will enable the TX interrupt when done. If neither is the
+ * case transmission is idle and TXBUF is empty. Reading UCAxIV in the last TX
+ * interrupt cleared UCTXIFG, so it is set again to restart transmission as
+ * soon as the TX interrupt is enabled. Called from ISR context or in a
+ * critical section, as the DMA interrupt moves from one state to the other.
+ * While SMCLK changes nothing is started, not even an XON or XOFF; the
+ * pending one is sent by vUartClockChanged() at the new bit clock.
+ */
+static void prvResumeTransmission( UartPort_t *pxPort )
+{
+	UsciA_t *pxUsci = pxPort->pxHardware->pxUsci;
+
+	if( !( pxUsci->ucIE & UCTXIE ) && ( pxPort->usDmaLength == 0 ) && ( pxPort->xClockChanging == pdFALSE ) )
+	{
+		pxUsci->ucIFG |= UCTXIFG;
+		pxUsci->ucIE |= UCTXIE;
+	}
+}
+
+/**
+ * @brief Start transmission if it is not in progress
+ */
+static void prvStartTransmission( UartPort_t *pxPort )
+{
+	taskENTER_CRITICAL();
+	{
+		prvResumeTransmission( pxPort );
+	}
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Wake the sender waiting for room once there is enough
+ * @param pxHigherPriorityTaskWoken set to pdTRUE if the sender should run now
+ *
+ * Called from ISR context after bytes have been consumed from the Ringbuffer.
+ */
+static void prvCheckRoomFromISR( UartPort_t *pxPort, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	if( ( pxPort->usTxWanted != 0 ) && ( usRingBufferFree( pxPort->xTxBuffer ) >= pxPort->usTxWanted ) )
+	{
+		pxPort->usTxWanted = 0;
+		xSemaphoreGiveFromISR( pxPort->xTxSpace, pxHigherPriorityTaskWoken );
+	}
+}
+
+/**
+ * @brief Send bytes by DMA
+ * @param pucData first byte, at least two bytes are sent
+ * @param usLength number of bytes
+ *
+ * The port's DMA channel is triggered by UCAxTXIFG and so writes each byte as
+ * soon as TXBUF is free. The trigger is edge sensitive, so the first byte is
+ * written here after DMA is enabled and the rising edge of UCAxTXIFG after it
+ * starts the transfer of the rest. Called from the TX interrupt when TXBUF is
+ * empty.
+ */
+static void prvStartDma( UartPort_t *pxPort, const uint8_t *pucData, uint16_t usLength )
+{
+	UsciA_t *pxUsci = pxPort->pxHardware->pxUsci;
+	DmaChannel_t *pxDma = pxPort->pxHardware->pxDma;
+
+	/* the TX interrupt stays off until DMA is done */
+	pxUsci->ucIE &= ~UCTXIE;
+	pxPort->usDmaLength = usLength;
+
+	__data16_write_addr( ( unsigned short ) pxDma->usSA, ( unsigned long ) ( pucData + 1 ) );
+	__data16_write_addr( ( unsigned short ) pxDma->usDA, ( unsigned long ) &pxUsci->ucTXBUF );
+	pxDma->usSZ = usLength - 1;
+	pxDma->usCTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0 | DMASBDB | DMAIE | DMAEN;
+
+	pxUsci->ucTXBUF = *pucData;
+}
+
+/**
+ * @brief Hand a borrowed buffer back to its owner
+ * @param pxHigherPriorityTaskWoken set to pdTRUE if the owner should run now
+ */
+static void prvReleaseBuffer( const UartTxBuffer_t *pxBuffer, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	if( pxBuffer->pxCallback != NULL )
+	{
+		pxBuffer->pxCallback( pxBuffer->pucData, pxBuffer->pvContext, pxHigherPriorityTaskWoken );
+	}
+	else if( pxBuffer->xTaskToNotify != NULL )
+	{
+		vTaskNotifyGiveFromISR( pxBuffer->xTaskToNotify, pxHigherPriorityTaskWoken );
+	}
+}
+
+/**
+ * @brief Send the next bytes
+ * @param pxHigherPriorityTaskWoken set to pdTRUE if a woken task should run now
+ *
+ * Called from the TX interrupt when TXBUF is empty. Copied-in bytes are sent
+ * from the Ringbuffer up to the mark of the oldest borrowed buffer, then that
+ * buffer is sent, so both kinds go out in the order they were queued. On a port
+ * with DMA a span or buffer long enough is sent by DMA straight from where it
+ * is, and is only released by vDMAISR once the transfer is complete. Without
+ * DMA a borrowed buffer is sent one byte per interrupt, and released with its
+ * last byte. A pending XON or XOFF goes first; after a received XOFF nothing
+ * else is sent, except what DMA was already sending.
+ */
+static void prvTransmitNext( UartPort_t *pxPort, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	UsciA_t *pxUsci = pxPort->pxHardware->pxUsci;
+	BaseType_t xHasDma = ( pxPort->pxHardware->pxDma != NULL );
+	UartTxBuffer_t xNext;
+	uint8_t *pucSpan;
+	uint16_t usSpan;
+	uint16_t usTail;
+	BaseType_t xPending = pdFALSE;
+
+	if( pxPort->ucTxControl != 0 )
+	{
+		pxUsci->ucTXBUF = pxPort->ucTxControl;
+		pxPort->ucTxControl = 0;
+		return;
+	}
+
+	if( pxPort->xTxStopped != pdFALSE )
+	{
+		/* XON enables the interrupt again */
+		pxUsci->ucIE &= ~UCTXIE;
+		return;
+	}
+
+	/* a borrowed buffer sent one byte at a time; with DMA the TX interrupt is
+	 * off while a buffer is active */
+	if( pxPort->xBufferActive != pdFALSE )
+	{
+		pxUsci->ucTXBUF = *pxPort->pucCursor++;
+
+		if( --pxPort->usRemaining == 0 )
+		{
+			pxPort->xBufferActive = pdFALSE;
+			prvReleaseBuffer( &pxPort->xActiveBuffer, pxHigherPriorityTaskWoken );
+		}
+		return;
+	}
+
+	usTail = usRingBufferReadIndex( pxPort->xTxBuffer );
+
+	if( pxPort->xUARTQueue != NULL )
+	{
+		xPending = xQueuePeekFromISR( pxPort->xUARTQueue, &xNext );
+	}
+
+	if( ( xPending == pdTRUE ) && ( xNext.usMarker == usTail ) )
+	{
+		/* every byte queued before the buffer is sent, send the buffer */
+		xQueueReceiveFromISR( pxPort->xUARTQueue, &pxPort->xActiveBuffer, pxHigherPriorityTaskWoken );
+
+		if( pxPort->xActiveBuffer.usLength == 1 )
+		{
+			/* a single byte is copied into TXBUF, the buffer is free at once */
+			pxUsci->ucTXBUF = *pxPort->xActiveBuffer.pucData;
+			prvReleaseBuffer( &pxPort->xActiveBuffer, pxHigherPriorityTaskWoken );
+		}
+		else if( xHasDma != pdFALSE )
+		{
+			pxPort->xBufferActive = pdTRUE;
+			prvStartDma( pxPort, pxPort->xActiveBuffer.pucData, pxPort->xActiveBuffer.usLength );
+		}
+		else
+		{
+			pxPort->xBufferActive = pdTRUE;
+			pxPort->pucCursor = pxPort->xActiveBuffer.pucData + 1;
+			pxPort->usRemaining = pxPort->xActiveBuffer.usLength - 1;
+			pxUsci->ucTXBUF = *pxPort->xActiveBuffer.pucData;
+		}
+		return;
+	}
+
+	usSpan = usRingBufferReadSpan( pxPort->xTxBuffer, &pucSpan );
+
+	/* stop at the mark of the next borrowed buffer */
+	if( ( xPending == pdTRUE ) && ( usSpan > ( uint16_t ) ( xNext.usMarker - usTail ) ) )
+	{
+		usSpan = xNext.usMarker - usTail;
+	}
+
+	if( ( xHasDma != pdFALSE ) && ( usSpan >= uartDMA_MIN_LENGTH ) )
+	{
+		prvStartDma( pxPort, pucSpan, usSpan );
+	}
+	else if( usSpan > 0 )
+	{
+		pxUsci->ucTXBUF = *pucSpan;
+		xRingBufferConsume( pxPort->xTxBuffer, 1 );
+		prvCheckRoomFromISR( pxPort, pxHigherPriorityTaskWoken );
+	}
+	else
+	{
+		/* when there is no more data, disable interrupt */
+		pxUsci->ucIE &= ~UCTXIE;
+	}
+}
+
+/**
+ * @brief Wait for room in the TX Ringbuffer
+ * @param usWanted number of free bytes needed, at most the Ringbuffer size
+ * @return pdPASS once there is room, pdFAIL if the time ran out first
+ *
+ * Must be called holding xTxMutex, so there is only one waiter. The wish is
+ * published before the check, so room freed after the check always leaves
+ * the semaphore given; a give left over from an earlier wait only causes one
+ * more check.
+ */
+static BaseType_t prvWaitForRoom( UartPort_t *pxPort, uint16_t usWanted, TimeOut_t *pxTimeOut, TickType_t *pxBlockTime )
+{
+	BaseType_t xRet = pdPASS;
+
+	pxPort->usTxWanted = usWanted;
+
+	while( usRingBufferFree( pxPort->xTxBuffer ) < usWanted )
+	{
+		if( xTaskCheckForTimeOut( pxTimeOut, pxBlockTime ) != pdFALSE )
+		{
+			xRet = pdFAIL;
+			break;
+		}
 
-/** @brief UART Ringbuffer handle */
-static RingBufferHandle_t xStringBuffer;
-/** @brief UART Queue handle */
-static QueueHandle_t xUARTQueue;
+		( void ) xSemaphoreTake( pxPort->xTxSpace, *pxBlockTime );
+	}
+
+	pxPort->usTxWanted = 0;
+
+	return xRet;
+}
+
+/**
+ * @brief Count bytes a sender gave up on
+ *
+ * Senders that timed out on xTxMutex count their bytes as well as the one
+ * holding it, so the counter is changed in a critical section.
+ */
+static void prvCountTxDropped( UartPort_t *pxPort, uint16_t usBytes )
+{
+	taskENTER_CRITICAL();
+	pxPort->usTxDropped += usBytes;
+	taskEXIT_CRITICAL();
+}
 
 /**
- * @brief UART Task function
- * @param pvParameters not used
+ * @brief Copy bytes into the TX Ringbuffer
+ * @param xWhole pdTRUE to copy each chunk only once there is room for all of it
+ * @return number of bytes copied
  *
- * UART Task that handles communication with PC.
- * Blocks while waiting on queue messages.
- * When message is received, it is parsed and bytes are placed into
- * Ringbuffer.
- * If data is not currently being transmitted, initialize transmission.
+ * Must be called holding xTxMutex. Bytes are copied in chunks of at most the
+ * Ringbuffer size. With @p xWhole a message that fits is either queued whole
+ * or not at all; without it whatever room there is gets used, and the sender
+ * sleeps until a quarter of the Ringbuffer is free again rather than waking
+ * for every byte sent. Bytes not copied when the time runs out are counted
+ * as dropped.
  */
-static void prvTaskUART( void *pvParameters )
+static uint16_t prvCopyIn( UartPort_t *pxPort, const uint8_t *pucData, uint16_t usLength, BaseType_t xWhole, TimeOut_t *pxTimeOut, TickType_t *pxBlockTime )
 {
-	UARTMessage_t *pucRxMsg;
+	uint16_t usCopied = 0;
+	uint16_t usChunk;
+	uint16_t usFree;
+	uint16_t usWanted;
 
-	for( ;; )
+	while( usCopied < usLength )
 	{
-		/* block on reading message from queue */
-		if( xQueueReceive( xUARTQueue, &pucRxMsg, portMAX_DELAY ) == pdTRUE )
+		usChunk = usLength - usCopied;
+		if( usChunk > pxPort->usTxBufferSize )
+		{
+			usChunk = pxPort->usTxBufferSize;
+		}
+
+		usFree = usRingBufferFree( pxPort->xTxBuffer );
+
+		if( ( usFree >= usChunk ) || ( ( xWhole == pdFALSE ) && ( usFree > 0 ) ) )
 		{
-			/* if string message is received */
-			if( pucRxMsg->eMsgType == UART_MSG_STR )
+			if( usChunk > usFree )
 			{
-				/* enqueue data into ring buffer */
-				while( *pucRxMsg->pucMsgData != 0 )
-				{
-					xRingBufferEnqueue( xStringBuffer, *pucRxMsg->pucMsgData++ );
-				}
-
-				/* if transmission is not in progress, initiate transmission */
-				if( !( UCA0IE & UCTXIE ) )
-				{
-					uint8_t ucData;
-					xRingBufferDequeue( xStringBuffer, &ucData );
-					UCA0TXBUF = ucData;
-					UCA0IE |= UCTXIE;
-				}
+				usChunk = usFree;
 			}
+
+			usRingBufferWrite( pxPort->xTxBuffer, pucData + usCopied, usChunk );
+			usCopied += usChunk;
+
+			/* if transmission is not in progress, initiate transmission */
+			prvStartTransmission( pxPort );
+			continue;
 		}
-		else
+
+		usWanted = usChunk;
+		if( ( xWhole == pdFALSE ) && ( usWanted > ( pxPort->usTxBufferSize / 4 ) ) )
+		{
+			usWanted = pxPort->usTxBufferSize / 4;
+		}
+
+		if( prvWaitForRoom( pxPort, usWanted, pxTimeOut, pxBlockTime ) != pdPASS )
 		{
-			for( ;; );
+			break;
 		}
 	}
+
+	prvCountTxDropped( pxPort, usLength - usCopied );
+
+	return usCopied;
 }
 
-/** @brief Callback function handle */
-static ReceiveByteCallbackFunction_t prvReceiveByteCallback;
+/**
+ * @brief Wait until the port has sent everything queued
+ * @return pdPASS once transmission is idle, pdFAIL if the time ran out first
+ *
+ * Must be called holding xTxMutex, so nothing new is queued meanwhile. While
+ * stopped by XOFF the port keeps data queued with its interrupt off, so the
+ * Ringbuffer and UART queue are checked too. UCBUSY stays set until the last
+ * byte has left the shift register.
+ */
+static BaseType_t prvWaitIdle( UartPort_t *pxPort, TimeOut_t *pxTimeOut, TickType_t *pxBlockTime )
+{
+	UsciA_t *pxUsci = pxPort->pxHardware->pxUsci;
+
+	while( ( pxUsci->ucIE & UCTXIE ) || ( pxPort->usDmaLength != 0 ) || ( pxUsci->ucSTAT & UCBUSY ) ||
+		   ( usRingBufferCount( pxPort->xTxBuffer ) != 0 ) || ( pxPort->xBufferActive != pdFALSE ) ||
+		   ( ( pxPort->xUARTQueue != NULL ) && ( uxQueueMessagesWaiting( pxPort->xUARTQueue ) != 0 ) ) )
+	{
+		if( xTaskCheckForTimeOut( pxTimeOut, pxBlockTime ) != pdFALSE )
+		{
+			return pdFAIL;
+		}
+
+		vTaskDelay( 1 );
+	}
+
+	return pdPASS;
+}
 
-void vUartSetRxCallback( ReceiveByteCallbackFunction_t pvCallbackFunction )
+/**
+ * @brief Program the bit clock of a USCI_Ax module
+ *
+ * The module is held in software reset meanwhile, which clears its interrupt
+ * enables; the caller enables them again.
+ */
+static void prvSetBitClock( UsciA_t *pxUsci, const UartBaud_t *pxBaud )
 {
-	prvReceiveByteCallback = pvCallbackFunction;
+	pxUsci->ucCTL1 |= UCSWRST;							/* enter software reset */
+	pxUsci->ucCTL1 |= UCSSEL_2;							/* select SMCLK for BRCLK */
+	pxUsci->usBRW = pxBaud->usDivider;
+	pxUsci->ucMCTL = pxBaud->ucModulation;
+	pxUsci->ucCTL1 &= ~UCSWRST;							/* leave software reset */
 }
 
-void vUartInit( void )
+/**
+ * @brief Enable the RX interrupt if the port receives
+ *
+ * A port without RX stream buffer still receives XON and XOFF with flow control.
+ */
+static void prvEnableReceive( UartPort_t *pxPort )
 {
-	P3SEL |= BIT4 | BIT5;	/* set P3.4 and P3.5 for USCI */
-	UCA0CTL1 |= UCSWRST;	/* enter software reset */
-	UCA0CTL1 |= UCSSEL_2;	/* select SMCLK for BRCLK */
-	UCA0BRW = 86;			/* set BR to 86 and BRS to 6 for 115200 */
-	UCA0MCTL = UCBRS_6;
-	UCA0CTL1 &= ~UCSWRST;	/* leave software reset */
-	UCA0IE |= UCRXIE;		/* enable USCI_A0 RX interrupt */
+	if( ( pxPort->xRxBuffer != NULL ) || ( pxPort->eFlowControl != eUartFlowNone ) )
+	{
+		pxPort->pxHardware->pxUsci->ucIE |= UCRXIE;		/* enable RX interrupt */
+	}
+}
 
-	/* create ringbuffer */
-	xStringBuffer = xRingBufferCreate( 128 );
+/**
+ * @brief Error of a baud rate reached, in 0.01 %
+ *
+ * Rounding the cycles per bit keeps the rate reached within 1/32 of the rate
+ * requested, so the product fits for BRCLK up to 25 MHz.
+ */
+static int16_t prvBaudError( uint32_t ulReached, uint32_t ulBaudRate )
+{
+	return ( int16_t ) ( ( ( ( int32_t ) ulReached - ( int32_t ) ulBaudRate ) * 10000L ) / ( int32_t ) ulBaudRate );
+}
+
+BaseType_t xUartComputeBaud( uint32_t ulClockHz, uint32_t ulBaudRate, UartBaud_t *pxBaud )
+{
+	uint32_t ulSixteenths;
+	uint32_t ulEighths;
+	uint32_t ulDivider;
+	uint16_t usFraction;
+
+	pxBaud->usDivider = 0;
+	pxBaud->ucModulation = 0;
+	pxBaud->sError = 0;
+
+	if( ( ulBaudRate == 0 ) || ( ulClockHz / uartLF_MIN_CYCLES < ulBaudRate ) )
+	{
+		return pdFAIL;
+	}
+
+	/* BRCLK cycles per bit, N, in 1/16 of a cycle, rounded */
+	ulSixteenths = ( ( ulClockHz * 16UL ) + ( ulBaudRate / 2 ) ) / ulBaudRate;
+
+	if( ulSixteenths >= ( uartOS16_MIN_CYCLES * 16UL ) )
+	{
+		/* oversampling: UCBRx = INT( N / 16 ), UCBRFx = ROUND( FRAC( N / 16 ) * 16 ),
+		 * a bit lasts 16 * UCBRx + UCBRFx cycles */
+		ulDivider = ulSixteenths >> 8;
+		usFraction = ( uint16_t ) ( ( ( ulSixteenths & 0xFF ) + 8 ) >> 4 );
+		if( usFraction == 16 )
+		{
+			ulDivider++;
+			usFraction = 0;
+		}
+		if( ulDivider > 0xFFFF )
+		{
+			return pdFAIL;
+		}
+		pxBaud->usDivider = ( uint16_t ) ulDivider;
+		pxBaud->ucModulation = ( uint8_t ) ( ( usFraction << 4 ) | UCOS16 );
+		ulDivider = ( ulDivider * 16 ) + usFraction;
+		pxBaud->sError = prvBaudError( ( ulClockHz + ( ulDivider / 2 ) ) / ulDivider, ulBaudRate );
+
+		if( ( pxBaud->sError <= uartMAX_BAUD_ERROR ) && ( pxBaud->sError >= -uartMAX_BAUD_ERROR ) )
+		{
+			return pdPASS;
+		}
+		/* whole cycles per bit are too coarse at this N, modulate in eighths */
+	}
+
+	/* low-frequency: UCBRx = INT( N ), UCBRSx = ROUND( FRAC( N ) * 8 ), a bit
+	 * lasts UCBRx cycles plus one more in UCBRSx bits of every 8 */
+	ulEighths = ( ( ulClockHz * 8UL ) + ( ulBaudRate / 2 ) ) / ulBaudRate;
+	if( ( ulEighths >> 3 ) > 0xFFFF )
+	{
+		return pdFAIL;
+	}
+	pxBaud->usDivider = ( uint16_t ) ( ulEighths >> 3 );
+	pxBaud->ucModulation = ( uint8_t ) ( ( ulEighths & 0x07 ) << 1 );
+	pxBaud->sError = prvBaudError( ( ( ulClockHz * 8UL ) + ( ulEighths / 2 ) ) / ulEighths, ulBaudRate );
+
+	return ( ( pxBaud->sError <= uartMAX_BAUD_ERROR ) && ( pxBaud->sError >= -uartMAX_BAUD_ERROR ) ) ? pdPASS : pdFAIL;
+}
+
+BaseType_t xUartReceive( UartHandle_t xPort, uint8_t *pucData, uint16_t usLength, uint16_t *pusReceived, TickType_t xBlockTime )
+{
+	UartPort_t *pxPort = ( UartPort_t * ) xPort;
+
+	configASSERT( pxPort->xRxBuffer != NULL );
+
+	/* the stream buffer blocks the reader until the RX interrupt writes a byte */
+	*pusReceived = ( uint16_t ) xStreamBufferReceive( pxPort->xRxBuffer, pucData, usLength, xBlockTime );
+
+	if( *pusReceived == 0 )
+	{
+		return pdFAIL;
+	}
+
+	/* let the PC send again once there is room */
+	if( ( pxPort->xRxStopped != pdFALSE ) &&
+		( xStreamBufferBytesAvailable( pxPort->xRxBuffer ) <= ( pxPort->usRxBufferSize / 4 ) * uartXON_QUARTERS ) )
+	{
+		taskENTER_CRITICAL();
+		{
+			pxPort->xRxStopped = pdFALSE;
+			pxPort->ucTxControl = uartXON;
+			prvResumeTransmission( pxPort );
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	return pdPASS;
+}
+
+/**
+ * @brief Free what xUartOpen created for a port it could not open
+ *
+ * The port is left as if it had never been opened, so opening it can be
+ * tried again.
+ */
+static void prvFreePort( UartPort_t *pxPort )
+{
+	if( pxPort->xTxBuffer != NULL )
+	{
+		vRingBufferDelete( pxPort->xTxBuffer );
+		pxPort->xTxBuffer = NULL;
+	}
+	if( pxPort->xRxBuffer != NULL )
+	{
+		vStreamBufferDelete( pxPort->xRxBuffer );
+		pxPort->xRxBuffer = NULL;
+	}
+	if( pxPort->xUARTQueue != NULL )
+	{
+		vQueueDelete( pxPort->xUARTQueue );
+		pxPort->xUARTQueue = NULL;
+	}
+	if( pxPort->xTxMutex != NULL )
+	{
+		vSemaphoreDelete( pxPort->xTxMutex );
+		pxPort->xTxMutex = NULL;
+	}
+	if( pxPort->xTxSpace != NULL )
+	{
+		vSemaphoreDelete( pxPort->xTxSpace );
+		pxPort->xTxSpace = NULL;
+	}
+}
+
+UartHandle_t xUartOpen( UartPortId_t ePort, const UartConfig_t *pxConfig )
+{
+	UartPort_t *pxPort;
+	const UartHardware_t *pxHardware;
+	UsciA_t *pxUsci;
+	UartBaud_t xBaud;
+
+	configASSERT( ePort < eUartPortCount );
+
+	pxPort = &xUartPorts[ ePort ];
+	pxHardware = &xUartHardware[ ePort ];
+	pxUsci = pxHardware->pxUsci;
+
+	if( pxPort->pxHardware != NULL )
+	{
+		return pxPort;
+	}
+
+	if( xUartComputeBaud( hal430GetSystemClock(), pxConfig->ulBaudRate, &xBaud ) != pdPASS )
+	{
+		return NULL;
+	}
+	pxPort->ulBaudRate = pxConfig->ulBaudRate;
+	pxPort->eFlowControl = pxConfig->eFlowControl;
+
+	/* create the TX ringbuffer and the RX stream buffer; the reader wakes on every byte */
+	pxPort->xTxBuffer = xRingBufferCreate( pxConfig->usTxBufferSize, eRingBufferReject );
+	pxPort->usTxBufferSize = pxConfig->usTxBufferSize;
+	if( pxConfig->usRxBufferSize > 0 )
+	{
+		pxPort->xRxBuffer = xStreamBufferCreate( pxConfig->usRxBufferSize, 1 );
+		pxPort->usRxBufferSize = pxConfig->usRxBufferSize;
+	}
 	/* create UART queue */
-	xUARTQueue = xQueueCreate( 10, sizeof( UARTMessage_t * ) );
-	/* create UART task */
-	xTaskCreate( prvTaskUART, "UART Task", 4*configMINIMAL_STACK_SIZE, NULL, 6, NULL );
+	if( pxConfig->uxZeroCopyLength > 0 )
+	{
+		pxPort->xUARTQueue = xQueueCreate( pxConfig->uxZeroCopyLength, sizeof( UartTxBuffer_t ) );
+	}
+	/* create mutex for senders and semaphore for room in the TX ringbuffer */
+	pxPort->xTxMutex = xSemaphoreCreateMutex();
+	pxPort->xTxSpace = xSemaphoreCreateBinary();
+
+	if( ( pxPort->xTxBuffer == NULL ) || ( pxPort->xTxMutex == NULL ) || ( pxPort->xTxSpace == NULL ) ||
+		( ( pxConfig->usRxBufferSize > 0 ) && ( pxPort->xRxBuffer == NULL ) ) ||
+		( ( pxConfig->uxZeroCopyLength > 0 ) && ( pxPort->xUARTQueue == NULL ) ) )
+	{
+		prvFreePort( pxPort );
+		return NULL;
+	}
+
+	*pxHardware->pucPinSelect |= pxHardware->ucPins;	/* set TXD and RXD pins for USCI */
+	prvSetBitClock( pxUsci, &xBaud );
+
+	/* the DMA channel is triggered by UCAxTXIFG; DMA transfers are held off
+	 * during CPU read-modify-write instructions */
+	if( pxHardware->ucDmaChannel == 0 )
+	{
+		DMACTL0 = ( DMACTL0 & 0xFF00 ) | pxHardware->ucDmaTrigger;
+	}
+	else if( pxHardware->ucDmaChannel == 1 )
+	{
+		DMACTL0 = ( DMACTL0 & 0x00FF ) | ( ( uint16_t ) pxHardware->ucDmaTrigger << 8 );
+	}
+	DMACTL4 = DMARMWDIS;
+
+	/* the interrupts see the port from here on */
+	pxPort->pxHardware = pxHardware;
+
+	prvEnableReceive( pxPort );
+
+	return pxPort;
 }
 
-BaseType_t xUartSendString( const char *pcString, TickType_t xBlockTime )
+BaseType_t xUartSetBaud( UartHandle_t xPort, uint32_t ulBaudRate, UartBaud_t *pxBaud, TickType_t xBlockTime )
 {
-	UARTMessage_t xMsg = { UART_MSG_STR, (uint8_t *)pcString };
-	UARTMessage_t *pxMsg = &xMsg;
+	UartPort_t *pxPort = ( UartPort_t * ) xPort;
+	UsciA_t *pxUsci = pxPort->pxHardware->pxUsci;
+	UartBaud_t xBaud;
+	TimeOut_t xTimeOut;
 	BaseType_t xRet = pdFAIL;
 
-	if( xQueueSendToBack( xUARTQueue, &pxMsg, xBlockTime ) == pdTRUE )
+	vTaskSetTimeOutState( &xTimeOut );
+
+	if( ( xUartComputeBaud( hal430GetSystemClock(), ulBaudRate, &xBaud ) == pdPASS ) &&
+		( xSemaphoreTake( pxPort->xTxMutex, xBlockTime ) == pdTRUE ) )
+	{
+		/* bytes queued so far are sent at the rate they were queued for */
+		( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+		if( prvWaitIdle( pxPort, &xTimeOut, &xBlockTime ) == pdPASS )
+		{
+			taskENTER_CRITICAL();
+			{
+				prvSetBitClock( pxUsci, &xBaud );
+				prvEnableReceive( pxPort );
+			}
+			taskEXIT_CRITICAL();
+
+			pxPort->ulBaudRate = ulBaudRate;
+			xRet = pdPASS;
+		}
+
+		xSemaphoreGive( pxPort->xTxMutex );
+	}
+
+	if( pxBaud != NULL )
 	{
-		xRet = pdPASS;
+		*pxBaud = xBaud;
 	}
 
 	return xRet;
 }
 
-void __attribute__ ( ( interrupt( USCI_A0_VECTOR ) ) ) vUSCIA0ISR ( void )
+uint32_t ulUartGetBaud( UartHandle_t xPort )
+{
+	return ( ( UartPort_t * ) xPort )->ulBaudRate;
+}
+
+BaseType_t xUartClockSupported( uint32_t ulClockHz )
 {
-	switch( __even_in_range( UCA0IV, 4 ) )
+	UartBaud_t xBaud;
+	UBaseType_t uxPort;
+
+	for( uxPort = 0; uxPort < eUartPortCount; uxPort++ )
 	{
-	case 0:		/* no interrupt */
-		break;
-	case 2:		/* RX interrupt */
-		/* if callback is defined, execute it */
-		if ( prvReceiveByteCallback )
+		if( ( xUartPorts[ uxPort ].pxHardware != NULL ) &&
+			( xUartComputeBaud( ulClockHz, xUartPorts[ uxPort ].ulBaudRate, &xBaud ) != pdPASS ) )
 		{
-			prvReceiveByteCallback( UCA0RXBUF );
+			return pdFAIL;
 		}
-		break;
-	case 4:		/* TX interrupt */
+	}
+
+	return pdPASS;
+}
+
+BaseType_t xUartPrepareClockChange( TickType_t xBlockTime )
+{
+	UartPort_t *pxPort;
+	TimeOut_t xTimeOut;
+	UBaseType_t uxPort;
+	UBaseType_t uxHeld;
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( uxPort = 0; uxPort < eUartPortCount; uxPort++ )
 	{
-		RingBuffer_t *pxRingBuffer = ( RingBuffer_t *) xStringBuffer;
+		pxPort = &xUartPorts[ uxPort ];
 
-		/* dequeue from ringbuffer as long as there is data */
-		if( pxRingBuffer->ucCount > 0 )
+		if( pxPort->pxHardware == NULL )
 		{
-			UCA0TXBUF = *pxRingBuffer->pucTail;
+			continue;
+		}
+
+		( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+		if( xSemaphoreTake( pxPort->xTxMutex, xBlockTime ) != pdTRUE )
+		{
+			break;
+		}
 
-			if( pxRingBuffer->pucTail == pxRingBuffer->pucEnd )
+		( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+		if( prvWaitIdle( pxPort, &xTimeOut, &xBlockTime ) != pdPASS )
+		{
+			xSemaphoreGive( pxPort->xTxMutex );
+			break;
+		}
+	}
+
+	if( uxPort == eUartPortCount )
+	{
+		/* from here on XON and XOFF wait for the new bit clock */
+		for( uxPort = 0; uxPort < eUartPortCount; uxPort++ )
+		{
+			if( xUartPorts[ uxPort ].pxHardware != NULL )
 			{
-				pxRingBuffer->pucTail = pxRingBuffer->pucBuffer;
+				xUartPorts[ uxPort ].xClockChanging = pdTRUE;
 			}
-			else
+		}
+		return pdPASS;
+	}
+
+	/* give back the ports held so far */
+	for( uxHeld = 0; uxHeld < uxPort; uxHeld++ )
+	{
+		if( xUartPorts[ uxHeld ].pxHardware != NULL )
+		{
+			xSemaphoreGive( xUartPorts[ uxHeld ].xTxMutex );
+		}
+	}
+
+	return pdFAIL;
+}
+
+void vUartClockChanged( void )
+{
+	UartPort_t *pxPort;
+	UartBaud_t xBaud;
+	UBaseType_t uxPort;
+	uint32_t ulClockHz = hal430GetSystemClock();
+
+	for( uxPort = 0; uxPort < eUartPortCount; uxPort++ )
+	{
+		pxPort = &xUartPorts[ uxPort ];
+
+		if( pxPort->pxHardware == NULL )
+		{
+			continue;
+		}
+
+		/* xUartClockSupported() was checked before the change, the settings
+		 * are kept only if the rate is no longer reachable */
+		if( xUartComputeBaud( ulClockHz, pxPort->ulBaudRate, &xBaud ) == pdPASS )
+		{
+			taskENTER_CRITICAL();
 			{
-				pxRingBuffer->pucTail++;
+				prvSetBitClock( pxPort->pxHardware->pxUsci, &xBaud );
+				prvEnableReceive( pxPort );
 			}
-			pxRingBuffer->ucCount--;
+			taskEXIT_CRITICAL();
+		}
 
+		/* an XON or XOFF held back during the change goes out first */
+		taskENTER_CRITICAL();
+		{
+			pxPort->xClockChanging = pdFALSE;
+			if( pxPort->ucTxControl != 0 )
+			{
+				prvResumeTransmission( pxPort );
+			}
 		}
-		else
+		taskEXIT_CRITICAL();
+
+		xSemaphoreGive( pxPort->xTxMutex );
+	}
+}
+
+BaseType_t xUartIsBusy( void )
+{
+	const UartPort_t *pxPort;
+	UsciA_t *pxUsci;
+	UBaseType_t uxPort;
+
+	for( uxPort = 0; uxPort < eUartPortCount; uxPort++ )
+	{
+		pxPort = &xUartPorts[ uxPort ];
+
+		if( pxPort->pxHardware == NULL )
 		{
-			/* when there is no more data, disable interrupt */
-			UCA0IE &= ~UCTXIE;
+			continue;
+		}
+
+		pxUsci = pxPort->pxHardware->pxUsci;
+		if( ( pxUsci->ucIE & UCTXIE ) || ( pxPort->usDmaLength != 0 ) || ( pxUsci->ucSTAT & UCBUSY ) )
+		{
+			return pdTRUE;
 		}
 	}
+
+	return pdFALSE;
+}
+
+void vUartGetStats( UartHandle_t xPort, UartStats_t *pxStats )
+{
+	const UartPort_t *pxPort;
+	UBaseType_t uxPort;
+
+	pxStats->usTxDropped = 0;
+	pxStats->usRxDropped = 0;
+	pxStats->usRxOverrun = 0;
+
+	for( uxPort = 0; uxPort < eUartPortCount; uxPort++ )
+	{
+		pxPort = &xUartPorts[ uxPort ];
+
+		if( ( ( xPort == NULL ) && ( pxPort->pxHardware != NULL ) ) || ( xPort == pxPort ) )
+		{
+			pxStats->usTxDropped += pxPort->usTxDropped;
+			pxStats->usRxDropped += pxPort->usRxDropped;
+			pxStats->usRxOverrun += pxPort->usRxOverrun;
+		}
+	}
+}
+
+BaseType_t xUartSend( UartHandle_t xPort, const void *pvData, uint16_t usLength, TickType_t xBlockTime )
+{
+	UartPort_t *pxPort = ( UartPort_t * ) xPort;
+	TimeOut_t xTimeOut;
+	BaseType_t xRet = pdFAIL;
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	if( xSemaphoreTake( pxPort->xTxMutex, xBlockTime ) == pdTRUE )
+	{
+		/* what is left of the block time is spent waiting for room */
+		( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+		if( prvCopyIn( pxPort, ( const uint8_t * ) pvData, usLength, pdTRUE, &xTimeOut, &xBlockTime ) == usLength )
+		{
+			xRet = pdPASS;
+		}
+		xSemaphoreGive( pxPort->xTxMutex );
+	}
+	else
+	{
+		prvCountTxDropped( pxPort, usLength );
+	}
+
+	return xRet;
+}
+
+uint16_t usUartSendPartial( UartHandle_t xPort, const void *pvData, uint16_t usLength, TickType_t xBlockTime )
+{
+	UartPort_t *pxPort = ( UartPort_t * ) xPort;
+	TimeOut_t xTimeOut;
+	uint16_t usCopied = 0;
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	if( xSemaphoreTake( pxPort->xTxMutex, xBlockTime ) == pdTRUE )
+	{
+		( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+		usCopied = prvCopyIn( pxPort, ( const uint8_t * ) pvData, usLength, pdFALSE, &xTimeOut, &xBlockTime );
+		xSemaphoreGive( pxPort->xTxMutex );
+	}
+	else
+	{
+		prvCountTxDropped( pxPort, usLength );
+	}
+
+	return usCopied;
+}
+
+BaseType_t xUartSendString( UartHandle_t xPort, const char *pcString, TickType_t xBlockTime )
+{
+	return xUartSend( xPort, pcString, strlen( pcString ), xBlockTime );
+}
+
+BaseType_t xUartPrintf( UartHandle_t xPort, char *pcBuffer, size_t xBufferSize, TickType_t xBlockTime, const char *pcFormat, ... )
+{
+	va_list xArgs;
+
+	va_start( xArgs, pcFormat );
+	vsnprintf( pcBuffer, xBufferSize, pcFormat, xArgs );
+	va_end( xArgs );
+
+	return xUartSendString( xPort, pcBuffer, xBlockTime );
+}
+
+BaseType_t xUartSendZeroCopy( UartHandle_t xPort, const uint8_t *pucData, uint16_t usLength, UartTxCompleteCallback_t pxCallback, void *pvContext, TickType_t xBlockTime )
+{
+	UartPort_t *pxPort = ( UartPort_t * ) xPort;
+	UartTxBuffer_t xBuffer;
+	TimeOut_t xTimeOut;
+	BaseType_t xRet = pdFAIL;
+
+	configASSERT( usLength > 0 );
+	configASSERT( pxPort->xUARTQueue != NULL );
+
+	xBuffer.pucData = pucData;
+	xBuffer.usLength = usLength;
+	xBuffer.pxCallback = pxCallback;
+	xBuffer.pvContext = pvContext;
+	xBuffer.xTaskToNotify = ( pxCallback == NULL ) ? xTaskGetCurrentTaskHandle() : NULL;
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	if( xSemaphoreTake( pxPort->xTxMutex, xBlockTime ) == pdTRUE )
+	{
+		/* mark the end of the bytes copied in so far; they are sent first */
+		xBuffer.usMarker = usRingBufferWriteIndex( pxPort->xTxBuffer );
+
+		( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+		if( xQueueSendToBack( pxPort->xUARTQueue, &xBuffer, xBlockTime ) == pdTRUE )
+		{
+			xRet = pdPASS;
+
+			/* if transmission is not in progress, initiate transmission */
+			prvStartTransmission( pxPort );
+		}
+
+		xSemaphoreGive( pxPort->xTxMutex );
+	}
+
+	return xRet;
+}
+
+/**
+ * @brief Handle the interrupt of a USCI_Ax module
+ * @return pdTRUE if a woken task should run now
+ *
+ * The reader, a sender waiting for room, or the owner of a released buffer
+ * may have been woken.
+ */
+static BaseType_t prvUsciInterrupt( UartPort_t *pxPort )
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	UsciA_t *pxUsci;
+	uint8_t ucByte;
+
+	/* a port that is not open never enables its interrupts */
+	configASSERT( pxPort->pxHardware != NULL );
+	pxUsci = pxPort->pxHardware->pxUsci;
+
+	switch( __even_in_range( pxUsci->usIV, 4 ) )
+	{
+	case 0:		/* no interrupt */
 		break;
+	case 2:		/* RX interrupt */
+		/* UCOE means a byte was overwritten before this one; reading RXBUF clears it */
+		if( pxUsci->ucSTAT & UCOE )
+		{
+			pxPort->usRxOverrun++;
+		}
+		ucByte = pxUsci->ucRXBUF;
+
+		if( ( pxPort->eFlowControl == eUartFlowXonXoff ) && ( ( ucByte == uartXON ) || ( ucByte == uartXOFF ) ) )
+		{
+			pxPort->xTxStopped = ( ucByte == uartXOFF ) ? pdTRUE : pdFALSE;
+			if( ucByte == uartXON )
+			{
+				prvResumeTransmission( pxPort );
+			}
+			break;
+		}
+
+		/* the stream buffer wakes the reader if it waits */
+		if( ( pxPort->xRxBuffer == NULL ) ||
+			( xStreamBufferSendFromISR( pxPort->xRxBuffer, &ucByte, 1, &xHigherPriorityTaskWoken ) == 0 ) )
+		{
+			pxPort->usRxDropped++;
+			break;
+		}
+
+		/* ask the PC to stop before the stream buffer overflows */
+		if( ( pxPort->eFlowControl == eUartFlowXonXoff ) && ( pxPort->xRxStopped == pdFALSE ) &&
+			( xStreamBufferBytesAvailable( pxPort->xRxBuffer ) >= ( pxPort->usRxBufferSize / 4 ) * uartXOFF_QUARTERS ) )
+		{
+			pxPort->xRxStopped = pdTRUE;
+			pxPort->ucTxControl = uartXOFF;
+			prvResumeTransmission( pxPort );
+		}
+		break;
+	case 4:		/* TX interrupt */
+		/* send as long as there is data */
+		prvTransmitNext( pxPort, &xHigherPriorityTaskWoken );
+		break;
+	}
+
+	return xHigherPriorityTaskWoken;
+}
+
+/**
+ * @brief Finish a DMA transfer of a port
+ * @param pxHigherPriorityTaskWoken set to pdTRUE if the owner of a released buffer should run now
+ *
+ * Release the buffer or span and let the TX interrupt send what follows it
+ * once the last byte has left TXBUF.
+ */
+static void prvDmaComplete( UartPort_t *pxPort, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	if( pxPort->xBufferActive != pdFALSE )
+	{
+		pxPort->xBufferActive = pdFALSE;
+		prvReleaseBuffer( &pxPort->xActiveBuffer, pxHigherPriorityTaskWoken );
+	}
+	else
+	{
+		xRingBufferConsume( pxPort->xTxBuffer, pxPort->usDmaLength );
+		prvCheckRoomFromISR( pxPort, pxHigherPriorityTaskWoken );
 	}
+	pxPort->usDmaLength = 0;
+	pxPort->pxHardware->pxUsci->ucIE |= UCTXIE;
+}
+
+void __attribute__ ( ( interrupt( USCI_A0_VECTOR ) ) ) vUSCIA0ISR ( void )
+{
+	BaseType_t xHigherPriorityTaskWoken = prvUsciInterrupt( &xUartPorts[ eUartA0 ] );
+
+	__bic_SR_register_on_exit( SCG1 + SCG0 + OSCOFF + CPUOFF );
+	portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+
+void __attribute__ ( ( interrupt( USCI_A1_VECTOR ) ) ) vUSCIA1ISR ( void )
+{
+	BaseType_t xHigherPriorityTaskWoken = prvUsciInterrupt( &xUartPorts[ eUartA1 ] );
+
+	__bic_SR_register_on_exit( SCG1 + SCG0 + OSCOFF + CPUOFF );
+	portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+
+void __attribute__ ( ( interrupt( USCI_A2_VECTOR ) ) ) vUSCIA2ISR ( void )
+{
+	BaseType_t xHigherPriorityTaskWoken = prvUsciInterrupt( &xUartPorts[ eUartA2 ] );
+
+	__bic_SR_register_on_exit( SCG1 + SCG0 + OSCOFF + CPUOFF );
+	portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+
+void __attribute__ ( ( interrupt( USCI_A3_VECTOR ) ) ) vUSCIA3ISR ( void )
+{
+	BaseType_t xHigherPriorityTaskWoken = prvUsciInterrupt( &xUartPorts[ eUartA3 ] );
+
+	__bic_SR_register_on_exit( SCG1 + SCG0 + OSCOFF + CPUOFF );
+	portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+
+void __attribute__ ( ( interrupt( DMA_VECTOR ) ) ) vDMAISR ( void )
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	switch( __even_in_range( DMAIV, 16 ) )
+	{
+	case 2:		/* DMA channel 0 transfer complete, USCI_A0 */
+		prvDmaComplete( &xUartPorts[ eUartA0 ], &xHigherPriorityTaskWoken );
+		break;
+	case 4:		/* DMA channel 1 transfer complete, USCI_A1 */
+		prvDmaComplete( &xUartPorts[ eUartA1 ], &xHigherPriorityTaskWoken );
+		break;
+	default:
+		break;
+	}
+
+	__bic_SR_register_on_exit( SCG1 + SCG0 + OSCOFF + CPUOFF );
+	portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
 }
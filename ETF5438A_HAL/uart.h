@@ -4,44 +4,290 @@
  * @date 2016
  * @brief OS-aware UART communication
  *
- * Implementation of UART communication using FreeRTOS.
- * UART Task is created which handles all UART data communication.
- * Other tasks communicate with UART Task using "UART Queue".
+ * Implementation of UART communication using FreeRTOS on USCI_A0 to USCI_A3.
+ * Every port that is opened gets its own TX ringbuffer, RX stream buffer,
+ * queue of lent buffers, sender mutex and interrupt state, so a busy port
+ * never holds up another.
+ * Tasks send data either by copy, after which their buffer is free again, or
+ * by lending the buffer, which is handed back when it has been sent.
+ * Received data is buffered until a task reads it.
+ *
+ * Nothing is lost silently: a sender waits for room in the TX ringbuffer, or
+ * is told how much was queued, and every byte given up on the way out or in is
+ * counted in the port's statistics. A port can use XON/XOFF flow control to
+ * stop the PC when its RX stream buffer fills up and to be stopped by it.
+ *
+ * The bit clock is derived from SMCLK. Its settings are computed for the
+ * frequency hal430SetSystemClock() set, so any baud rate up to a third of
+ * SMCLK can be selected, at open or later, and the error is reported.
  */
 
 #ifndef UART_H_
 #define UART_H_
 
-/* receive calbback function pointer type */
-typedef void ( *ReceiveByteCallbackFunction_t )( uint8_t ucData );
+/** @brief USCI_A module a port runs on */
+typedef enum
+{
+	eUartA0,		/**< P3.4 TXD, P3.5 RXD, transmits by DMA channel 0 */
+	eUartA1,		/**< P5.6 TXD, P5.7 RXD, transmits by DMA channel 1 */
+	eUartA2,		/**< P9.4 TXD, P9.5 RXD, transmits by interrupt only */
+	eUartA3,		/**< P10.4 TXD, P10.5 RXD, transmits by interrupt only */
+	eUartPortCount
+} UartPortId_t;
+
+/** @brief Flow control of a port */
+typedef enum
+{
+	eUartFlowNone,			/**< no flow control */
+	eUartFlowXonXoff		/**< XON/XOFF in both directions, only for ports that send text */
+} UartFlowControl_t;
+
+/** @brief Port configuration */
+typedef struct
+{
+	uint32_t ulBaudRate;			/**< bits per second */
+	uint16_t usTxBufferSize;		/**< TX ringbuffer size, a power of two */
+	uint16_t usRxBufferSize;		/**< RX stream buffer size, 0 if the port only transmits */
+	UBaseType_t uxZeroCopyLength;	/**< number of lent buffers that can wait, 0 if none are lent */
+	UartFlowControl_t eFlowControl;	/**< flow control */
+} UartConfig_t;
+
+/** @brief Bytes lost by a port, running counts that wrap */
+typedef struct
+{
+	uint16_t usTxDropped;			/**< bytes senders gave up on because the TX ringbuffer stayed full */
+	uint16_t usRxDropped;			/**< received bytes that did not fit in the RX stream buffer */
+	uint16_t usRxOverrun;			/**< received bytes overwritten in RXBUF before the interrupt read them */
+} UartStats_t;
+
+/** @brief XON/XOFF characters, DC1 and DC3 */
+#define uartXON						( 0x11 )
+#define uartXOFF					( 0x13 )
+
+/** @brief Bit clock settings of a baud rate */
+typedef struct
+{
+	uint16_t usDivider;				/**< UCAxBRW */
+	uint8_t ucModulation;			/**< UCAxMCTL: UCBRFx and UCOS16, or UCBRSx */
+	int16_t sError;					/**< error of the baud rate reached, in 0.01 %, positive if faster */
+} UartBaud_t;
+
+/**
+ * @brief Largest baud rate error accepted, in 0.01 %
+ *
+ * A receiver samples each bit in its middle, so the error of both ends
+ * together must stay well below half a bit over the ten bits of a frame.
+ */
+#ifndef uartMAX_BAUD_ERROR
+#define uartMAX_BAUD_ERROR			( 200 )
+#endif
+
+/** @brief Port handle */
+typedef void * UartHandle_t;
+
+/**
+ * @brief Transmit complete callback function pointer type
+ * @param pucData Buffer handed back
+ * @param pvContext Value given to xUartSendZeroCopy
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if a task woken by the callback should run now
+ *
+ * Executed in ISR context, so use only functions ending with FromISR.
+ */
+typedef void ( *UartTxCompleteCallback_t )( const uint8_t *pucData, void *pvContext, BaseType_t *pxHigherPriorityTaskWoken );
+
+/**
+ * @brief Compute the bit clock settings of a baud rate
+ * @param ulClockHz frequency of BRCLK, SMCLK for the ports of this driver
+ * @param ulBaudRate requested baud rate
+ * @param pxBaud set to the settings and the error of the rate they reach
+ * @return pdPASS if the rate is reached within uartMAX_BAUD_ERROR, pdFAIL if not
+ *
+ * With 16 or more BRCLK cycles per bit the oversampling mode (UCOS16) is
+ * used, which samples each bit three times around its middle. Below that the
+ * low-frequency mode is used, which needs at least 3 cycles per bit.
+ */
+extern BaseType_t xUartComputeBaud( uint32_t ulClockHz, uint32_t ulBaudRate, UartBaud_t *pxBaud );
 
 /**
  * @brief UART initialization
+ * @param ePort USCI_A module to use
+ * @param pxConfig Configuration of the port
+ * @return handle of the port, NULL if memory could not be allocated or the
+ * baud rate cannot be reached from SMCLK
+ *
+ * Initialize the USCI_A hardware and its pins for communication. On USCI_A0
+ * and USCI_A1 select UCAxTXIFG as trigger of the port's DMA channel, which
+ * sends longer runs of bytes.
+ * Create the TX ringbuffer to store bytes copied in for transmission, the RX
+ * stream buffer to store received bytes, the queue to store buffers lent for
+ * transmission, the mutex that serializes senders and the semaphore a sender
+ * waits on for room.
+ * Opening a port that is already open returns its handle and ignores
+ * @p pxConfig, so modules can share a port.
+ */
+extern UartHandle_t xUartOpen( UartPortId_t ePort, const UartConfig_t *pxConfig );
+
+/**
+ * @brief Change the baud rate of an open port
+ * @param xPort Port to change
+ * @param ulBaudRate New baud rate
+ * @param pxBaud Set to the settings and error of the new rate, or NULL
+ * @param xBlockTime Block time in ticks to wait for other senders and for queued data to be sent
+ * @return pdPASS if the port runs at the new rate, pdFAIL if the rate cannot be
+ * reached from SMCLK or the time ran out; the old rate is kept then
+ *
+ * Everything queued before the call is sent at the old rate first. The
+ * settings are computed for the current SMCLK, so this also retunes a port
+ * after SMCLK has changed. Bytes arriving while the port is reprogrammed are
+ * lost.
+ */
+extern BaseType_t xUartSetBaud( UartHandle_t xPort, uint32_t ulBaudRate, UartBaud_t *pxBaud, TickType_t xBlockTime );
+
+/**
+ * @brief Get the baud rate of a port
+ * @param xPort Open port
+ * @return baud rate requested at open or by the last successful xUartSetBaud
+ */
+extern uint32_t ulUartGetBaud( UartHandle_t xPort );
+
+/**
+ * @brief API for other tasks to send data to PC
+ * @param xPort Port to send on
+ * @param pvData Bytes to send
+ * @param usLength Number of bytes
+ * @param xBlockTime Block time in ticks to wait for room in the ringbuffer
+ * @return pdPASS if all bytes were queued, pdFAIL if not
  *
- * Initialize USCI_A0 hardware for communication.
- * Create 128 byte ringbuffer to store characters that are transmitted to PC.
- * Create 10 item queue to store pointers to UART messages.
- * Create UART Task.
+ * Bytes are copied before the function returns, so @p pvData can be reused at
+ * once. Data that fits in the ringbuffer is queued whole or not at all; while
+ * there is no room the caller blocks until the TX interrupt has freed enough.
+ * Bytes not queued when the time runs out are counted as dropped.
  */
-extern void vUartInit( void );
+extern BaseType_t xUartSend( UartHandle_t xPort, const void *pvData, uint16_t usLength, TickType_t xBlockTime );
+
+/**
+ * @brief API for other tasks to send as much data as fits
+ * @param xPort Port to send on
+ * @param pvData Bytes to send
+ * @param usLength Number of bytes
+ * @param xBlockTime Block time in ticks to wait for room in the ringbuffer
+ * @return number of bytes queued, the first ones of @p pvData
+ *
+ * Like xUartSend, but whatever room there is gets used at once, so a stream
+ * can be queued piecewise as the ringbuffer drains. Bytes not queued when the
+ * time runs out are counted as dropped; the caller may send them again.
+ */
+extern uint16_t usUartSendPartial( UartHandle_t xPort, const void *pvData, uint16_t usLength, TickType_t xBlockTime );
 
 /**
  * @brief API for other tasks to send string to PC
+ * @param xPort Port to send on
  * @param pcString String to send
- * @param xBlockTime Block time in ticks to wait if UART queue is full
+ * @param xBlockTime Block time in ticks to wait for room in the ringbuffer
+ * @return pdPASS if successfully sent, pdFAIL if not
+ *
+ * Other tasks can send string to PC using this function. The string is copied,
+ * see xUartSend.
+ */
+extern BaseType_t xUartSendString( UartHandle_t xPort, const char *pcString, TickType_t xBlockTime );
+
+/**
+ * @brief API for other tasks to send formatted text to PC
+ * @param xPort Port to send on
+ * @param pcBuffer Buffer the text is formatted into
+ * @param xBufferSize Size of @p pcBuffer, text that does not fit is cut off
+ * @param xBlockTime Block time in ticks to wait for room in the ringbuffer
+ * @param pcFormat printf format of the text
  * @return pdPASS if successfully sent, pdFAIL if not
  *
- * Other tasks can send string to PC using this function.
+ * The text is copied like with xUartSendString, so @p pcBuffer can be used
+ * again as soon as the function returns. The caller provides the buffer, so a
+ * task whose stack is small can keep its own static one.
+ */
+extern BaseType_t xUartPrintf( UartHandle_t xPort, char *pcBuffer, size_t xBufferSize, TickType_t xBlockTime, const char *pcFormat, ... );
+
+/**
+ * @brief API for other tasks to send a buffer to PC without copying it
+ * @param xPort Port to send on, opened with uxZeroCopyLength above 0
+ * @param pucData Buffer to send, must stay valid and unchanged until handed back
+ * @param usLength Number of bytes, at least one
+ * @param pxCallback Called from ISR context when the buffer is handed back, or NULL
+ * @param pvContext Passed to @p pxCallback
+ * @param xBlockTime Block time in ticks to wait if the queue of lent buffers is full
+ * @return pdPASS if the buffer was lent, pdFAIL if not
+ *
+ * The buffer is sent after everything queued before it, straight from where it
+ * is. When the last byte has been taken from it the buffer is handed back:
+ * @p pxCallback is called, or if it is NULL the calling task's notification is
+ * given, so the task can wait with ulTaskNotifyTake.
  */
-extern BaseType_t xUartSendString( const char *pcString, TickType_t xBlockTime );
+extern BaseType_t xUartSendZeroCopy( UartHandle_t xPort, const uint8_t *pucData, uint16_t usLength, UartTxCompleteCallback_t pxCallback, void *pvContext, TickType_t xBlockTime );
 
 /**
- * @brief Set callback function that is called when character is received from PC
- * @param pvCallbackFunction Callback function pointer
+ * @brief API for one task to read bytes received from PC
+ * @param xPort Port to read from, opened with usRxBufferSize above 0
+ * @param pucData Buffer where received bytes will be placed
+ * @param usLength Size of @p pucData
+ * @param pusReceived Set to the number of bytes placed in @p pucData
+ * @param xBlockTime Block time in ticks to wait if nothing was received
+ * @return pdPASS if at least one byte was read, pdFAIL if the time ran out
  *
- * If characters sent from PC need to be parsed, callback function can be implemented.
- * Function is executed in ISR context, so use only functions ending with FromISR.
+ * Bytes are buffered by the RX interrupt in the RX stream buffer; bytes that
+ * arrive while it is full are dropped and counted. With eUartFlowXonXoff XOFF
+ * is sent when the stream buffer is three quarters full and XON once this
+ * function has emptied it to a quarter; received XON and XOFF characters
+ * resume and stop transmission and are not placed in the stream buffer. Only
+ * one task per port may call this function. The stream buffer wakes it with
+ * its task notification, so it must not use the notification for anything
+ * else, xUartSendZeroCopy without a callback included.
+ */
+extern BaseType_t xUartReceive( UartHandle_t xPort, uint8_t *pucData, uint16_t usLength, uint16_t *pusReceived, TickType_t xBlockTime );
+
+/**
+ * @brief Check that every open port can keep its baud rate at a new SMCLK
+ * @param ulClockHz SMCLK frequency to check
+ * @return pdPASS if every open port reaches its rate within uartMAX_BAUD_ERROR
+ */
+extern BaseType_t xUartClockSupported( uint32_t ulClockHz );
+
+/**
+ * @brief Hold every open port before SMCLK changes
+ * @param xBlockTime Block time in ticks to wait for senders and for queued data to be sent
+ * @return pdPASS if every port is held, pdFAIL if the time ran out; no port is held then
+ *
+ * Takes the sender mutex of every open port and waits until all data queued on
+ * it has left the shift register, so no byte is sent while the clock changes.
+ * Must be followed by vUartClockChanged() from the same task. Until then every
+ * sender blocks, and one whose block time runs out first drops its bytes and
+ * counts them in usTxDropped; so the hold should be kept short. An XON or
+ * XOFF the RX interrupt decides on meanwhile is only sent after the change.
+ */
+extern BaseType_t xUartPrepareClockChange( TickType_t xBlockTime );
+
+/**
+ * @brief Retune and release every open port after SMCLK has changed
+ *
+ * The bit clock of every port is computed again for hal430GetSystemClock() and
+ * the senders may continue. A pending XON or XOFF is sent first. Bytes
+ * received while the clock changed may be lost or corrupted.
+ */
+extern void vUartClockChanged( void );
+
+/**
+ * @brief Check whether any open port is moving bits
+ * @return pdTRUE while a port transmits or receives a character, pdFALSE if not
+ *
+ * A port that only waits for received bytes or is stopped by XOFF is not busy.
+ * Called with interrupts disabled by the low power mode manager, which keeps
+ * SMCLK running while this returns pdTRUE.
+ */
+extern BaseType_t xUartIsBusy( void );
+
+/**
+ * @brief Get the bytes lost by a port
+ * @param xPort Open port, or NULL for the sum over every open port
+ * @param pxStats Set to the counts
  */
-extern void vUartSetRxCallback( ReceiveByteCallbackFunction_t pvCallbackFunction );
+extern void vUartGetStats( UartHandle_t xPort, UartStats_t *pxStats );
 
 #endif /* UART_H_ */
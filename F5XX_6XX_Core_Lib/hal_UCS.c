@@ -204,6 +204,20 @@ void Init_FLL_Settle(uint16_t fsystem, uint16_t ratio)
 
 }
 
+//====================================================================
+/**
+  * Initializes FLL of the UCS and returns without waiting
+  *
+  * \param fsystem  required system frequency (MCLK) in kHz
+  * \param ratio    ratio between MCLK and FLLREFCLK
+  */
+void Init_FLL_Start(uint16_t fsystem, uint16_t ratio)
+{
+  __bic_SR_register(SCG0);      // Enable FLL loop control, it has to stay on
+
+  Init_FLL(fsystem, ratio);
+}
+
 //====================================================================
 /**
   * Initializes FLL of the UCS
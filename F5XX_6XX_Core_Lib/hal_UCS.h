@@ -130,6 +130,18 @@ extern void XT2_Bypass(void);
   */
 extern void Init_FLL_Settle(uint16_t fsystem, uint16_t ratio);
 
+//====================================================================
+/**
+  * Initializes FLL of the UCS and returns without waiting
+  *
+  * The DCO reaches the frequency while the code goes on, after at most
+  * the time Init_FLL_Settle() would have waited.
+  *
+  * \param fsystem  required system frequency (MCLK) in kHz
+  * \param ratio    ratio between fsystem and FLLREFCLK
+  */
+extern void Init_FLL_Start(uint16_t fsystem, uint16_t ratio);
+
 
 //====================================================================
 /**
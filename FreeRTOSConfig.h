@@ -87,22 +87,36 @@
 #define configUSE_TICK_HOOK				1
 #define configCPU_CLOCK_HZ				( 10000000UL )
 #define configLFXT_CLOCK_HZ       		( 32768L )
+#define configXT2_CLOCK_HZ				( 25000000UL )
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES			( 8 )
 #define configTOTAL_HEAP_SIZE			( ( size_t ) ( 10 * 1024 ) )
+#define configUSE_TLSF_HEAP				1
+#define configUSE_HEAP_MAP				1
 #define configMAX_TASK_NAME_LEN			( 10 )
-#define configUSE_TRACE_FACILITY		0
+#define configUSE_TRACE_FACILITY		1
 #define configUSE_16_BIT_TICKS			1
 #define configIDLE_SHOULD_YIELD			1
 #define configUSE_MUTEXES				1
-#define configQUEUE_REGISTRY_SIZE		0
+#define configQUEUE_REGISTRY_SIZE		8
+#define configUSE_QUEUE_STATS			1
+#define configUSE_KEYED_QUEUES			1
+#define configMEMPOOL_MAX_POOLS			4
 #define configGENERATE_RUN_TIME_STATS	0
 #define configCHECK_FOR_STACK_OVERFLOW	2
+#define configRECORD_STACK_HIGH_ADDRESS	1
 #define configUSE_RECURSIVE_MUTEXES		1
 #define configUSE_MALLOC_FAILED_HOOK	1
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
 
+/* The idle task picks its low power mode in vLpmSleep(), see lpm.h. The tick
+keeps running, 2 only tells the kernel that the port provides no tickless
+idle of its own. TickType_t is uint16_t with 16-bit ticks. */
+#define configUSE_TICKLESS_IDLE			2
+extern void vLpmSleep( uint16_t xExpectedIdleTime );
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vLpmSleep( xExpectedIdleTime )
+
 #ifdef __LARGE_DATA_MODEL__
 	#define configMINIMAL_STACK_SIZE		( ( unsigned short ) 80 )
 #else
@@ -123,11 +137,13 @@
 to exclude the API function. */
 #define INCLUDE_vTaskPrioritySet		0
 #define INCLUDE_uxTaskPriorityGet		0
-#define INCLUDE_vTaskDelete				0
+#define INCLUDE_vTaskDelete				1
 #define INCLUDE_vTaskCleanUpResources	0
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_xTaskGetIdleTaskHandle	1
+#define INCLUDE_xTimerPendFunctionCall	1
 
 /* The MSP430X port uses a callback function to configure its tick interrupt.
 This allows the application to choose the tick interrupt source.
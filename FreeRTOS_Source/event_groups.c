@@ -176,7 +176,7 @@ static BaseType_t prvTestWaitCondition( const EventBits_t uxCurrentEventBits, co
 	EventGroup_t *pxEventBits;
 
 		/* Allocate the event group. */
-		pxEventBits = ( EventGroup_t * ) pvPortMalloc( sizeof( EventGroup_t ) );
+		pxEventBits = ( EventGroup_t * ) portMALLOC_TAGGED( sizeof( EventGroup_t ), eHeapTagEventGroup );
 
 		if( pxEventBits != NULL )
 		{
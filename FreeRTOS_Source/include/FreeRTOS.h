@@ -408,6 +408,10 @@ extern "C" {
 	#define configCHECK_FOR_STACK_OVERFLOW 0
 #endif
 
+#ifndef configRECORD_STACK_HIGH_ADDRESS
+	#define configRECORD_STACK_HIGH_ADDRESS 0
+#endif
+
 /* The following event macros are embedded in the kernel API calls. */
 
 #ifndef traceMOVED_TASK_TO_READY_STATE
@@ -720,6 +724,26 @@ extern "C" {
 	#define configUSE_QUEUE_SETS 0
 #endif
 
+#ifndef configUSE_QUEUE_STATS
+	#define configUSE_QUEUE_STATS 0
+#endif
+
+#ifndef configUSE_KEYED_QUEUES
+	#define configUSE_KEYED_QUEUES 0
+#endif
+
+#ifndef configUSE_TLSF_HEAP
+	#define configUSE_TLSF_HEAP 0
+#endif
+
+#ifndef configUSE_HEAP_MAP
+	#define configUSE_HEAP_MAP 0
+#endif
+
+#ifndef configMEMPOOL_MAX_POOLS
+	#define configMEMPOOL_MAX_POOLS 4
+#endif
+
 #ifndef portTASK_USES_FLOATING_POINT
 	#define portTASK_USES_FLOATING_POINT()
 #endif
@@ -917,7 +941,7 @@ typedef struct xSTATIC_TCB
 	UBaseType_t			uxDummy5;
 	void				*pxDummy6;
 	uint8_t				ucDummy7[ configMAX_TASK_NAME_LEN ];
-	#if ( portSTACK_GROWTH > 0 )
+	#if ( ( portSTACK_GROWTH > 0 ) || ( configRECORD_STACK_HIGH_ADDRESS == 1 ) )
 		void			*pxDummy8;
 	#endif
 	#if ( portCRITICAL_NESTING_IN_TCB == 1 )
@@ -948,6 +972,9 @@ typedef struct xSTATIC_TCB
 	#if( ( configSUPPORT_STATIC_ALLOCATION == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
 		uint8_t			uxDummy20;
 	#endif
+	#if( configUSE_KEYED_QUEUES == 1 )
+		UBaseType_t		uxDummy21;
+	#endif
 
 } StaticTask_t;
 
@@ -992,6 +1019,17 @@ typedef struct xSTATIC_QUEUE
 		uint8_t ucDummy9;
 	#endif
 
+	#if ( configUSE_QUEUE_STATS == 1 )
+		UBaseType_t uxDummy10;
+		TickType_t xDummy11;
+		uint32_t ulDummy12[ 7 ];
+	#endif
+
+	#if ( configUSE_KEYED_QUEUES == 1 )
+		UBaseType_t uxDummy13;
+		uint8_t ucDummy14;
+	#endif
+
 } StaticQueue_t;
 typedef StaticQueue_t StaticSemaphore_t;
 
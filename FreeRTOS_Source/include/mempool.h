@@ -0,0 +1,160 @@
+/*
+ * Fixed block memory pools.
+ *
+ * A memory pool hands out blocks of one fixed size from storage that is
+ * obtained with pvPortMalloc() once, when the pool is created.  Allocating and
+ * freeing a block take a constant time, never fragment the heap and can be
+ * done from interrupts, which makes pools suitable for the hot path even when
+ * the heap itself can never free memory (heap_1).
+ *
+ * Each pool created is also registered as a size class.  pvMemPoolMalloc()
+ * takes a block from the smallest size class that can hold the requested
+ * number of bytes, moving to the next larger class when a class is empty, and
+ * vMemPoolFree() returns a block to whichever pool it came from.  The number
+ * of size classes is limited to configMEMPOOL_MAX_POOLS, so the search is
+ * bounded.
+ *
+ *    1 tab == 4 spaces!
+ */
+
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h" must appear in source files before "include mempool.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Type by which memory pools are referenced.  For example, a call to
+ * xMemPoolCreate() returns a MemPoolHandle_t variable that can then be used as
+ * a parameter to pvMemPoolAlloc(), vMemPoolFree(), etc.
+ */
+typedef void * MemPoolHandle_t;
+
+/*
+ * Usage statistics of a memory pool, returned by vMemPoolGetStats().
+ */
+typedef struct xMEMPOOL_STATS
+{
+	const char *pcName;				/*< Name the pool was created with. */
+	size_t xBlockSize;				/*< Usable size of each block in bytes, after alignment. */
+	UBaseType_t uxBlockCount;		/*< Number of blocks in the pool. */
+	UBaseType_t uxBlocksFree;		/*< Number of blocks currently free. */
+	UBaseType_t uxMinimumBlocksFree;/*< The lowest number of free blocks since the pool was created. */
+	uint32_t ulAllocations;			/*< Number of successful allocations. */
+	uint32_t ulAllocFailures;		/*< Number of allocations that found the pool empty. */
+} MemPoolStats_t;
+
+/**
+ * mempool. h
+ * <pre>
+ MemPoolHandle_t xMemPoolCreate( const char *pcName, size_t xBlockSize, UBaseType_t uxBlockCount );
+ </pre>
+ *
+ * Create a memory pool and register it as a size class.  The pool control
+ * structure and the storage for all the blocks are obtained from the heap with
+ * a single call to pvPortMalloc().
+ *
+ * @param pcName A descriptive name for the pool, reported by
+ * vMemPoolGetStats().
+ *
+ * @param xBlockSize The number of bytes each block must hold.  The size is
+ * rounded up to a multiple of portBYTE_ALIGNMENT and to at least the size of a
+ * pointer, as free blocks hold the link to the next free block.
+ *
+ * @param uxBlockCount The number of blocks in the pool.
+ *
+ * @return The handle of the pool, or NULL if the heap could not supply the
+ * storage or configMEMPOOL_MAX_POOLS pools already exist.
+ */
+MemPoolHandle_t xMemPoolCreate( const char *pcName, size_t xBlockSize, UBaseType_t uxBlockCount ) PRIVILEGED_FUNCTION;
+
+/**
+ * mempool. h
+ * <pre>
+ void *pvMemPoolAlloc( MemPoolHandle_t xPool );
+ </pre>
+ *
+ * Take a block from a specific pool.  Must not be called from an interrupt,
+ * use pvMemPoolAllocFromISR() instead.
+ *
+ * @param xPool The pool to take the block from.
+ *
+ * @return A pointer to the block, or NULL if the pool is empty.  The call
+ * never blocks.
+ */
+void *pvMemPoolAlloc( MemPoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+void *pvMemPoolAllocFromISR( MemPoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * mempool. h
+ * <pre>
+ void *pvMemPoolMalloc( size_t xWantedSize );
+ </pre>
+ *
+ * Take a block from the smallest size class that can hold xWantedSize bytes.
+ * When that class is empty the next larger class is tried.  Must not be called
+ * from an interrupt, use pvMemPoolMallocFromISR() instead.
+ *
+ * @param xWantedSize The number of bytes required.
+ *
+ * @return A pointer to the block, or NULL if no class large enough has a free
+ * block.  A NULL return is counted in the ulAllocFailures of the smallest
+ * class large enough.
+ */
+void *pvMemPoolMalloc( size_t xWantedSize ) PRIVILEGED_FUNCTION;
+void *pvMemPoolMallocFromISR( size_t xWantedSize ) PRIVILEGED_FUNCTION;
+
+/**
+ * mempool. h
+ * <pre>
+ void vMemPoolFree( void *pvBlock );
+ </pre>
+ *
+ * Return a block to the pool it was taken from, whether it was obtained with
+ * pvMemPoolAlloc() or pvMemPoolMalloc().  The pool is found from the address
+ * of the block.  Must not be called from an interrupt, use
+ * vMemPoolFreeFromISR() instead.
+ *
+ * @param pvBlock The block to return.  NULL is ignored.
+ */
+void vMemPoolFree( void *pvBlock ) PRIVILEGED_FUNCTION;
+void vMemPoolFreeFromISR( void *pvBlock ) PRIVILEGED_FUNCTION;
+
+/**
+ * mempool. h
+ * <pre>
+ void vMemPoolGetStats( MemPoolHandle_t xPool, MemPoolStats_t *pxStats );
+ </pre>
+ *
+ * Take a consistent snapshot of the usage of a pool.
+ *
+ * @param xPool The pool being queried.
+ *
+ * @param pxStats Structure into which the statistics are copied.
+ */
+void vMemPoolGetStats( MemPoolHandle_t xPool, MemPoolStats_t *pxStats ) PRIVILEGED_FUNCTION;
+
+/**
+ * mempool. h
+ * <pre>
+ MemPoolHandle_t xMemPoolGetHandle( UBaseType_t uxIndex );
+ </pre>
+ *
+ * Walk the registered size classes, for example to report on all of them.
+ *
+ * @param uxIndex Index of the class, 0 being the smallest block size.
+ *
+ * @return The handle of the pool, or NULL if uxIndex is past the last class.
+ */
+MemPoolHandle_t xMemPoolGetHandle( UBaseType_t uxIndex ) PRIVILEGED_FUNCTION;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMPOOL_H */
@@ -0,0 +1,130 @@
+/*
+ * Message buffers.
+ *
+ * A message buffer is a stream buffer, see stream_buffer.h, in which every
+ * message is stored behind a size_t holding its length.  A write either
+ * stores the whole message or nothing, and a read returns exactly one
+ * message, so variable length messages pass from one writer to one reader
+ * without being split or merged.  Each message takes sizeof( size_t ) bytes
+ * of the buffer in addition to its own length.
+ *
+ * The same restrictions as for stream buffers apply: one writer, one reader,
+ * and blocked tasks are unblocked through their task notification.
+ *
+ *    1 tab == 4 spaces!
+ */
+
+#ifndef MESSAGE_BUFFER_H
+#define MESSAGE_BUFFER_H
+
+/* Message buffers are built on top of stream buffers. */
+#include "stream_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Type by which message buffers are referenced.  A message buffer handle is
+ * a stream buffer handle, but must only be used with the xMessageBuffer...
+ * macros below.
+ */
+typedef void * MessageBufferHandle_t;
+
+/**
+ * message_buffer.h
+ * <pre>
+ MessageBufferHandle_t xMessageBufferCreate( size_t xBufferSizeBytes );
+ </pre>
+ *
+ * Create a message buffer able to hold xBufferSizeBytes bytes, the length
+ * stored with each message included.
+ *
+ * @return The handle of the message buffer, or NULL if the heap could not
+ * supply the memory.
+ *
+ * \defgroup xMessageBufferCreate xMessageBufferCreate
+ * \ingroup MessageBufferManagement
+ */
+#define xMessageBufferCreate( xBufferSizeBytes ) ( MessageBufferHandle_t ) xStreamBufferGenericCreate( ( xBufferSizeBytes ), ( size_t ) 0, pdTRUE )
+
+/**
+ * message_buffer.h
+ * <pre>
+ size_t xMessageBufferSend( MessageBufferHandle_t xMessageBuffer,
+							const void *pvTxData,
+							size_t xDataLengthBytes,
+							TickType_t xTicksToWait );
+ </pre>
+ *
+ * Write one message.  If there is not enough space for the message and its
+ * length the task blocks until there is, or until xTicksToWait ticks have
+ * passed.  xMessageBufferSendFromISR() is the version that can be called from
+ * an interrupt, it never blocks.
+ *
+ * @return xDataLengthBytes if the message was written, 0 if there was not
+ * enough space.
+ *
+ * \defgroup xMessageBufferSend xMessageBufferSend
+ * \ingroup MessageBufferManagement
+ */
+#define xMessageBufferSend( xMessageBuffer, pvTxData, xDataLengthBytes, xTicksToWait ) xStreamBufferSend( ( StreamBufferHandle_t ) ( xMessageBuffer ), ( pvTxData ), ( xDataLengthBytes ), ( xTicksToWait ) )
+#define xMessageBufferSendFromISR( xMessageBuffer, pvTxData, xDataLengthBytes, pxHigherPriorityTaskWoken ) xStreamBufferSendFromISR( ( StreamBufferHandle_t ) ( xMessageBuffer ), ( pvTxData ), ( xDataLengthBytes ), ( pxHigherPriorityTaskWoken ) )
+
+/**
+ * message_buffer.h
+ * <pre>
+ size_t xMessageBufferReceive( MessageBufferHandle_t xMessageBuffer,
+							   void *pvRxData,
+							   size_t xBufferLengthBytes,
+							   TickType_t xTicksToWait );
+ </pre>
+ *
+ * Read the oldest message.  If the message buffer is empty the task blocks
+ * until a message arrives, or until xTicksToWait ticks have passed.
+ * xMessageBufferReceiveFromISR() is the version that can be called from an
+ * interrupt, it never blocks.
+ *
+ * @return The length of the message read, 0 if there was no message or if
+ * the message is longer than xBufferLengthBytes, in which case it is left in
+ * the message buffer.
+ *
+ * \defgroup xMessageBufferReceive xMessageBufferReceive
+ * \ingroup MessageBufferManagement
+ */
+#define xMessageBufferReceive( xMessageBuffer, pvRxData, xBufferLengthBytes, xTicksToWait ) xStreamBufferReceive( ( StreamBufferHandle_t ) ( xMessageBuffer ), ( pvRxData ), ( xBufferLengthBytes ), ( xTicksToWait ) )
+#define xMessageBufferReceiveFromISR( xMessageBuffer, pvRxData, xBufferLengthBytes, pxHigherPriorityTaskWoken ) xStreamBufferReceiveFromISR( ( StreamBufferHandle_t ) ( xMessageBuffer ), ( pvRxData ), ( xBufferLengthBytes ), ( pxHigherPriorityTaskWoken ) )
+
+/**
+ * message_buffer.h
+ * <pre>
+ size_t xMessageBufferNextLengthBytes( MessageBufferHandle_t xMessageBuffer );
+ </pre>
+ *
+ * @return The length of the oldest message, 0 if the message buffer is empty.
+ *
+ * \defgroup xMessageBufferNextLengthBytes xMessageBufferNextLengthBytes
+ * \ingroup MessageBufferManagement
+ */
+#define xMessageBufferNextLengthBytes( xMessageBuffer ) xStreamBufferNextMessageLengthBytes( ( StreamBufferHandle_t ) ( xMessageBuffer ) )
+
+/**
+ * message_buffer.h
+ *
+ * The remaining operations are those of the underlying stream buffer.
+ * xMessageBufferSpacesAvailable() includes the space taken by the length of
+ * the next message written.
+ *
+ * \ingroup MessageBufferManagement
+ */
+#define vMessageBufferDelete( xMessageBuffer ) vStreamBufferDelete( ( StreamBufferHandle_t ) ( xMessageBuffer ) )
+#define xMessageBufferReset( xMessageBuffer ) xStreamBufferReset( ( StreamBufferHandle_t ) ( xMessageBuffer ) )
+#define xMessageBufferSpacesAvailable( xMessageBuffer ) xStreamBufferSpacesAvailable( ( StreamBufferHandle_t ) ( xMessageBuffer ) )
+#define xMessageBufferIsEmpty( xMessageBuffer ) xStreamBufferIsEmpty( ( StreamBufferHandle_t ) ( xMessageBuffer ) )
+#define xMessageBufferIsFull( xMessageBuffer ) xStreamBufferIsFull( ( StreamBufferHandle_t ) ( xMessageBuffer ) )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MESSAGE_BUFFER_H */
@@ -174,6 +174,47 @@ void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * Allocation map, available when configUSE_HEAP_MAP is set to 1.  Every block
+ * is tagged with the kind of object it was allocated for, so the use of the
+ * heap can be broken down without walking the kernel's own lists.
+ */
+typedef enum
+{
+	eHeapTagOther = 0,		/* Allocated by the application with pvPortMalloc(). */
+	eHeapTagTCB,			/* Task control block. */
+	eHeapTagStack,			/* Task stack. */
+	eHeapTagQueue,			/* Queue structure and storage area. */
+	eHeapTagSemaphore,		/* Semaphore or mutex. */
+	eHeapTagTimer,			/* Software timer. */
+	eHeapTagEventGroup,		/* Event group. */
+	eHeapTagRingBuffer,		/* Ring buffer structure and storage. */
+	eHeapTagMemPool,		/* Memory pool, all its blocks included. */
+	eHeapTagStreamBuffer,	/* Stream or message buffer structure and storage. */
+	eHeapTagCount
+} HeapTag_t;
+
+typedef struct xHEAP_MAP
+{
+	size_t xTagBytes[ eHeapTagCount ];			/*< Bytes requested by each kind of object. */
+	UBaseType_t uxTagBlocks[ eHeapTagCount ];	/*< Number of allocations made for each kind of object. */
+	size_t xFreeBytes;							/*< Bytes held by free blocks, as xPortGetFreeHeapSize(). */
+	UBaseType_t uxFreeBlocks;					/*< Number of free blocks. */
+	size_t xLargestFreeBlock;					/*< Size of the largest free block; the good-fit search rounds requests up, so one this large can still fail. */
+	size_t xSlackBytes;							/*< Bytes allocated but not requested, lost to alignment and to remainders too small to split. */
+	size_t xOverheadBytes;						/*< Bytes used by block headers and the alignment of the heap itself. */
+	size_t xHeapSize;							/*< configTOTAL_HEAP_SIZE; the fields above add up to it. */
+} HeapMap_t;
+
+#if( configUSE_HEAP_MAP == 1 )
+	void *pvPortMallocTagged( size_t xSize, HeapTag_t eTag ) PRIVILEGED_FUNCTION;
+	void vPortGetHeapMap( HeapMap_t *pxHeapMap ) PRIVILEGED_FUNCTION;
+	const char *pcPortGetHeapTagName( HeapTag_t eTag ) PRIVILEGED_FUNCTION;
+	#define portMALLOC_TAGGED( xSize, eTag )	pvPortMallocTagged( ( xSize ), ( eTag ) )
+#else
+	#define portMALLOC_TAGGED( xSize, eTag )	pvPortMalloc( xSize )
+#endif
+
 /*
  * Setup the hardware ready for the scheduler to take control.  This generally
  * sets up a tick interrupt and sets timers for the correct tick frequency.
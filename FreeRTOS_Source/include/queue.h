@@ -1529,6 +1529,231 @@ BaseType_t xQueueGiveFromISR( QueueHandle_t xQueue, BaseType_t * const pxHigherP
  */
 BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue, void * const pvBuffer, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
 
+/**
+ * queue. h
+ * <pre>
+ UBaseType_t xQueueSendMultiple(
+								   QueueHandle_t xQueue,
+								   const void *pvItems,
+								   UBaseType_t uxCount,
+								   TickType_t xTicksToWait
+							   );
+ * </pre>
+ *
+ * Post up to uxCount items to the back of a queue in one call.  The items are
+ * copied inside a single critical section, with at most two calls to memcpy(),
+ * and the queue is updated and a waiting task woken once rather than once per
+ * item, so batching items amortises the kernel overhead of xQueueSend().
+ *
+ * As many items as there is room for are posted.  The call only blocks while
+ * the queue is completely full, so a partial send returns immediately and the
+ * caller posts the remaining items with another call if required.
+ *
+ * The queue must hold items, not be a semaphore or a mutex, and must not be
+ * a member of a queue set.  This function must not be called from an
+ * interrupt, see xQueueSendMultipleFromISR().
+ *
+ * @param xQueue The handle to the queue on which the items are to be posted.
+ *
+ * @param pvItems Pointer to an array of items, each of the size the queue
+ * was created with.
+ *
+ * @param uxCount The number of items in the array.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for space to become available on the queue.
+ *
+ * @return The number of items posted, the first ones of the array.  0 if the
+ * queue stayed full for xTicksToWait ticks.
+ *
+ * \defgroup xQueueSendMultiple xQueueSendMultiple
+ * \ingroup QueueManagement
+ */
+UBaseType_t xQueueSendMultiple( QueueHandle_t xQueue, const void * const pvItems, const UBaseType_t uxCount, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ UBaseType_t xQueueSendMultipleFromISR(
+										  QueueHandle_t xQueue,
+										  const void *pvItems,
+										  UBaseType_t uxCount,
+										  BaseType_t *pxHigherPriorityTaskWoken
+									  );
+ * </pre>
+ *
+ * Version of xQueueSendMultiple() that can be called from an interrupt
+ * service routine.  It never blocks.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if posting the items
+ * unblocked a task with a priority higher than that of the running task.
+ *
+ * @return The number of items posted, 0 if the queue was full.
+ *
+ * \defgroup xQueueSendMultipleFromISR xQueueSendMultipleFromISR
+ * \ingroup QueueManagement
+ */
+UBaseType_t xQueueSendMultipleFromISR( QueueHandle_t xQueue, const void * const pvItems, const UBaseType_t uxCount, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ UBaseType_t xQueueReceiveMultiple(
+									  QueueHandle_t xQueue,
+									  void *pvBuffer,
+									  UBaseType_t uxMaxCount,
+									  TickType_t xTicksToWait
+								  );
+ * </pre>
+ *
+ * Receive up to uxMaxCount items from a queue in one call, oldest first.
+ * Like xQueueSendMultiple() the items are copied inside a single critical
+ * section and a task waiting for space is woken once.
+ *
+ * The call blocks only while the queue is empty.  As soon as it holds at
+ * least one item everything that is available, up to uxMaxCount items, is
+ * returned without waiting for more.
+ *
+ * @param xQueue The handle to the queue from which the items are received.
+ *
+ * @param pvBuffer Buffer with room for uxMaxCount items.
+ *
+ * @param uxMaxCount The largest number of items to receive.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for an item to arrive.
+ *
+ * @return The number of items copied to pvBuffer, 0 if the queue stayed empty
+ * for xTicksToWait ticks.
+ *
+ * \defgroup xQueueReceiveMultiple xQueueReceiveMultiple
+ * \ingroup QueueManagement
+ */
+UBaseType_t xQueueReceiveMultiple( QueueHandle_t xQueue, void * const pvBuffer, const UBaseType_t uxMaxCount, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ UBaseType_t xQueueReceiveMultipleFromISR(
+											 QueueHandle_t xQueue,
+											 void *pvBuffer,
+											 UBaseType_t uxMaxCount,
+											 BaseType_t *pxHigherPriorityTaskWoken
+										 );
+ * </pre>
+ *
+ * Version of xQueueReceiveMultiple() that can be called from an interrupt
+ * service routine.  It never blocks.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if removing the items
+ * unblocked a task with a priority higher than that of the running task.
+ *
+ * @return The number of items copied to pvBuffer, 0 if the queue was empty.
+ *
+ * \defgroup xQueueReceiveMultipleFromISR xQueueReceiveMultipleFromISR
+ * \ingroup QueueManagement
+ */
+UBaseType_t xQueueReceiveMultipleFromISR( QueueHandle_t xQueue, void * const pvBuffer, const UBaseType_t uxMaxCount, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ void vQueueSetKeyField( QueueHandle_t xQueue, UBaseType_t uxKeyOffset, UBaseType_t uxKeySize );
+ </pre>
+ *
+ * Make a queue keyed.  Every item of a keyed queue carries a key, a field of
+ * 1, 2 or 4 bytes at a fixed offset within the item, for example the channel
+ * of a sample, and items are taken from the queue with xQueueReceiveKeyed()
+ * by the task that wants that key.  Items are still posted with the normal
+ * send functions.
+ *
+ * Must be called once, after the queue is created and before any task uses
+ * it.  Once a queue is keyed it must not be read with xQueueReceive(),
+ * xQueuePeek(), xQueueReceiveFromISR() or xQueueReceiveMultiple(), and it
+ * cannot be added to a queue set.
+ *
+ * configUSE_KEYED_QUEUES must be set to 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ *
+ * @param xQueue The queue to make keyed.
+ *
+ * @param uxKeyOffset Offset of the key field in bytes, from the start of the
+ * item.  offsetof() can be used to obtain it.
+ *
+ * @param uxKeySize Size of the key field in bytes, 1, 2 or 4.  Keys are
+ * compared as UBaseType_t values, so wider keys are truncated.
+ *
+ * \defgroup vQueueSetKeyField vQueueSetKeyField
+ * \ingroup QueueManagement
+ */
+void vQueueSetKeyField( QueueHandle_t xQueue, const UBaseType_t uxKeyOffset, const UBaseType_t uxKeySize ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ BaseType_t xQueueReceiveKeyed(
+								  QueueHandle_t xQueue,
+								  void *pvBuffer,
+								  UBaseType_t uxKey,
+								  TickType_t xTicksToWait
+							  );
+ * </pre>
+ *
+ * Receive the oldest item with the key uxKey from a keyed queue.  Finding and
+ * removing the item is a single atomic operation, items before it keep their
+ * order and items with other keys are left for the tasks that want them.
+ *
+ * If the queue holds no item with the key the task blocks.  Posting an item
+ * unblocks only the highest priority task waiting for its key, so tasks
+ * waiting for other keys are not woken only to block again.
+ *
+ * Removing an item that is not the oldest moves the items that were queued
+ * before it up by one place, so the cost grows with its position.
+ *
+ * configUSE_KEYED_QUEUES must be set to 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ *
+ * @param xQueue The handle to a queue made keyed by vQueueSetKeyField().
+ *
+ * @param pvBuffer Pointer to the buffer into which the item will be copied.
+ *
+ * @param uxKey The key of the item wanted.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for an item with the key.
+ *
+ * @return pdTRUE if an item was received, otherwise pdFALSE.
+ *
+ * Example usage:
+   <pre>
+ typedef struct
+ {
+	uint16_t usChannel;
+	uint16_t usValue;
+ } Sample_t;
+
+ void vCreateSampleQueue( void )
+ {
+	xSampleQueue = xQueueCreate( 16, sizeof( Sample_t ) );
+	vQueueSetKeyField( xSampleQueue, offsetof( Sample_t, usChannel ), sizeof( uint16_t ) );
+ }
+
+ void vChannel3Task( void *pvParameters )
+ {
+ Sample_t xSample;
+
+	for( ;; )
+	{
+		// Only samples of channel 3 are received here.
+		xQueueReceiveKeyed( xSampleQueue, &xSample, 3, portMAX_DELAY );
+	}
+ }
+ </pre>
+ * \defgroup xQueueReceiveKeyed xQueueReceiveKeyed
+ * \ingroup QueueManagement
+ */
+BaseType_t xQueueReceiveKeyed( QueueHandle_t xQueue, void * const pvBuffer, const UBaseType_t uxKey, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
 /*
  * Utilities to query queues that are safe to use from an ISR.  These utilities
  * should be used only from witin an ISR, or within a critical section.
@@ -1630,6 +1855,75 @@ BaseType_t xQueueGiveMutexRecursive( QueueHandle_t pxMutex ) PRIVILEGED_FUNCTION
 	const char *pcQueueGetName( QueueHandle_t xQueue ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 #endif
 
+#if( configUSE_QUEUE_STATS == 1 )
+
+/*
+ * Snapshot of the health counters kept for each queue when
+ * configUSE_QUEUE_STATS is set to 1 in FreeRTOSConfig.h.  The counters are
+ * updated from inside the critical sections that already guard the queue, or
+ * with the scheduler suspended for the counters only tasks change, so they
+ * add only a few increments to the send and receive paths.
+ */
+typedef struct xQUEUE_STATS
+{
+	UBaseType_t uxMessagesWaitingHighWater;	/*< The largest number of items ever held in the queue at one time. */
+	uint32_t ulSendFailures;				/*< Number of task level sends that returned errQUEUE_FULL. */
+	uint32_t ulSendFailuresFromISR;			/*< Number of sends from an interrupt that returned errQUEUE_FULL - each one is a lost item. */
+	uint32_t ulSendersBlocked;				/*< Number of times a task blocked because the queue was full. */
+	uint32_t ulReceiversBlocked;			/*< Number of times a task blocked because the queue was empty. */
+	uint32_t ulItemsRemoved;				/*< Number of items that have left the queue. */
+	TickType_t xAverageResidency;			/*< Average number of ticks an item spent in the queue before it was removed, weighted towards recent items once the integral behind it has been halved. */
+} QueueStats_t;
+
+/**
+ * queue. h
+ * <pre>
+ void vQueueGetStats( QueueHandle_t xQueue, QueueStats_t *pxStats );
+ </pre>
+ *
+ * Take a consistent snapshot of the health counters of a queue, semaphore or
+ * mutex.  The average residency is derived from the time integral of the
+ * queue depth divided by the number of items removed (Little's law), so no
+ * per item time stamp needs to be stored.
+ *
+ * @param xQueue The handle of the queue being queried.
+ *
+ * @param pxStats Structure into which the counters are copied.
+ */
+void vQueueGetStats( QueueHandle_t xQueue, QueueStats_t *pxStats ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ void vQueueResetStats( QueueHandle_t xQueue );
+ </pre>
+ *
+ * Clear the health counters of a queue.  The high water mark is set back to
+ * the number of items the queue holds at the time of the call.
+ *
+ * @param xQueue The handle of the queue the counters of which are cleared.
+ */
+void vQueueResetStats( QueueHandle_t xQueue ) PRIVILEGED_FUNCTION;
+
+/*
+ * Return the health counters of the queue held in slot uxIndex of the queue
+ * registry.  This allows a monitor to report on every named queue without
+ * needing access to the queue handles.
+ *
+ * @param uxIndex Registry slot to query, from 0 to configQUEUE_REGISTRY_SIZE - 1.
+ *
+ * @param ppcQueueName Set to the name the queue was registered with.
+ *
+ * @param pxStats Structure into which the counters are copied.
+ *
+ * @return pdPASS if the slot holds a queue, otherwise pdFAIL.
+ */
+#if( configQUEUE_REGISTRY_SIZE > 0 )
+	BaseType_t xQueueGetRegistryStats( UBaseType_t uxIndex, const char **ppcQueueName, QueueStats_t *pxStats ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#endif
+
+#endif /* configUSE_QUEUE_STATS */
+
 /*
  * Generic version of the function used to creaet a queue using dynamic memory
  * allocation.  This is called by other functions and macros that create other
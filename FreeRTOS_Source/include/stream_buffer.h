@@ -0,0 +1,257 @@
+/*
+ * Stream buffers.
+ *
+ * A stream buffer passes a stream of bytes from one writer, a task or an
+ * interrupt, to one reader, a task or an interrupt.  Data is copied in and out
+ * with memcpy(), so any number of bytes is moved by a single call, and a task
+ * blocked on a stream buffer is unblocked with a direct to task notification
+ * rather than through an event list.
+ *
+ * Because there is only one writer and one reader the buffer itself is not
+ * protected by a critical section.  If there can be more than one writer, or
+ * more than one reader, the calls must be serialised by the application, for
+ * example by writing from one task only.
+ *
+ * A message buffer, see message_buffer.h, is a stream buffer in which every
+ * write is stored with its length, so the reader receives the data in the
+ * same discrete messages it was written in.
+ *
+ * Stream buffers use the task notification of the blocked task, so they must
+ * not be used by a task that also waits on its notification for another
+ * purpose.
+ *
+ *    1 tab == 4 spaces!
+ */
+
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h" must appear in source files before "include stream_buffer.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Type by which stream buffers are referenced.  For example, a call to
+ * xStreamBufferCreate() returns a StreamBufferHandle_t variable that can then
+ * be used as a parameter to xStreamBufferSend(), xStreamBufferReceive(), etc.
+ */
+typedef void * StreamBufferHandle_t;
+
+/**
+ * stream_buffer.h
+ * <pre>
+ StreamBufferHandle_t xStreamBufferCreate( size_t xBufferSizeBytes, size_t xTriggerLevelBytes );
+ </pre>
+ *
+ * Create a stream buffer.  The control structure and the storage area are
+ * obtained from the heap with a single call to pvPortMalloc().
+ *
+ * @param xBufferSizeBytes The total number of bytes the stream buffer can hold
+ * at any one time.
+ *
+ * @param xTriggerLevelBytes The number of bytes that must be in the stream
+ * buffer before a task blocked in xStreamBufferReceive() is unblocked.  A
+ * trigger level of 1 unblocks the task as soon as one byte is written, a
+ * larger level lets the reader collect several writes before it runs.  A
+ * trigger level of 0 is treated as 1.  The reader is also unblocked when its
+ * block time expires, whatever the number of bytes in the buffer.
+ *
+ * @return The handle of the stream buffer, or NULL if the heap could not
+ * supply the memory.
+ *
+ * \defgroup xStreamBufferCreate xStreamBufferCreate
+ * \ingroup StreamBufferManagement
+ */
+#define xStreamBufferCreate( xBufferSizeBytes, xTriggerLevelBytes ) xStreamBufferGenericCreate( ( xBufferSizeBytes ), ( xTriggerLevelBytes ), pdFALSE )
+
+/**
+ * stream_buffer.h
+ * <pre>
+ size_t xStreamBufferSend( StreamBufferHandle_t xStreamBuffer,
+						   const void *pvTxData,
+						   size_t xDataLengthBytes,
+						   TickType_t xTicksToWait );
+ </pre>
+ *
+ * Write bytes to a stream buffer.  Must not be called from an interrupt, use
+ * xStreamBufferSendFromISR() instead.
+ *
+ * If there is not enough space for all the bytes the task blocks until there
+ * is, or until xTicksToWait ticks have passed, in which case as many bytes as
+ * fit are written.  More bytes than the buffer can hold are never waited
+ * for: the task waits only until the buffer is empty and then writes as many
+ * as fit.
+ *
+ * @param xStreamBuffer The stream buffer to write to.
+ *
+ * @param pvTxData The bytes to write.
+ *
+ * @param xDataLengthBytes The number of bytes to write.
+ *
+ * @param xTicksToWait The maximum amount of time the task should wait for
+ * space to become available.
+ *
+ * @return The number of bytes written, which can be less than
+ * xDataLengthBytes if the block time expired.
+ *
+ * \defgroup xStreamBufferSend xStreamBufferSend
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferSend( StreamBufferHandle_t xStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ * <pre>
+ size_t xStreamBufferSendFromISR( StreamBufferHandle_t xStreamBuffer,
+								  const void *pvTxData,
+								  size_t xDataLengthBytes,
+								  BaseType_t *pxHigherPriorityTaskWoken );
+ </pre>
+ *
+ * Version of xStreamBufferSend() that can be called from an interrupt.  As
+ * many bytes as fit are written, the call never blocks.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if writing the bytes
+ * unblocked a task with a priority higher than that of the running task.
+ *
+ * @return The number of bytes written.
+ *
+ * \defgroup xStreamBufferSendFromISR xStreamBufferSendFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferSendFromISR( StreamBufferHandle_t xStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ * <pre>
+ size_t xStreamBufferReceive( StreamBufferHandle_t xStreamBuffer,
+							  void *pvRxData,
+							  size_t xBufferLengthBytes,
+							  TickType_t xTicksToWait );
+ </pre>
+ *
+ * Read bytes from a stream buffer.  Must not be called from an interrupt, use
+ * xStreamBufferReceiveFromISR() instead.
+ *
+ * If the stream buffer is empty the task blocks until the number of bytes in
+ * it reaches the trigger level, or until xTicksToWait ticks have passed.
+ *
+ * @param xStreamBuffer The stream buffer to read from.
+ *
+ * @param pvRxData Buffer into which the bytes are copied.
+ *
+ * @param xBufferLengthBytes The size of pvRxData, which is the largest number
+ * of bytes read by one call.
+ *
+ * @param xTicksToWait The maximum amount of time the task should wait for
+ * data if the stream buffer is empty.
+ *
+ * @return The number of bytes read, 0 if the block time expired with the
+ * buffer still empty.
+ *
+ * \defgroup xStreamBufferReceive xStreamBufferReceive
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReceive( StreamBufferHandle_t xStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ * <pre>
+ size_t xStreamBufferReceiveFromISR( StreamBufferHandle_t xStreamBuffer,
+									 void *pvRxData,
+									 size_t xBufferLengthBytes,
+									 BaseType_t *pxHigherPriorityTaskWoken );
+ </pre>
+ *
+ * Version of xStreamBufferReceive() that can be called from an interrupt.
+ * The call never blocks.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if reading the bytes
+ * unblocked a task with a priority higher than that of the running task.
+ *
+ * @return The number of bytes read.
+ *
+ * \defgroup xStreamBufferReceiveFromISR xStreamBufferReceiveFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReceiveFromISR( StreamBufferHandle_t xStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ * <pre>
+ void vStreamBufferDelete( StreamBufferHandle_t xStreamBuffer );
+ </pre>
+ *
+ * Return the memory of a stream buffer to the heap.  No task may be blocked
+ * on it.
+ *
+ * \defgroup vStreamBufferDelete vStreamBufferDelete
+ * \ingroup StreamBufferManagement
+ */
+void vStreamBufferDelete( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ * <pre>
+ BaseType_t xStreamBufferReset( StreamBufferHandle_t xStreamBuffer );
+ </pre>
+ *
+ * Discard the contents of a stream buffer.  A stream buffer can only be reset
+ * while no task is blocked on it.
+ *
+ * @return pdPASS if the stream buffer was reset, pdFAIL if a task was blocked
+ * on it.
+ *
+ * \defgroup xStreamBufferReset xStreamBufferReset
+ * \ingroup StreamBufferManagement
+ */
+BaseType_t xStreamBufferReset( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ * <pre>
+ BaseType_t xStreamBufferSetTriggerLevel( StreamBufferHandle_t xStreamBuffer, size_t xTriggerLevel );
+ </pre>
+ *
+ * Change the trigger level of a stream buffer, see xStreamBufferCreate().
+ *
+ * @return pdPASS if the level was changed, pdFAIL if it is larger than the
+ * buffer.
+ *
+ * \defgroup xStreamBufferSetTriggerLevel xStreamBufferSetTriggerLevel
+ * \ingroup StreamBufferManagement
+ */
+BaseType_t xStreamBufferSetTriggerLevel( StreamBufferHandle_t xStreamBuffer, size_t xTriggerLevel ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ * <pre>
+ size_t xStreamBufferBytesAvailable( StreamBufferHandle_t xStreamBuffer );
+ size_t xStreamBufferSpacesAvailable( StreamBufferHandle_t xStreamBuffer );
+ BaseType_t xStreamBufferIsEmpty( StreamBufferHandle_t xStreamBuffer );
+ BaseType_t xStreamBufferIsFull( StreamBufferHandle_t xStreamBuffer );
+ </pre>
+ *
+ * Query the number of bytes that can be read from, or written to, a stream
+ * buffer.  The result is only a snapshot if the other side is active.
+ *
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferBytesAvailable( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+size_t xStreamBufferSpacesAvailable( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+BaseType_t xStreamBufferIsEmpty( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+BaseType_t xStreamBufferIsFull( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+
+/* Functions below this line are not part of the public API. */
+StreamBufferHandle_t xStreamBufferGenericCreate( size_t xBufferSizeBytes, size_t xTriggerLevelBytes, BaseType_t xIsMessageBuffer ) PRIVILEGED_FUNCTION;
+size_t xStreamBufferNextMessageLengthBytes( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STREAM_BUFFER_H */
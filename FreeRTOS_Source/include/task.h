@@ -174,6 +174,9 @@ typedef struct xTASK_STATUS
 	UBaseType_t uxBasePriority;		/* The priority to which the task will return if the task's current priority has been inherited to avoid unbounded priority inversion when obtaining a mutex.  Only valid if configUSE_MUTEXES is defined as 1 in FreeRTOSConfig.h. */
 	uint32_t ulRunTimeCounter;		/* The total run time allocated to the task so far, as defined by the run time stats clock.  See http://www.freertos.org/rtos-run-time-stats.html.  Only valid when configGENERATE_RUN_TIME_STATS is defined as 1 in FreeRTOSConfig.h. */
 	StackType_t *pxStackBase;		/* Points to the lowest address of the task's stack area. */
+	#if ( ( portSTACK_GROWTH > 0 ) || ( configRECORD_STACK_HIGH_ADDRESS == 1 ) )
+		StackType_t *pxEndOfStack;	/* Points to the highest address of the task's stack area. */
+	#endif
 	uint16_t usStackHighWaterMark;	/* The minimum amount of stack space that has remained for the task since the task was created.  The closer this value is to zero the closer the task has come to overflowing its stack. */
 } TaskStatus_t;
 
@@ -2159,6 +2162,29 @@ void vTaskPlaceOnEventListRestricted( List_t * const pxEventList, TickType_t xTi
 BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList ) PRIVILEGED_FUNCTION;
 BaseType_t xTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem, const TickType_t xItemValue ) PRIVILEGED_FUNCTION;
 
+/*
+ * THESE FUNCTIONS MUST NOT BE USED FROM APPLICATION CODE.  THEY ARE AN
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THEY MUST BE CALLED WITH THE SAME REQUIREMENTS AS vTaskPlaceOnEventList()
+ * AND xTaskRemoveFromEventList() RESPECTIVELY.
+ *
+ * Used by keyed queues, where every task blocked on the receive event list
+ * waits for items with one particular key.  vTaskPlaceOnEventListKeyed()
+ * blocks the calling task like vTaskPlaceOnEventList() and records the key it
+ * waits for.  xTaskRemoveFromEventListByKey() unblocks the highest priority
+ * task that waits for uxKey.  Unlike xTaskRemoveFromEventList() the event list
+ * may be empty, or hold no task that waits for the key, in which case no task
+ * is unblocked.
+ *
+ * @return pdTRUE if a task was unblocked and has a higher priority than the
+ * task making the call, otherwise pdFALSE.
+ */
+#if ( configUSE_KEYED_QUEUES == 1 )
+	void vTaskPlaceOnEventListKeyed( List_t * const pxEventList, const UBaseType_t uxKey, const TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+	BaseType_t xTaskRemoveFromEventListByKey( const List_t * const pxEventList, const UBaseType_t uxKey ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS ONLY
  * INTENDED FOR USE WHEN IMPLEMENTING A PORT OF THE SCHEDULER AND IS
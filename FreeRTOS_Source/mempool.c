@@ -0,0 +1,352 @@
+/*
+ * Fixed block memory pools, see mempool.h.
+ *
+ * Free blocks are kept on a singly linked list whose links are stored in the
+ * blocks themselves, so a pool has no per block overhead.  Allocation pops the
+ * head of the list and freeing pushes the block back, both inside a short
+ * critical section.
+ *
+ *    1 tab == 4 spaces!
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "mempool.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE /*lint !e961 !e750. */
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error mempool.c requires configSUPPORT_DYNAMIC_ALLOCATION set to 1
+#endif
+
+/* Link stored in the first bytes of every free block. */
+typedef struct xMEMPOOL_FREE_BLOCK
+{
+	struct xMEMPOOL_FREE_BLOCK *pxNext;
+} MemPoolFreeBlock_t;
+
+typedef struct xMEMPOOL
+{
+	MemPoolFreeBlock_t *pxFreeList;	/*< First free block, NULL when the pool is empty. */
+	uint8_t *pucStart;				/*< First byte of the block storage. */
+	uint8_t *pucEnd;				/*< One past the last byte of the block storage. */
+	const char *pcName;
+	size_t xBlockSize;
+	UBaseType_t uxBlockCount;
+	UBaseType_t uxBlocksFree;
+	UBaseType_t uxMinimumBlocksFree;
+	uint32_t ulAllocations;
+	uint32_t ulAllocFailures;
+} MemPool_t;
+
+/* The control structure is placed in front of the blocks, rounded up so the
+first block is aligned. */
+#define mempoolHEADER_SIZE	( ( sizeof( MemPool_t ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+/* Registered size classes, sorted by increasing block size. */
+static MemPool_t *pxSizeClasses[ configMEMPOOL_MAX_POOLS ];
+static UBaseType_t uxNumSizeClasses = 0;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Pop a block from the free list of a pool.  Must be called with interrupts
+ * masked.
+ */
+static void *prvTakeBlock( MemPool_t *pxPool ) PRIVILEGED_FUNCTION;
+
+/*
+ * Push a block onto the free list of the pool that owns it.  Must be called
+ * with interrupts masked.
+ */
+static void prvReturnBlock( void *pvBlock ) PRIVILEGED_FUNCTION;
+
+/*
+ * Take a block from the smallest size class that can hold xWantedSize bytes
+ * and is not empty.  Must be called with interrupts masked.
+ */
+static void *prvTakeBlockBySize( size_t xWantedSize ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+MemPoolHandle_t xMemPoolCreate( const char *pcName, size_t xBlockSize, UBaseType_t uxBlockCount )
+{
+MemPool_t *pxPool;
+MemPoolFreeBlock_t *pxBlock;
+UBaseType_t ux, uxInsert;
+
+	configASSERT( uxBlockCount > ( UBaseType_t ) 0 );
+
+	/* Free blocks hold a link, and every block must stay aligned. */
+	if( xBlockSize < sizeof( MemPoolFreeBlock_t ) )
+	{
+		xBlockSize = sizeof( MemPoolFreeBlock_t );
+	}
+	xBlockSize = ( xBlockSize + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+	if( uxNumSizeClasses >= ( UBaseType_t ) configMEMPOOL_MAX_POOLS )
+	{
+		return NULL;
+	}
+
+	pxPool = ( MemPool_t * ) portMALLOC_TAGGED( mempoolHEADER_SIZE + ( xBlockSize * uxBlockCount ), eHeapTagMemPool );
+
+	if( pxPool != NULL )
+	{
+		pxPool->pcName = pcName;
+		pxPool->xBlockSize = xBlockSize;
+		pxPool->uxBlockCount = uxBlockCount;
+		pxPool->uxBlocksFree = uxBlockCount;
+		pxPool->uxMinimumBlocksFree = uxBlockCount;
+		pxPool->ulAllocations = 0UL;
+		pxPool->ulAllocFailures = 0UL;
+		pxPool->pucStart = ( ( uint8_t * ) pxPool ) + mempoolHEADER_SIZE;
+		pxPool->pucEnd = pxPool->pucStart + ( xBlockSize * uxBlockCount );
+
+		/* Thread every block onto the free list, lowest address first. */
+		pxPool->pxFreeList = NULL;
+		for( ux = uxBlockCount; ux > ( UBaseType_t ) 0; ux-- )
+		{
+			pxBlock = ( MemPoolFreeBlock_t * ) ( pxPool->pucStart + ( xBlockSize * ( ux - 1 ) ) );
+			pxBlock->pxNext = pxPool->pxFreeList;
+			pxPool->pxFreeList = pxBlock;
+		}
+
+		/* Register the size class, keeping the table sorted. */
+		taskENTER_CRITICAL();
+		{
+			uxInsert = uxNumSizeClasses;
+			while( ( uxInsert > ( UBaseType_t ) 0 ) && ( pxSizeClasses[ uxInsert - 1 ]->xBlockSize > xBlockSize ) )
+			{
+				pxSizeClasses[ uxInsert ] = pxSizeClasses[ uxInsert - 1 ];
+				uxInsert--;
+			}
+			pxSizeClasses[ uxInsert ] = pxPool;
+			uxNumSizeClasses++;
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	return ( MemPoolHandle_t ) pxPool;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvTakeBlock( MemPool_t *pxPool )
+{
+MemPoolFreeBlock_t *pxBlock = pxPool->pxFreeList;
+
+	if( pxBlock != NULL )
+	{
+		pxPool->pxFreeList = pxBlock->pxNext;
+		pxPool->uxBlocksFree--;
+		pxPool->ulAllocations++;
+
+		if( pxPool->uxBlocksFree < pxPool->uxMinimumBlocksFree )
+		{
+			pxPool->uxMinimumBlocksFree = pxPool->uxBlocksFree;
+		}
+	}
+	else
+	{
+		pxPool->ulAllocFailures++;
+	}
+
+	return ( void * ) pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReturnBlock( void *pvBlock )
+{
+MemPool_t *pxPool = NULL;
+MemPoolFreeBlock_t *pxBlock = ( MemPoolFreeBlock_t * ) pvBlock;
+UBaseType_t ux;
+
+	for( ux = 0; ux < uxNumSizeClasses; ux++ )
+	{
+		if( ( ( uint8_t * ) pvBlock >= pxSizeClasses[ ux ]->pucStart ) && ( ( uint8_t * ) pvBlock < pxSizeClasses[ ux ]->pucEnd ) )
+		{
+			pxPool = pxSizeClasses[ ux ];
+			break;
+		}
+	}
+
+	/* The block must belong to a pool and must be the start of a block. */
+	configASSERT( pxPool != NULL );
+	configASSERT( ( ( size_t ) ( ( uint8_t * ) pvBlock - pxPool->pucStart ) % pxPool->xBlockSize ) == ( size_t ) 0 );
+	configASSERT( pxPool->uxBlocksFree < pxPool->uxBlockCount );
+
+	if( pxPool != NULL )
+	{
+		pxBlock->pxNext = pxPool->pxFreeList;
+		pxPool->pxFreeList = pxBlock;
+		pxPool->uxBlocksFree++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void *prvTakeBlockBySize( size_t xWantedSize )
+{
+void *pvReturn = NULL;
+MemPool_t *pxFirstFit = NULL;
+UBaseType_t ux;
+
+	for( ux = 0; ux < uxNumSizeClasses; ux++ )
+	{
+		if( pxSizeClasses[ ux ]->xBlockSize >= xWantedSize )
+		{
+			if( pxFirstFit == NULL )
+			{
+				pxFirstFit = pxSizeClasses[ ux ];
+			}
+
+			if( pxSizeClasses[ ux ]->pxFreeList != NULL )
+			{
+				pvReturn = prvTakeBlock( pxSizeClasses[ ux ] );
+				break;
+			}
+		}
+	}
+
+	/* Every class large enough is empty.  The failure is counted on the
+	smallest of them, which the request would normally have been served from.
+	A size larger than every class is not counted. */
+	if( ( pvReturn == NULL ) && ( pxFirstFit != NULL ) )
+	{
+		pxFirstFit->ulAllocFailures++;
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void *pvMemPoolAlloc( MemPoolHandle_t xPool )
+{
+void *pvReturn;
+
+	configASSERT( xPool );
+
+	taskENTER_CRITICAL();
+	{
+		pvReturn = prvTakeBlock( ( MemPool_t * ) xPool );
+	}
+	taskEXIT_CRITICAL();
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void *pvMemPoolAllocFromISR( MemPoolHandle_t xPool )
+{
+void *pvReturn;
+UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( xPool );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		pvReturn = prvTakeBlock( ( MemPool_t * ) xPool );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void *pvMemPoolMalloc( size_t xWantedSize )
+{
+void *pvReturn;
+
+	taskENTER_CRITICAL();
+	{
+		pvReturn = prvTakeBlockBySize( xWantedSize );
+	}
+	taskEXIT_CRITICAL();
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void *pvMemPoolMallocFromISR( size_t xWantedSize )
+{
+void *pvReturn;
+UBaseType_t uxSavedInterruptStatus;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		pvReturn = prvTakeBlockBySize( xWantedSize );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vMemPoolFree( void *pvBlock )
+{
+	if( pvBlock != NULL )
+	{
+		taskENTER_CRITICAL();
+		{
+			prvReturnBlock( pvBlock );
+		}
+		taskEXIT_CRITICAL();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vMemPoolFreeFromISR( void *pvBlock )
+{
+UBaseType_t uxSavedInterruptStatus;
+
+	if( pvBlock != NULL )
+	{
+		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+		{
+			prvReturnBlock( pvBlock );
+		}
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vMemPoolGetStats( MemPoolHandle_t xPool, MemPoolStats_t *pxStats )
+{
+MemPool_t *pxPool = ( MemPool_t * ) xPool;
+
+	configASSERT( pxPool );
+	configASSERT( pxStats );
+
+	taskENTER_CRITICAL();
+	{
+		pxStats->pcName = pxPool->pcName;
+		pxStats->xBlockSize = pxPool->xBlockSize;
+		pxStats->uxBlockCount = pxPool->uxBlockCount;
+		pxStats->uxBlocksFree = pxPool->uxBlocksFree;
+		pxStats->uxMinimumBlocksFree = pxPool->uxMinimumBlocksFree;
+		pxStats->ulAllocations = pxPool->ulAllocations;
+		pxStats->ulAllocFailures = pxPool->ulAllocFailures;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+MemPoolHandle_t xMemPoolGetHandle( UBaseType_t uxIndex )
+{
+MemPoolHandle_t xReturn = NULL;
+
+	if( uxIndex < uxNumSizeClasses )
+	{
+		xReturn = ( MemPoolHandle_t ) pxSizeClasses[ uxIndex ];
+	}
+
+	return xReturn;
+}
@@ -87,10 +87,17 @@ task.h is included from an application file. */
 
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
 
+/* heap_tlsf.c provides the heap instead when configUSE_TLSF_HEAP is 1. */
+#if( configUSE_TLSF_HEAP == 0 )
+
 #if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
 	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
 #endif
 
+#if( configUSE_HEAP_MAP == 1 )
+	#error configUSE_HEAP_MAP requires heap_tlsf.c, set configUSE_TLSF_HEAP to 1
+#endif
+
 /* A few bytes might be lost to byte aligning the heap start address. */
 #define configADJUSTED_HEAP_SIZE	( configTOTAL_HEAP_SIZE - portBYTE_ALIGNMENT )
 
@@ -184,5 +191,4 @@ size_t xPortGetFreeHeapSize( void )
 	return ( configADJUSTED_HEAP_SIZE - xNextFreeByte );
 }
 
-
-
+#endif /* configUSE_TLSF_HEAP */
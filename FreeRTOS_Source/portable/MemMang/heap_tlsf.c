@@ -0,0 +1,589 @@
+/*
+ * A two level segregated fit (TLSF) implementation of pvPortMalloc() and
+ * vPortFree() with constant time allocation and freeing.
+ *
+ * Free blocks are kept on segregated lists, one per size range.  The first
+ * level splits sizes into powers of two and the second level splits every
+ * power of two into tlsfSL_COUNT linear ranges.  Two bitmaps record which
+ * lists are not empty, so finding a suitable free block takes a fixed number
+ * of bit scans instead of a walk along a free list as in heap_2 and heap_4.
+ * Freed blocks are merged with free neighbours straight away, so the heap does
+ * not fragment into small blocks over time.
+ *
+ * Every block starts with a header that holds the size of the block and a
+ * pointer to the physically preceding block.  Free blocks additionally hold
+ * the links of their free list in the space that is handed to the application
+ * while the block is in use.
+ *
+ * When configUSE_HEAP_MAP is 1 the header also records the kind of object
+ * the block was allocated for and how many bytes of it were not requested,
+ * and vPortGetHeapMap() walks the blocks in address order to break down the
+ * use of the heap.
+ *
+ * Select this implementation by setting configUSE_TLSF_HEAP to 1 in
+ * FreeRTOSConfig.h; heap_1.c is then left out of the build.
+ *
+ *    1 tab == 4 spaces!
+ */
+#include <stdlib.h>
+#include <stddef.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_TLSF_HEAP == 1 )
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* log2 of portBYTE_ALIGNMENT, the granularity of all block sizes. */
+#if( portBYTE_ALIGNMENT == 1 ) || ( portBYTE_ALIGNMENT == 2 )
+	#define tlsfALIGN_LOG2		1
+#elif( portBYTE_ALIGNMENT == 4 )
+	#define tlsfALIGN_LOG2		2
+#elif( portBYTE_ALIGNMENT == 8 )
+	#define tlsfALIGN_LOG2		3
+#else
+	#error Unsupported portBYTE_ALIGNMENT
+#endif
+
+#define tlsfALIGN_SIZE			( ( size_t ) 1 << tlsfALIGN_LOG2 )
+#define tlsfALIGN_MASK			( tlsfALIGN_SIZE - ( size_t ) 1 )
+
+/* Number of second level lists per power of two, as a power of two. */
+#define tlsfSL_LOG2				3
+#define tlsfSL_COUNT			( 1U << tlsfSL_LOG2 )
+
+/* Blocks below tlsfSMALL_BLOCK are kept on first level list 0, split
+linearly into tlsfSL_COUNT ranges. */
+#define tlsfFL_SHIFT			( tlsfSL_LOG2 + tlsfALIGN_LOG2 )
+#define tlsfSMALL_BLOCK			( ( size_t ) 1 << tlsfFL_SHIFT )
+
+/* The highest power of two a block size can reach. */
+#define tlsfFL_MAX				14
+#define tlsfFL_COUNT			( tlsfFL_MAX - tlsfFL_SHIFT + 2 )
+
+/* Bit 0 of the size field marks a free block; sizes are always aligned so the
+bit is not needed to hold the size. */
+#define tlsfBLOCK_FREE			( ( size_t ) 1 )
+
+typedef struct xTLSF_BLOCK
+{
+	struct xTLSF_BLOCK *pxPrevPhys;	/*< The block immediately below this one in memory, NULL for the first block. */
+	size_t xSize;					/*< Size of the payload in bytes, ORed with tlsfBLOCK_FREE while the block is free. */
+	#if( configUSE_HEAP_MAP == 1 )
+		uint8_t ucTag;				/*< HeapTag_t the block was allocated with. */
+		uint8_t ucSlack;			/*< Payload bytes beyond the requested size. */
+	#endif
+	struct xTLSF_BLOCK *pxNextFree;	/*< Only valid while the block is free. */
+	struct xTLSF_BLOCK *pxPrevFree;	/*< Only valid while the block is free. */
+} TlsfBlock_t;
+
+/* The part of the block that is never handed to the application. */
+#define tlsfHEADER_SIZE			( ( offsetof( TlsfBlock_t, pxNextFree ) + tlsfALIGN_MASK ) & ~tlsfALIGN_MASK )
+
+/* Every block must be able to hold the free list links. */
+#define tlsfMIN_PAYLOAD			( ( ( sizeof( TlsfBlock_t ) - tlsfHEADER_SIZE ) + tlsfALIGN_MASK ) & ~tlsfALIGN_MASK )
+
+#define tlsfBLOCK_SIZE( pxBlock )		( ( pxBlock )->xSize & ~tlsfBLOCK_FREE )
+#define tlsfBLOCK_IS_FREE( pxBlock )	( ( ( pxBlock )->xSize & tlsfBLOCK_FREE ) != 0 )
+#define tlsfNEXT_PHYS( pxBlock )		( ( TlsfBlock_t * ) ( ( ( uint8_t * ) ( pxBlock ) ) + tlsfHEADER_SIZE + tlsfBLOCK_SIZE( pxBlock ) ) )
+
+/* Allocate the memory for the heap. */
+#if( configAPPLICATION_ALLOCATED_HEAP == 1 )
+	/* The application writer has already defined the array used for the RTOS
+	heap - probably so it can be placed in a special segment or address. */
+	extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+	static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+/* Bit n of usFLBitmap is set when any second level list of first level n is
+not empty; bit m of ucSLBitmap[ n ] is set when list [ n ][ m ] is not empty. */
+static uint16_t usFLBitmap = 0;
+static uint8_t ucSLBitmap[ tlsfFL_COUNT ];
+static TlsfBlock_t *pxFreeLists[ tlsfFL_COUNT ][ tlsfSL_COUNT ];
+
+/* The first block, where a walk over all blocks starts. */
+static TlsfBlock_t *pxHeapStart = NULL;
+
+/* Bytes held by free blocks, headers included, and the lowest value seen. */
+static size_t xFreeBytesRemaining = 0U;
+static size_t xMinimumEverFreeBytesRemaining = 0U;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Split the heap into one large free block followed by a zero sized block
+ * that is never free, so every free block has a physical successor.
+ */
+static void prvHeapInit( void );
+
+/*
+ * Index of the most significant set bit of a non zero value.
+ */
+static UBaseType_t prvFls( uint16_t usValue );
+
+/*
+ * Map a block size to the free list that holds blocks of that size.
+ */
+static void prvMappingInsert( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL );
+
+/*
+ * Map a requested size to the first free list whose blocks are all large
+ * enough, so any block found there can be used without searching.
+ */
+static BaseType_t prvMappingSearch( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL );
+
+static void prvInsertFreeBlock( TlsfBlock_t *pxBlock );
+static void prvRemoveFreeBlock( TlsfBlock_t *pxBlock );
+
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvFls( uint16_t usValue )
+{
+/* Most significant set bit of every nibble value, 0 is never looked up. */
+static const uint8_t ucNibbleFls[ 16 ] = { 0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3 };
+UBaseType_t uxBit = 0;
+
+	if( ( usValue & 0xff00U ) != 0U )
+	{
+		usValue >>= 8;
+		uxBit += 8;
+	}
+
+	if( ( usValue & 0x00f0U ) != 0U )
+	{
+		usValue >>= 4;
+		uxBit += 4;
+	}
+
+	return uxBit + ucNibbleFls[ usValue & 0x0fU ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingInsert( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+UBaseType_t uxFL, uxSL;
+
+	if( xSize < tlsfSMALL_BLOCK )
+	{
+		uxFL = 0;
+		uxSL = ( UBaseType_t ) ( xSize / ( tlsfSMALL_BLOCK / tlsfSL_COUNT ) );
+	}
+	else
+	{
+		uxFL = prvFls( ( uint16_t ) xSize );
+		uxSL = ( UBaseType_t ) ( xSize >> ( uxFL - tlsfSL_LOG2 ) ) ^ tlsfSL_COUNT;
+		uxFL -= ( tlsfFL_SHIFT - 1 );
+	}
+
+	*puxFL = uxFL;
+	*puxSL = uxSL;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvMappingSearch( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+UBaseType_t uxFL, uxSL;
+uint8_t ucSLMap;
+uint16_t usFLMap;
+
+	if( xSize >= tlsfSMALL_BLOCK )
+	{
+		/* Round up to the next list boundary. */
+		xSize += ( ( size_t ) 1 << ( prvFls( ( uint16_t ) xSize ) - tlsfSL_LOG2 ) ) - 1;
+	}
+
+	prvMappingInsert( xSize, &uxFL, &uxSL );
+
+	if( uxFL >= tlsfFL_COUNT )
+	{
+		return pdFALSE;
+	}
+
+	/* A non empty list in the same power of two, at or above uxSL... */
+	ucSLMap = ( uint8_t ) ( ucSLBitmap[ uxFL ] & ( 0xffU << uxSL ) );
+
+	if( ucSLMap == 0U )
+	{
+		/* ...or the smallest list of any larger power of two. */
+		usFLMap = ( uint16_t ) ( usFLBitmap & ( 0xffffU << ( uxFL + 1 ) ) );
+
+		if( usFLMap == 0U )
+		{
+			return pdFALSE;
+		}
+
+		uxFL = prvFls( usFLMap & ( uint16_t ) -usFLMap );
+		ucSLMap = ucSLBitmap[ uxFL ];
+	}
+
+	uxSL = prvFls( ucSLMap & ( uint8_t ) -ucSLMap );
+
+	*puxFL = uxFL;
+	*puxSL = uxSL;
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( TlsfBlock_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+
+	prvMappingInsert( tlsfBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+	pxBlock->xSize |= tlsfBLOCK_FREE;
+	pxBlock->pxPrevFree = NULL;
+	pxBlock->pxNextFree = pxFreeLists[ uxFL ][ uxSL ];
+
+	if( pxBlock->pxNextFree != NULL )
+	{
+		pxBlock->pxNextFree->pxPrevFree = pxBlock;
+	}
+
+	pxFreeLists[ uxFL ][ uxSL ] = pxBlock;
+	usFLBitmap |= ( uint16_t ) ( 1U << uxFL );
+	ucSLBitmap[ uxFL ] |= ( uint8_t ) ( 1U << uxSL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( TlsfBlock_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+
+	prvMappingInsert( tlsfBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+	if( pxBlock->pxNextFree != NULL )
+	{
+		pxBlock->pxNextFree->pxPrevFree = pxBlock->pxPrevFree;
+	}
+
+	if( pxBlock->pxPrevFree != NULL )
+	{
+		pxBlock->pxPrevFree->pxNextFree = pxBlock->pxNextFree;
+	}
+	else
+	{
+		/* The block was the head of its list. */
+		pxFreeLists[ uxFL ][ uxSL ] = pxBlock->pxNextFree;
+
+		if( pxBlock->pxNextFree == NULL )
+		{
+			ucSLBitmap[ uxFL ] &= ( uint8_t ) ~( 1U << uxSL );
+
+			if( ucSLBitmap[ uxFL ] == 0U )
+			{
+				usFLBitmap &= ( uint16_t ) ~( 1U << uxFL );
+			}
+		}
+	}
+
+	pxBlock->xSize &= ~tlsfBLOCK_FREE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void )
+{
+TlsfBlock_t *pxFirst, *pxLast;
+size_t xAddress, xTotalSize;
+
+	/* Block sizes must map onto the first level lists. */
+	configASSERT( configTOTAL_HEAP_SIZE < ( ( size_t ) 2 << tlsfFL_MAX ) );
+
+	/* Ensure the heap starts on a correctly aligned boundary. */
+	xAddress = ( size_t ) ucHeap;
+	xTotalSize = configTOTAL_HEAP_SIZE;
+
+	if( ( xAddress & tlsfALIGN_MASK ) != 0 )
+	{
+		xAddress += ( tlsfALIGN_SIZE - ( xAddress & tlsfALIGN_MASK ) );
+		xTotalSize -= xAddress - ( size_t ) ucHeap;
+	}
+
+	xTotalSize &= ~tlsfALIGN_MASK;
+
+	pxFirst = ( TlsfBlock_t * ) xAddress;
+	pxHeapStart = pxFirst;
+	pxFirst->pxPrevPhys = NULL;
+	pxFirst->xSize = xTotalSize - ( 2 * tlsfHEADER_SIZE );
+
+	/* The end marker has no payload and is never free, so nothing is ever
+	merged past the end of the heap. */
+	pxLast = tlsfNEXT_PHYS( pxFirst );
+	pxLast->pxPrevPhys = pxFirst;
+	pxLast->xSize = 0;
+
+	prvInsertFreeBlock( pxFirst );
+
+	xFreeBytesRemaining = tlsfHEADER_SIZE + tlsfBLOCK_SIZE( pxFirst );
+	xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_HEAP_MAP == 1 )
+void *pvPortMalloc( size_t xWantedSize )
+{
+	return pvPortMallocTagged( xWantedSize, eHeapTagOther );
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMallocTagged( size_t xWantedSize, HeapTag_t eTag )
+#else
+void *pvPortMalloc( size_t xWantedSize )
+#endif
+{
+TlsfBlock_t *pxBlock = NULL, *pxRemainder;
+void *pvReturn = NULL;
+UBaseType_t uxFL, uxSL;
+#if( configUSE_HEAP_MAP == 1 )
+	size_t xRequestedSize = 0;
+#endif
+static BaseType_t xHeapHasBeenInitialised = pdFALSE;
+
+	vTaskSuspendAll();
+	{
+		if( xHeapHasBeenInitialised == pdFALSE )
+		{
+			prvHeapInit();
+			xHeapHasBeenInitialised = pdTRUE;
+		}
+
+		/* Requests that do not fit the heap would overflow the rounding. */
+		if( ( xWantedSize > 0 ) && ( xWantedSize < configTOTAL_HEAP_SIZE ) )
+		{
+			#if( configUSE_HEAP_MAP == 1 )
+				xRequestedSize = xWantedSize;
+			#endif
+
+			xWantedSize = ( xWantedSize + tlsfALIGN_MASK ) & ~tlsfALIGN_MASK;
+
+			if( xWantedSize < tlsfMIN_PAYLOAD )
+			{
+				xWantedSize = tlsfMIN_PAYLOAD;
+			}
+
+			if( prvMappingSearch( xWantedSize, &uxFL, &uxSL ) != pdFALSE )
+			{
+				pxBlock = pxFreeLists[ uxFL ][ uxSL ];
+			}
+			else
+			{
+				/* Rounding up skips the list the size itself maps to, whose
+				head may still be large enough; looking at it keeps large
+				requests from failing while the heap can hold them. */
+				prvMappingInsert( xWantedSize, &uxFL, &uxSL );
+				pxBlock = pxFreeLists[ uxFL ][ uxSL ];
+
+				if( ( pxBlock != NULL ) && ( tlsfBLOCK_SIZE( pxBlock ) < xWantedSize ) )
+				{
+					pxBlock = NULL;
+				}
+			}
+
+			if( pxBlock != NULL )
+			{
+				prvRemoveFreeBlock( pxBlock );
+
+				/* Give back the tail of the block if it can form a block of
+				its own. */
+				if( tlsfBLOCK_SIZE( pxBlock ) >= ( xWantedSize + tlsfHEADER_SIZE + tlsfMIN_PAYLOAD ) )
+				{
+					pxRemainder = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + tlsfHEADER_SIZE + xWantedSize );
+					pxRemainder->pxPrevPhys = pxBlock;
+					pxRemainder->xSize = pxBlock->xSize - xWantedSize - tlsfHEADER_SIZE;
+					tlsfNEXT_PHYS( pxRemainder )->pxPrevPhys = pxRemainder;
+
+					pxBlock->xSize = xWantedSize;
+					prvInsertFreeBlock( pxRemainder );
+				}
+
+				xFreeBytesRemaining -= tlsfHEADER_SIZE + tlsfBLOCK_SIZE( pxBlock );
+
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+				}
+
+				#if( configUSE_HEAP_MAP == 1 )
+				{
+					pxBlock->ucTag = ( uint8_t ) eTag;
+					pxBlock->ucSlack = ( uint8_t ) ( tlsfBLOCK_SIZE( pxBlock ) - xRequestedSize );
+				}
+				#endif
+
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + tlsfHEADER_SIZE );
+			}
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+	}
+	#endif
+
+	configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+TlsfBlock_t *pxBlock, *pxNeighbour;
+
+	if( pv != NULL )
+	{
+		pxBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pv ) - tlsfHEADER_SIZE );
+
+		/* The block must be in use, freeing twice corrupts the lists. */
+		configASSERT( tlsfBLOCK_IS_FREE( pxBlock ) == pdFALSE );
+
+		vTaskSuspendAll();
+		{
+			xFreeBytesRemaining += tlsfHEADER_SIZE + tlsfBLOCK_SIZE( pxBlock );
+			traceFREE( pv, tlsfBLOCK_SIZE( pxBlock ) );
+
+			/* Merge with the block above if it is free. */
+			pxNeighbour = tlsfNEXT_PHYS( pxBlock );
+			if( tlsfBLOCK_IS_FREE( pxNeighbour ) )
+			{
+				prvRemoveFreeBlock( pxNeighbour );
+				pxBlock->xSize += tlsfHEADER_SIZE + tlsfBLOCK_SIZE( pxNeighbour );
+			}
+
+			/* Merge with the block below if it is free. */
+			pxNeighbour = pxBlock->pxPrevPhys;
+			if( ( pxNeighbour != NULL ) && tlsfBLOCK_IS_FREE( pxNeighbour ) )
+			{
+				prvRemoveFreeBlock( pxNeighbour );
+				pxNeighbour->xSize += tlsfHEADER_SIZE + tlsfBLOCK_SIZE( pxBlock );
+				pxBlock = pxNeighbour;
+			}
+
+			tlsfNEXT_PHYS( pxBlock )->pxPrevPhys = pxBlock;
+			prvInsertFreeBlock( pxBlock );
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+
+/*-----------------------------------------------------------*/
+
+#if( configUSE_HEAP_MAP == 1 )
+
+	void vPortGetHeapMap( HeapMap_t *pxHeapMap )
+	{
+	TlsfBlock_t *pxBlock;
+	size_t xBlockSize, xAccounted;
+	UBaseType_t ux;
+
+		configASSERT( pxHeapMap );
+
+		for( ux = 0; ux < ( UBaseType_t ) eHeapTagCount; ux++ )
+		{
+			pxHeapMap->xTagBytes[ ux ] = 0;
+			pxHeapMap->uxTagBlocks[ ux ] = 0;
+		}
+
+		pxHeapMap->xFreeBytes = 0;
+		pxHeapMap->uxFreeBlocks = 0;
+		pxHeapMap->xLargestFreeBlock = 0;
+		pxHeapMap->xSlackBytes = 0;
+		pxHeapMap->xHeapSize = configTOTAL_HEAP_SIZE;
+
+		vTaskSuspendAll();
+		{
+			/* Walk the blocks in address order up to the end marker, the only
+			block with no payload.  Before the first allocation the heap has
+			not been split yet and everything is free. */
+			for( pxBlock = pxHeapStart; ( pxBlock != NULL ) && ( tlsfBLOCK_SIZE( pxBlock ) != 0 ); pxBlock = tlsfNEXT_PHYS( pxBlock ) )
+			{
+				xBlockSize = tlsfBLOCK_SIZE( pxBlock );
+
+				if( tlsfBLOCK_IS_FREE( pxBlock ) )
+				{
+					pxHeapMap->xFreeBytes += tlsfHEADER_SIZE + xBlockSize;
+					pxHeapMap->uxFreeBlocks++;
+
+					if( xBlockSize > pxHeapMap->xLargestFreeBlock )
+					{
+						pxHeapMap->xLargestFreeBlock = xBlockSize;
+					}
+				}
+				else
+				{
+					configASSERT( pxBlock->ucTag < ( uint8_t ) eHeapTagCount );
+					pxHeapMap->xTagBytes[ pxBlock->ucTag ] += xBlockSize - pxBlock->ucSlack;
+					pxHeapMap->uxTagBlocks[ pxBlock->ucTag ]++;
+					pxHeapMap->xSlackBytes += pxBlock->ucSlack;
+				}
+			}
+		}
+		( void ) xTaskResumeAll();
+
+		if( pxHeapStart == NULL )
+		{
+			pxHeapMap->xFreeBytes = configTOTAL_HEAP_SIZE;
+			pxHeapMap->uxFreeBlocks = 1;
+			pxHeapMap->xLargestFreeBlock = configTOTAL_HEAP_SIZE;
+		}
+
+		/* Whatever is not requested, slack or free is header. */
+		xAccounted = pxHeapMap->xFreeBytes + pxHeapMap->xSlackBytes;
+		for( ux = 0; ux < ( UBaseType_t ) eHeapTagCount; ux++ )
+		{
+			xAccounted += pxHeapMap->xTagBytes[ ux ];
+		}
+
+		pxHeapMap->xOverheadBytes = configTOTAL_HEAP_SIZE - xAccounted;
+	}
+	/*-----------------------------------------------------------*/
+
+	const char *pcPortGetHeapTagName( HeapTag_t eTag )
+	{
+	static const char * const pcTagNames[ eHeapTagCount ] =
+	{
+		"other", "tcb", "stack", "queue", "semaphore", "timer", "eventgroup", "ringbuffer", "mempool", "streambuffer"
+	};
+
+		return ( eTag < eHeapTagCount ) ? pcTagNames[ eTag ] : "?";
+	}
+
+#endif /* configUSE_HEAP_MAP */
+
+#endif /* configUSE_TLSF_HEAP */
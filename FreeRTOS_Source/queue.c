@@ -93,6 +93,7 @@ privileged Vs unprivileged linkage and placement. */
 /* Constants used with the cRxLock and cTxLock structure members. */
 #define queueUNLOCKED					( ( int8_t ) -1 )
 #define queueLOCKED_UNMODIFIED			( ( int8_t ) 0 )
+#define queueMAX_LOCK_COUNT				( ( int8_t ) 127 )
 
 /* When the Queue_t structure is used to represent a base queue its pcHead and
 pcTail members are used as pointers into the queue storage area.  When the
@@ -162,6 +163,23 @@ typedef struct QueueDefinition
 		uint8_t ucQueueType;
 	#endif
 
+	#if ( configUSE_QUEUE_STATS == 1 )
+		UBaseType_t uxMessagesWaitingHighWater;	/*< The largest value uxMessagesWaiting has ever held. */
+		TickType_t xLastDepthChange;			/*< Tick count at which uxMessagesWaiting last changed. */
+		uint32_t ulSendFailures;				/*< Task level sends that found the queue full. */
+		uint32_t ulSendFailuresFromISR;			/*< Sends from interrupts that found the queue full. */
+		uint32_t ulSendersBlocked;				/*< Times a task blocked on the xTasksWaitingToSend list. */
+		uint32_t ulReceiversBlocked;			/*< Times a task blocked on the xTasksWaitingToReceive list. */
+		uint32_t ulItemsRemoved;				/*< Items that have left the queue. */
+		uint32_t ulDepthTicks;					/*< Integral of uxMessagesWaiting over time, in item ticks. */
+		uint32_t ulResidencyItems;				/*< Removed items that ulDepthTicks is averaged over. */
+	#endif
+
+	#if ( configUSE_KEYED_QUEUES == 1 )
+		UBaseType_t uxKeyOffset;				/*< Offset of the key field within an item. */
+		uint8_t ucKeySize;						/*< Size of the key field in bytes, 0 if the queue is not keyed. */
+	#endif
+
 } xQUEUE;
 
 /* The old xQUEUE name is maintained above then typedefed to the new Queue_t
@@ -232,6 +250,70 @@ static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvIte
  */
 static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer ) PRIVILEGED_FUNCTION;
 
+/*
+ * Copies uxCount consecutive items to the back of the queue, and copies
+ * uxCount items out of the queue, using at most two memcpy() calls as the
+ * items can wrap around the end of the storage area.  Both must be called
+ * from a critical section and the caller must have checked that there is
+ * enough space or data.
+ */
+static void prvCopyMultipleToQueue( Queue_t * const pxQueue, const int8_t *pcItems, const UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+static void prvCopyMultipleFromQueue( Queue_t * const pxQueue, int8_t *pcBuffer, const UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
+/*
+ * Removes up to uxMaxTasks tasks from a queue event list, one for each item
+ * that was added or removed, stopping as soon as the list is empty.  Returns
+ * pdTRUE if any of the tasks has a priority above that of the calling task.
+ */
+static BaseType_t prvUnblockWaitingTasks( List_t * const pxEventList, UBaseType_t uxMaxTasks ) PRIVILEGED_FUNCTION;
+
+/*
+ * Unblocks the task that should receive an item that has just been posted:
+ * the highest priority task waiting to receive or, if the queue is keyed, the
+ * highest priority task waiting for the key of the item.  Must be called from
+ * a critical section.
+ */
+static BaseType_t prvUnblockReceiver( Queue_t * const pxQueue, const void *pvItem ) PRIVILEGED_FUNCTION;
+
+/*
+ * As prvUnblockReceiver(), for uxCount consecutive items.
+ */
+static BaseType_t prvUnblockReceivers( Queue_t * const pxQueue, const int8_t *pcItems, const UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
+#if ( configUSE_KEYED_QUEUES == 1 )
+	/*
+	 * Reads the key field of an item.
+	 */
+	static UBaseType_t prvGetItemKey( const Queue_t * const pxQueue, const void *pvItem ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Returns the oldest item in the queue that has the key uxKey, or NULL if
+	 * there is none.  Must be called from a critical section.
+	 */
+	static int8_t *prvFindKeyedItem( const Queue_t * const pxQueue, const UBaseType_t uxKey ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Uses a critical section to determine if a queue holds an item with the
+	 * key uxKey.
+	 *
+	 * @return pdTRUE if there is no such item, otherwise pdFALSE.
+	 */
+	static BaseType_t prvIsKeyAbsent( const Queue_t *pxQueue, const UBaseType_t uxKey ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Copies the item pcItem out of the queue and closes the gap by moving
+	 * every older item up by one place, so the order of the remaining items is
+	 * preserved.  Must be called from a critical section.
+	 */
+	static void prvCopyKeyedItemFromQueue( Queue_t * const pxQueue, int8_t *pcItem, void * const pvBuffer ) PRIVILEGED_FUNCTION;
+#endif
+
+/*
+ * Adds uxCount to a queue lock count, saturating rather than wrapping.  The
+ * lock count must not be queueUNLOCKED.
+ */
+static int8_t prvAddToLockCount( const int8_t cLockCount, const UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
 #if ( configUSE_QUEUE_SETS == 1 )
 	/*
 	 * Checks to see if a queue is a member of a queue set, and if so, notifies
@@ -255,6 +337,32 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseT
 	static void prvInitialiseMutex( Queue_t *pxNewQueue ) PRIVILEGED_FUNCTION;
 #endif
 
+#if( configUSE_QUEUE_STATS == 1 )
+	/*
+	 * Must be called from a critical section immediately before the number
+	 * of items held in a queue changes to uxNewMessagesWaiting.  Accumulates
+	 * the depth integral used to calculate the average residency, counts
+	 * removed items and maintains the high water mark.
+	 */
+	static void prvRecordDepthChange( Queue_t * const pxQueue, const UBaseType_t uxNewMessagesWaiting ) PRIVILEGED_FUNCTION;
+
+	#define queueSTATS_DEPTH_CHANGE( pxQueue, uxNewMessagesWaiting ) prvRecordDepthChange( ( pxQueue ), ( uxNewMessagesWaiting ) )
+	#define queueSTATS_INCREMENT( pxQueue, ulCounter ) ( ( pxQueue )->ulCounter )++
+#else
+	#define queueSTATS_DEPTH_CHANGE( pxQueue, uxNewMessagesWaiting )
+	#define queueSTATS_INCREMENT( pxQueue, ulCounter )
+#endif
+
+#if( configUSE_KEYED_QUEUES == 1 )
+	/*
+	 * Items are taken from a keyed queue by xQueueReceiveKeyed() only, so
+	 * every task blocked on its receive list waits for a key.
+	 */
+	#define queueASSERT_NOT_KEYED( pxQueue ) configASSERT( ( pxQueue )->ucKeySize == ( uint8_t ) 0U )
+#else
+	#define queueASSERT_NOT_KEYED( pxQueue )
+#endif
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -285,6 +393,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 	taskENTER_CRITICAL();
 	{
 		pxQueue->pcTail = pxQueue->pcHead + ( pxQueue->uxLength * pxQueue->uxItemSize );
+		queueSTATS_DEPTH_CHANGE( pxQueue, ( UBaseType_t ) 0U );
 		pxQueue->uxMessagesWaiting = ( UBaseType_t ) 0U;
 		pxQueue->pcWriteTo = pxQueue->pcHead;
 		pxQueue->u.pcReadFrom = pxQueue->pcHead + ( ( pxQueue->uxLength - ( UBaseType_t ) 1U ) * pxQueue->uxItemSize );
@@ -403,7 +512,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 			xQueueSizeInBytes = ( size_t ) ( uxQueueLength * uxItemSize ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 		}
 
-		pxNewQueue = ( Queue_t * ) pvPortMalloc( sizeof( Queue_t ) + xQueueSizeInBytes );
+		pxNewQueue = ( Queue_t * ) portMALLOC_TAGGED( sizeof( Queue_t ) + xQueueSizeInBytes, ( ucQueueType == queueQUEUE_TYPE_BASE ) ? eHeapTagQueue : eHeapTagSemaphore );
 
 		if( pxNewQueue != NULL )
 		{
@@ -453,6 +562,17 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseT
 	defined. */
 	pxNewQueue->uxLength = uxQueueLength;
 	pxNewQueue->uxItemSize = uxItemSize;
+
+	#if ( configUSE_QUEUE_STATS == 1 )
+	{
+		/* The counters must be valid before xQueueGenericReset() records the
+		queue being emptied. */
+		pxNewQueue->uxMessagesWaiting = ( UBaseType_t ) 0U;
+		pxNewQueue->xLastDepthChange = xTaskGetTickCountFromISR();
+		vQueueResetStats( pxNewQueue );
+	}
+	#endif /* configUSE_QUEUE_STATS */
+
 	( void ) xQueueGenericReset( pxNewQueue, pdTRUE );
 
 	#if ( configUSE_TRACE_FACILITY == 1 )
@@ -467,6 +587,12 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseT
 	}
 	#endif /* configUSE_QUEUE_SETS */
 
+	#if( configUSE_KEYED_QUEUES == 1 )
+	{
+		pxNewQueue->ucKeySize = ( uint8_t ) 0U;
+	}
+	#endif /* configUSE_KEYED_QUEUES */
+
 	traceQUEUE_CREATE( pxNewQueue );
 }
 /*-----------------------------------------------------------*/
@@ -677,6 +803,7 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseT
 
 		if( xHandle != NULL )
 		{
+			queueSTATS_DEPTH_CHANGE( ( Queue_t * ) xHandle, uxInitialCount );
 			( ( Queue_t * ) xHandle )->uxMessagesWaiting = uxInitialCount;
 
 			traceCREATE_COUNTING_SEMAPHORE();
@@ -705,6 +832,7 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseT
 
 		if( xHandle != NULL )
 		{
+			queueSTATS_DEPTH_CHANGE( ( Queue_t * ) xHandle, uxInitialCount );
 			( ( Queue_t * ) xHandle )->uxMessagesWaiting = uxInitialCount;
 
 			traceCREATE_COUNTING_SEMAPHORE();
@@ -774,7 +902,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 						queue then unblock it now. */
 						if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
 						{
-							if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+							if( prvUnblockReceiver( pxQueue, pvItemToQueue ) != pdFALSE )
 							{
 								/* The unblocked task has a priority higher than
 								our own so yield immediately.  Yes it is ok to
@@ -807,7 +935,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 					queue then unblock it now. */
 					if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
 					{
-						if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+						if( prvUnblockReceiver( pxQueue, pvItemToQueue ) != pdFALSE )
 						{
 							/* The unblocked task has a priority higher than
 							our own so yield immediately.  Yes it is ok to do
@@ -844,6 +972,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 				{
 					/* The queue was full and no block time is specified (or
 					the block time has expired) so leave now. */
+					queueSTATS_INCREMENT( pxQueue, ulSendFailures );
 					taskEXIT_CRITICAL();
 
 					/* Return to the original privilege level before exiting
@@ -879,6 +1008,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 			if( prvIsQueueFull( pxQueue ) != pdFALSE )
 			{
 				traceBLOCKING_ON_QUEUE_SEND( pxQueue );
+				queueSTATS_INCREMENT( pxQueue, ulSendersBlocked );
 				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
 
 				/* Unlocking the queue means queue events can effect the
@@ -907,7 +1037,9 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 		}
 		else
 		{
-			/* The timeout has expired. */
+			/* The timeout has expired.  No other task can run while the
+			scheduler is suspended, so the counter is safe to update. */
+			queueSTATS_INCREMENT( pxQueue, ulSendFailures );
 			prvUnlockQueue( pxQueue );
 			( void ) xTaskResumeAll();
 
@@ -995,7 +1127,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 					{
 						if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
 						{
-							if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+							if( prvUnblockReceiver( pxQueue, pvItemToQueue ) != pdFALSE )
 							{
 								/* The task waiting has a higher priority so
 								record that a context switch is required. */
@@ -1023,7 +1155,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 				{
 					if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
 					{
-						if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+						if( prvUnblockReceiver( pxQueue, pvItemToQueue ) != pdFALSE )
 						{
 							/* The task waiting has a higher priority so record that a
 							context	switch is required. */
@@ -1060,6 +1192,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 		else
 		{
 			traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue );
+			queueSTATS_INCREMENT( pxQueue, ulSendFailuresFromISR );
 			xReturn = errQUEUE_FULL;
 		}
 	}
@@ -1127,6 +1260,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 			can be assumed there is no mutex holder and no need to determine if
 			priority disinheritance is needed.  Simply increase the count of
 			messages (semaphores) available. */
+			queueSTATS_DEPTH_CHANGE( pxQueue, uxMessagesWaiting + 1 );
 			pxQueue->uxMessagesWaiting = uxMessagesWaiting + 1;
 
 			/* The event list is not altered if the queue is locked.  This will
@@ -1225,6 +1359,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 		else
 		{
 			traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue );
+			queueSTATS_INCREMENT( pxQueue, ulSendFailuresFromISR );
 			xReturn = errQUEUE_FULL;
 		}
 	}
@@ -1242,6 +1377,7 @@ int8_t *pcOriginalReadPosition;
 Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 
 	configASSERT( pxQueue );
+	queueASSERT_NOT_KEYED( pxQueue );
 	configASSERT( !( ( pvBuffer == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
 	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
 	{
@@ -1274,6 +1410,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 					traceQUEUE_RECEIVE( pxQueue );
 
 					/* Actually removing data, not just peeking. */
+					queueSTATS_DEPTH_CHANGE( pxQueue, uxMessagesWaiting - 1 );
 					pxQueue->uxMessagesWaiting = uxMessagesWaiting - 1;
 
 					#if ( configUSE_MUTEXES == 1 )
@@ -1376,6 +1513,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
 			{
 				traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+				queueSTATS_INCREMENT( pxQueue, ulReceiversBlocked );
 
 				#if ( configUSE_MUTEXES == 1 )
 				{
@@ -1438,6 +1576,7 @@ UBaseType_t uxSavedInterruptStatus;
 Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 
 	configASSERT( pxQueue );
+	queueASSERT_NOT_KEYED( pxQueue );
 	configASSERT( !( ( pvBuffer == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
 
 	/* RTOS ports that support interrupt nesting have the concept of a maximum
@@ -1468,6 +1607,7 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 			traceQUEUE_RECEIVE_FROM_ISR( pxQueue );
 
 			prvCopyDataFromQueue( pxQueue, pvBuffer );
+			queueSTATS_DEPTH_CHANGE( pxQueue, uxMessagesWaiting - 1 );
 			pxQueue->uxMessagesWaiting = uxMessagesWaiting - 1;
 
 			/* If the queue is locked the event list will not be modified.
@@ -1522,272 +1662,1125 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 }
 /*-----------------------------------------------------------*/
 
-BaseType_t xQueuePeekFromISR( QueueHandle_t xQueue,  void * const pvBuffer )
+UBaseType_t xQueueSendMultiple( QueueHandle_t xQueue, const void * const pvItems, const UBaseType_t uxCount, TickType_t xTicksToWait )
 {
-BaseType_t xReturn;
-UBaseType_t uxSavedInterruptStatus;
-int8_t *pcOriginalReadPosition;
+BaseType_t xEntryTimeSet = pdFALSE;
+TimeOut_t xTimeOut;
+UBaseType_t uxCopied;
 Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 
 	configASSERT( pxQueue );
-	configASSERT( !( ( pvBuffer == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
-	configASSERT( pxQueue->uxItemSize != 0 ); /* Can't peek a semaphore. */
+	configASSERT( !( ( pvItems == NULL ) && ( uxCount != ( UBaseType_t ) 0U ) ) );
+	configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U ); /* Semaphores and mutexes hold no items. */
+	#if ( configUSE_QUEUE_SETS == 1 )
+	{
+		/* A queue set holds one handle per item, which is not batched. */
+		configASSERT( pxQueue->pxQueueSetContainer == NULL );
+	}
+	#endif
+	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+	{
+		configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+	}
+	#endif
 
-	/* RTOS ports that support interrupt nesting have the concept of a maximum
-	system call (or maximum API call) interrupt priority.  Interrupts that are
-	above the maximum system call priority are kept permanently enabled, even
-	when the RTOS kernel is in a critical section, but cannot make any calls to
-	FreeRTOS API functions.  If configASSERT() is defined in FreeRTOSConfig.h
-	then portASSERT_IF_INTERRUPT_PRIORITY_INVALID() will result in an assertion
-	failure if a FreeRTOS API function is called from an interrupt that has been
-	assigned a priority above the configured maximum system call priority.
-	Only FreeRTOS functions that end in FromISR can be called from interrupts
-	that have been assigned a priority at or (logically) below the maximum
-	system call	interrupt priority.  FreeRTOS maintains a separate interrupt
-	safe API to ensure interrupt entry is as fast and as simple as possible.
-	More information (albeit Cortex-M specific) is provided on the following
-	link: http://www.freertos.org/RTOS-Cortex-M3-M4.html */
-	portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+	if( uxCount == ( UBaseType_t ) 0U )
+	{
+		return ( UBaseType_t ) 0U;
+	}
 
-	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	/* This function relaxes the coding standard somewhat to allow return
+	statements within the function itself.  This is done in the interest
+	of execution time efficiency. */
+	for( ;; )
 	{
-		/* Cannot block in an ISR, so check there is data available. */
-		if( pxQueue->uxMessagesWaiting > ( UBaseType_t ) 0 )
+		taskENTER_CRITICAL();
 		{
-			traceQUEUE_PEEK_FROM_ISR( pxQueue );
+			const UBaseType_t uxSpace = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
 
-			/* Remember the read position so it can be reset as nothing is
-			actually being removed from the queue. */
-			pcOriginalReadPosition = pxQueue->u.pcReadFrom;
-			prvCopyDataFromQueue( pxQueue, pvBuffer );
-			pxQueue->u.pcReadFrom = pcOriginalReadPosition;
+			/* Is there room for at least one item?  As many items as fit are
+			copied, the caller sends the rest with another call. */
+			if( uxSpace > ( UBaseType_t ) 0 )
+			{
+				uxCopied = ( uxCount < uxSpace ) ? uxCount : uxSpace;
 
-			xReturn = pdPASS;
+				traceQUEUE_SEND( pxQueue );
+				prvCopyMultipleToQueue( pxQueue, ( const int8_t * ) pvItems, uxCopied );
+
+				if( prvUnblockReceivers( pxQueue, ( const int8_t * ) pvItems, uxCopied ) != pdFALSE )
+				{
+					/* An unblocked task has a priority higher than our own so
+					yield immediately.  Yes it is ok to do this from within the
+					critical section - the kernel takes care of that. */
+					queueYIELD_IF_USING_PREEMPTION();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				taskEXIT_CRITICAL();
+				return uxCopied;
+			}
+			else
+			{
+				if( xTicksToWait == ( TickType_t ) 0 )
+				{
+					/* The queue was full and no block time is specified (or
+					the block time has expired) so leave now. */
+					queueSTATS_INCREMENT( pxQueue, ulSendFailures );
+					taskEXIT_CRITICAL();
+					traceQUEUE_SEND_FAILED( pxQueue );
+					return ( UBaseType_t ) 0U;
+				}
+				else if( xEntryTimeSet == pdFALSE )
+				{
+					vTaskSetTimeOutState( &xTimeOut );
+					xEntryTimeSet = pdTRUE;
+				}
+				else
+				{
+					/* Entry time was already set. */
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		vTaskSuspendAll();
+		prvLockQueue( pxQueue );
+
+		/* Update the timeout state to see if it has expired yet. */
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			if( prvIsQueueFull( pxQueue ) != pdFALSE )
+			{
+				traceBLOCKING_ON_QUEUE_SEND( pxQueue );
+				queueSTATS_INCREMENT( pxQueue, ulSendersBlocked );
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
+				prvUnlockQueue( pxQueue );
+
+				if( xTaskResumeAll() == pdFALSE )
+				{
+					portYIELD_WITHIN_API();
+				}
+			}
+			else
+			{
+				/* Try again. */
+				prvUnlockQueue( pxQueue );
+				( void ) xTaskResumeAll();
+			}
 		}
 		else
 		{
-			xReturn = pdFAIL;
-			traceQUEUE_PEEK_FROM_ISR_FAILED( pxQueue );
+			/* The timeout has expired.  No other task can run while the
+			scheduler is suspended, so the counter is safe to update. */
+			queueSTATS_INCREMENT( pxQueue, ulSendFailures );
+			prvUnlockQueue( pxQueue );
+			( void ) xTaskResumeAll();
+
+			traceQUEUE_SEND_FAILED( pxQueue );
+			return ( UBaseType_t ) 0U;
 		}
 	}
-	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
-
-	return xReturn;
 }
 /*-----------------------------------------------------------*/
 
-UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
+UBaseType_t xQueueSendMultipleFromISR( QueueHandle_t xQueue, const void * const pvItems, const UBaseType_t uxCount, BaseType_t * const pxHigherPriorityTaskWoken )
 {
-UBaseType_t uxReturn;
-
-	configASSERT( xQueue );
+UBaseType_t uxCopied = 0;
+UBaseType_t uxSavedInterruptStatus;
+Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 
-	taskENTER_CRITICAL();
+	configASSERT( pxQueue );
+	configASSERT( !( ( pvItems == NULL ) && ( uxCount != ( UBaseType_t ) 0U ) ) );
+	configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+	#if ( configUSE_QUEUE_SETS == 1 )
 	{
-		uxReturn = ( ( Queue_t * ) xQueue )->uxMessagesWaiting;
+		configASSERT( pxQueue->pxQueueSetContainer == NULL );
 	}
-	taskEXIT_CRITICAL();
-
-	return uxReturn;
-} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
-/*-----------------------------------------------------------*/
-
-UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
-{
-UBaseType_t uxReturn;
-Queue_t *pxQueue;
+	#endif
 
-	pxQueue = ( Queue_t * ) xQueue;
-	configASSERT( pxQueue );
+	/* See the comment in xQueueGenericSendFromISR(). */
+	portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
 
-	taskENTER_CRITICAL();
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
 	{
-		uxReturn = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
-	}
-	taskEXIT_CRITICAL();
+		const UBaseType_t uxSpace = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
 
-	return uxReturn;
-} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
-/*-----------------------------------------------------------*/
+		if( uxSpace > ( UBaseType_t ) 0 )
+		{
+			const int8_t cTxLock = pxQueue->cTxLock;
 
-UBaseType_t uxQueueMessagesWaitingFromISR( const QueueHandle_t xQueue )
-{
-UBaseType_t uxReturn;
+			uxCopied = ( uxCount < uxSpace ) ? uxCount : uxSpace;
 
-	configASSERT( xQueue );
+			traceQUEUE_SEND_FROM_ISR( pxQueue );
+			prvCopyMultipleToQueue( pxQueue, ( const int8_t * ) pvItems, uxCopied );
 
-	uxReturn = ( ( Queue_t * ) xQueue )->uxMessagesWaiting;
+			/* The event list is not altered if the queue is locked.  This will
+			be done when the queue is unlocked later. */
+			if( cTxLock == queueUNLOCKED )
+			{
+				if( prvUnblockReceivers( pxQueue, ( const int8_t * ) pvItems, uxCopied ) != pdFALSE )
+				{
+					if( pxHigherPriorityTaskWoken != NULL )
+					{
+						*pxHigherPriorityTaskWoken = pdTRUE;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				/* Tell the task that unlocks the queue how many items were
+				posted while it was locked. */
+				pxQueue->cTxLock = prvAddToLockCount( cTxLock, uxCopied );
+			}
+		}
+		else
+		{
+			traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue );
+			queueSTATS_INCREMENT( pxQueue, ulSendFailuresFromISR );
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
 
-	return uxReturn;
-} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
+	return uxCopied;
+}
 /*-----------------------------------------------------------*/
 
-void vQueueDelete( QueueHandle_t xQueue )
+UBaseType_t xQueueReceiveMultiple( QueueHandle_t xQueue, void * const pvBuffer, const UBaseType_t uxMaxCount, TickType_t xTicksToWait )
 {
+BaseType_t xEntryTimeSet = pdFALSE;
+TimeOut_t xTimeOut;
+UBaseType_t uxCopied;
 Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 
 	configASSERT( pxQueue );
-	traceQUEUE_DELETE( pxQueue );
-
-	#if ( configQUEUE_REGISTRY_SIZE > 0 )
+	queueASSERT_NOT_KEYED( pxQueue );
+	configASSERT( !( ( pvBuffer == NULL ) && ( uxMaxCount != ( UBaseType_t ) 0U ) ) );
+	configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U ); /* Semaphores and mutexes hold no items. */
+	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
 	{
-		vQueueUnregisterQueue( pxQueue );
+		configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
 	}
 	#endif
 
-	#if( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 0 ) )
+	if( uxMaxCount == ( UBaseType_t ) 0U )
 	{
-		/* The queue can only have been allocated dynamically - free it
-		again. */
-		vPortFree( pxQueue );
+		return ( UBaseType_t ) 0U;
 	}
-	#elif( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
-	{
+
+	/* This function relaxes the coding standard somewhat to allow return
+	statements within the function itself.  This is done in the interest
+	of execution time efficiency. */
+	for( ;; )
+	{
+		taskENTER_CRITICAL();
+		{
+			const UBaseType_t uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+			/* Is there data in the queue now?  Everything that is there, up
+			to uxMaxCount items, is taken in one go. */
+			if( uxMessagesWaiting > ( UBaseType_t ) 0 )
+			{
+				uxCopied = ( uxMaxCount < uxMessagesWaiting ) ? uxMaxCount : uxMessagesWaiting;
+
+				traceQUEUE_RECEIVE( pxQueue );
+				prvCopyMultipleFromQueue( pxQueue, ( int8_t * ) pvBuffer, uxCopied );
+
+				if( prvUnblockWaitingTasks( &( pxQueue->xTasksWaitingToSend ), uxCopied ) != pdFALSE )
+				{
+					queueYIELD_IF_USING_PREEMPTION();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				taskEXIT_CRITICAL();
+				return uxCopied;
+			}
+			else
+			{
+				if( xTicksToWait == ( TickType_t ) 0 )
+				{
+					/* The queue was empty and no block time is specified (or
+					the block time has expired) so leave now. */
+					taskEXIT_CRITICAL();
+					traceQUEUE_RECEIVE_FAILED( pxQueue );
+					return ( UBaseType_t ) 0U;
+				}
+				else if( xEntryTimeSet == pdFALSE )
+				{
+					vTaskSetTimeOutState( &xTimeOut );
+					xEntryTimeSet = pdTRUE;
+				}
+				else
+				{
+					/* Entry time was already set. */
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		vTaskSuspendAll();
+		prvLockQueue( pxQueue );
+
+		/* Update the timeout state to see if it has expired yet. */
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+				queueSTATS_INCREMENT( pxQueue, ulReceiversBlocked );
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
+				prvUnlockQueue( pxQueue );
+
+				if( xTaskResumeAll() == pdFALSE )
+				{
+					portYIELD_WITHIN_API();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				/* Try again. */
+				prvUnlockQueue( pxQueue );
+				( void ) xTaskResumeAll();
+			}
+		}
+		else
+		{
+			prvUnlockQueue( pxQueue );
+			( void ) xTaskResumeAll();
+
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				traceQUEUE_RECEIVE_FAILED( pxQueue );
+				return ( UBaseType_t ) 0U;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t xQueueReceiveMultipleFromISR( QueueHandle_t xQueue, void * const pvBuffer, const UBaseType_t uxMaxCount, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+UBaseType_t uxCopied = 0;
+UBaseType_t uxSavedInterruptStatus;
+Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+
+	configASSERT( pxQueue );
+	queueASSERT_NOT_KEYED( pxQueue );
+	configASSERT( !( ( pvBuffer == NULL ) && ( uxMaxCount != ( UBaseType_t ) 0U ) ) );
+	configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+
+	/* See the comment in xQueueReceiveFromISR(). */
+	portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		const UBaseType_t uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+		/* Cannot block in an ISR, so check there is data available. */
+		if( ( uxMessagesWaiting > ( UBaseType_t ) 0 ) && ( uxMaxCount > ( UBaseType_t ) 0 ) )
+		{
+			const int8_t cRxLock = pxQueue->cRxLock;
+
+			uxCopied = ( uxMaxCount < uxMessagesWaiting ) ? uxMaxCount : uxMessagesWaiting;
+
+			traceQUEUE_RECEIVE_FROM_ISR( pxQueue );
+			prvCopyMultipleFromQueue( pxQueue, ( int8_t * ) pvBuffer, uxCopied );
+
+			/* If the queue is locked the event list will not be modified.
+			Instead update the lock count so the task that unlocks the queue
+			will know how many items an ISR removed while it was locked. */
+			if( cRxLock == queueUNLOCKED )
+			{
+				if( prvUnblockWaitingTasks( &( pxQueue->xTasksWaitingToSend ), uxCopied ) != pdFALSE )
+				{
+					if( pxHigherPriorityTaskWoken != NULL )
+					{
+						*pxHigherPriorityTaskWoken = pdTRUE;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				pxQueue->cRxLock = prvAddToLockCount( cRxLock, uxCopied );
+			}
+		}
+		else
+		{
+			traceQUEUE_RECEIVE_FROM_ISR_FAILED( pxQueue );
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return uxCopied;
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_KEYED_QUEUES == 1 )
+
+	void vQueueSetKeyField( QueueHandle_t xQueue, const UBaseType_t uxKeyOffset, const UBaseType_t uxKeySize )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+
+		configASSERT( pxQueue );
+		configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+		configASSERT( ( uxKeySize == sizeof( uint8_t ) ) || ( uxKeySize == sizeof( uint16_t ) ) || ( uxKeySize == sizeof( uint32_t ) ) );
+		configASSERT( ( uxKeyOffset + uxKeySize ) <= pxQueue->uxItemSize );
+		#if ( configUSE_QUEUE_SETS == 1 )
+		{
+			configASSERT( pxQueue->pxQueueSetContainer == NULL );
+		}
+		#endif
+
+		taskENTER_CRITICAL();
+		{
+			/* Tasks already waiting did not record a key. */
+			configASSERT( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE );
+
+			pxQueue->uxKeyOffset = uxKeyOffset;
+			pxQueue->ucKeySize = ( uint8_t ) uxKeySize;
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_KEYED_QUEUES */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_KEYED_QUEUES == 1 )
+
+	BaseType_t xQueueReceiveKeyed( QueueHandle_t xQueue, void * const pvBuffer, const UBaseType_t uxKey, TickType_t xTicksToWait )
+	{
+	BaseType_t xEntryTimeSet = pdFALSE;
+	TimeOut_t xTimeOut;
+	int8_t *pcItem;
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+
+		configASSERT( pxQueue );
+		configASSERT( pvBuffer );
+		configASSERT( pxQueue->ucKeySize != ( uint8_t ) 0U );
+		#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+		{
+			configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+		}
+		#endif
+
+		/* This function relaxes the coding standard somewhat to allow return
+		statements within the function itself.  This is done in the interest
+		of execution time efficiency. */
+		for( ;; )
+		{
+			taskENTER_CRITICAL();
+			{
+				/* Is there an item with the key in the queue now?  Finding
+				and removing it in the same critical section means no other
+				task can take it in between. */
+				pcItem = prvFindKeyedItem( pxQueue, uxKey );
+
+				if( pcItem != NULL )
+				{
+					traceQUEUE_RECEIVE( pxQueue );
+					prvCopyKeyedItemFromQueue( pxQueue, pcItem, pvBuffer );
+
+					if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) == pdFALSE )
+					{
+						if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE )
+						{
+							queueYIELD_IF_USING_PREEMPTION();
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+
+					taskEXIT_CRITICAL();
+					return pdPASS;
+				}
+				else
+				{
+					if( xTicksToWait == ( TickType_t ) 0 )
+					{
+						/* There is no item with the key and no block time is
+						specified (or the block time has expired) so leave
+						now. */
+						taskEXIT_CRITICAL();
+						traceQUEUE_RECEIVE_FAILED( pxQueue );
+						return errQUEUE_EMPTY;
+					}
+					else if( xEntryTimeSet == pdFALSE )
+					{
+						vTaskSetTimeOutState( &xTimeOut );
+						xEntryTimeSet = pdTRUE;
+					}
+					else
+					{
+						/* Entry time was already set. */
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			vTaskSuspendAll();
+			prvLockQueue( pxQueue );
+
+			/* Update the timeout state to see if it has expired yet. */
+			if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+			{
+				if( prvIsKeyAbsent( pxQueue, uxKey ) != pdFALSE )
+				{
+					/* Only an item with this key will unblock the task, items
+					for other receivers are left to them. */
+					traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+					queueSTATS_INCREMENT( pxQueue, ulReceiversBlocked );
+					vTaskPlaceOnEventListKeyed( &( pxQueue->xTasksWaitingToReceive ), uxKey, xTicksToWait );
+					prvUnlockQueue( pxQueue );
+
+					if( xTaskResumeAll() == pdFALSE )
+					{
+						portYIELD_WITHIN_API();
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				else
+				{
+					/* Try again. */
+					prvUnlockQueue( pxQueue );
+					( void ) xTaskResumeAll();
+				}
+			}
+			else
+			{
+				prvUnlockQueue( pxQueue );
+				( void ) xTaskResumeAll();
+
+				if( prvIsKeyAbsent( pxQueue, uxKey ) != pdFALSE )
+				{
+					traceQUEUE_RECEIVE_FAILED( pxQueue );
+					return errQUEUE_EMPTY;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+	}
+
+#endif /* configUSE_KEYED_QUEUES */
+/*-----------------------------------------------------------*/
+
+BaseType_t xQueuePeekFromISR( QueueHandle_t xQueue,  void * const pvBuffer )
+{
+BaseType_t xReturn;
+UBaseType_t uxSavedInterruptStatus;
+int8_t *pcOriginalReadPosition;
+Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( !( ( pvBuffer == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
+	configASSERT( pxQueue->uxItemSize != 0 ); /* Can't peek a semaphore. */
+
+	/* RTOS ports that support interrupt nesting have the concept of a maximum
+	system call (or maximum API call) interrupt priority.  Interrupts that are
+	above the maximum system call priority are kept permanently enabled, even
+	when the RTOS kernel is in a critical section, but cannot make any calls to
+	FreeRTOS API functions.  If configASSERT() is defined in FreeRTOSConfig.h
+	then portASSERT_IF_INTERRUPT_PRIORITY_INVALID() will result in an assertion
+	failure if a FreeRTOS API function is called from an interrupt that has been
+	assigned a priority above the configured maximum system call priority.
+	Only FreeRTOS functions that end in FromISR can be called from interrupts
+	that have been assigned a priority at or (logically) below the maximum
+	system call	interrupt priority.  FreeRTOS maintains a separate interrupt
+	safe API to ensure interrupt entry is as fast and as simple as possible.
+	More information (albeit Cortex-M specific) is provided on the following
+	link: http://www.freertos.org/RTOS-Cortex-M3-M4.html */
+	portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		/* Cannot block in an ISR, so check there is data available. */
+		if( pxQueue->uxMessagesWaiting > ( UBaseType_t ) 0 )
+		{
+			traceQUEUE_PEEK_FROM_ISR( pxQueue );
+
+			/* Remember the read position so it can be reset as nothing is
+			actually being removed from the queue. */
+			pcOriginalReadPosition = pxQueue->u.pcReadFrom;
+			prvCopyDataFromQueue( pxQueue, pvBuffer );
+			pxQueue->u.pcReadFrom = pcOriginalReadPosition;
+
+			xReturn = pdPASS;
+		}
+		else
+		{
+			xReturn = pdFAIL;
+			traceQUEUE_PEEK_FROM_ISR_FAILED( pxQueue );
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
+{
+UBaseType_t uxReturn;
+
+	configASSERT( xQueue );
+
+	taskENTER_CRITICAL();
+	{
+		uxReturn = ( ( Queue_t * ) xQueue )->uxMessagesWaiting;
+	}
+	taskEXIT_CRITICAL();
+
+	return uxReturn;
+} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
+{
+UBaseType_t uxReturn;
+Queue_t *pxQueue;
+
+	pxQueue = ( Queue_t * ) xQueue;
+	configASSERT( pxQueue );
+
+	taskENTER_CRITICAL();
+	{
+		uxReturn = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
+	}
+	taskEXIT_CRITICAL();
+
+	return uxReturn;
+} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaitingFromISR( const QueueHandle_t xQueue )
+{
+UBaseType_t uxReturn;
+
+	configASSERT( xQueue );
+
+	uxReturn = ( ( Queue_t * ) xQueue )->uxMessagesWaiting;
+
+	return uxReturn;
+} /*lint !e818 Pointer cannot be declared const as xQueue is a typedef not pointer. */
+/*-----------------------------------------------------------*/
+
+void vQueueDelete( QueueHandle_t xQueue )
+{
+Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+
+	configASSERT( pxQueue );
+	traceQUEUE_DELETE( pxQueue );
+
+	#if ( configQUEUE_REGISTRY_SIZE > 0 )
+	{
+		vQueueUnregisterQueue( pxQueue );
+	}
+	#endif
+
+	#if( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 0 ) )
+	{
+		/* The queue can only have been allocated dynamically - free it
+		again. */
+		vPortFree( pxQueue );
+	}
+	#elif( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 ) )
+	{
 		/* The queue could have been allocated statically or dynamically, so
 		check before attempting to free the memory. */
 		if( pxQueue->ucStaticallyAllocated == ( uint8_t ) pdFALSE )
 		{
-			vPortFree( pxQueue );
+			vPortFree( pxQueue );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#else
+	{
+		/* The queue must have been statically allocated, so is not going to be
+		deleted.  Avoid compiler warnings about the unused parameter. */
+		( void ) pxQueue;
+	}
+	#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+	UBaseType_t uxQueueGetQueueNumber( QueueHandle_t xQueue )
+	{
+		return ( ( Queue_t * ) xQueue )->uxQueueNumber;
+	}
+
+#endif /* configUSE_TRACE_FACILITY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+	void vQueueSetQueueNumber( QueueHandle_t xQueue, UBaseType_t uxQueueNumber )
+	{
+		( ( Queue_t * ) xQueue )->uxQueueNumber = uxQueueNumber;
+	}
+
+#endif /* configUSE_TRACE_FACILITY */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TRACE_FACILITY == 1 )
+
+	uint8_t ucQueueGetQueueType( QueueHandle_t xQueue )
+	{
+		return ( ( Queue_t * ) xQueue )->ucQueueType;
+	}
+
+#endif /* configUSE_TRACE_FACILITY */
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvItemToQueue, const BaseType_t xPosition )
+{
+BaseType_t xReturn = pdFALSE;
+UBaseType_t uxMessagesWaiting;
+
+	/* This function is called from a critical section. */
+
+	uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+	if( pxQueue->uxItemSize == ( UBaseType_t ) 0 )
+	{
+		#if ( configUSE_MUTEXES == 1 )
+		{
+			if( pxQueue->uxQueueType == queueQUEUE_IS_MUTEX )
+			{
+				/* The mutex is no longer being held. */
+				xReturn = xTaskPriorityDisinherit( ( void * ) pxQueue->pxMutexHolder );
+				pxQueue->pxMutexHolder = NULL;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif /* configUSE_MUTEXES */
+	}
+	else if( xPosition == queueSEND_TO_BACK )
+	{
+		( void ) memcpy( ( void * ) pxQueue->pcWriteTo, pvItemToQueue, ( size_t ) pxQueue->uxItemSize ); /*lint !e961 !e418 MISRA exception as the casts are only redundant for some ports, plus previous logic ensures a null pointer can only be passed to memcpy() if the copy size is 0. */
+		pxQueue->pcWriteTo += pxQueue->uxItemSize;
+		if( pxQueue->pcWriteTo >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
+		{
+			pxQueue->pcWriteTo = pxQueue->pcHead;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		( void ) memcpy( ( void * ) pxQueue->u.pcReadFrom, pvItemToQueue, ( size_t ) pxQueue->uxItemSize ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+		pxQueue->u.pcReadFrom -= pxQueue->uxItemSize;
+		if( pxQueue->u.pcReadFrom < pxQueue->pcHead ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
+		{
+			pxQueue->u.pcReadFrom = ( pxQueue->pcTail - pxQueue->uxItemSize );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		if( xPosition == queueOVERWRITE )
+		{
+			if( uxMessagesWaiting > ( UBaseType_t ) 0 )
+			{
+				/* An item is not being added but overwritten, so subtract
+				one from the recorded number of items in the queue so when
+				one is added again below the number of recorded items remains
+				correct. */
+				--uxMessagesWaiting;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+	queueSTATS_DEPTH_CHANGE( pxQueue, uxMessagesWaiting + 1 );
+	pxQueue->uxMessagesWaiting = uxMessagesWaiting + 1;
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer )
+{
+	if( pxQueue->uxItemSize != ( UBaseType_t ) 0 )
+	{
+		pxQueue->u.pcReadFrom += pxQueue->uxItemSize;
+		if( pxQueue->u.pcReadFrom >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as use of the relational operator is the cleanest solutions. */
+		{
+			pxQueue->u.pcReadFrom = pxQueue->pcHead;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+		( void ) memcpy( ( void * ) pvBuffer, ( void * ) pxQueue->u.pcReadFrom, ( size_t ) pxQueue->uxItemSize ); /*lint !e961 !e418 MISRA exception as the casts are only redundant for some ports.  Also previous logic ensures a null pointer can only be passed to memcpy() when the count is 0. */
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCopyMultipleToQueue( Queue_t * const pxQueue, const int8_t *pcItems, const UBaseType_t uxCount )
+{
+const size_t xBytes = ( size_t ) uxCount * ( size_t ) pxQueue->uxItemSize;
+const size_t xBytesToTail = ( size_t ) ( pxQueue->pcTail - pxQueue->pcWriteTo );
+
+	/* This function is called from a critical section. */
+
+	if( xBytes < xBytesToTail )
+	{
+		( void ) memcpy( ( void * ) pxQueue->pcWriteTo, ( const void * ) pcItems, xBytes );
+		pxQueue->pcWriteTo += xBytes;
+	}
+	else
+	{
+		/* The items reach the end of the storage area, the remainder goes to
+		the start. */
+		( void ) memcpy( ( void * ) pxQueue->pcWriteTo, ( const void * ) pcItems, xBytesToTail );
+		( void ) memcpy( ( void * ) pxQueue->pcHead, ( const void * ) ( pcItems + xBytesToTail ), xBytes - xBytesToTail );
+		pxQueue->pcWriteTo = pxQueue->pcHead + ( xBytes - xBytesToTail );
+	}
+
+	queueSTATS_DEPTH_CHANGE( pxQueue, pxQueue->uxMessagesWaiting + uxCount );
+	pxQueue->uxMessagesWaiting += uxCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCopyMultipleFromQueue( Queue_t * const pxQueue, int8_t *pcBuffer, const UBaseType_t uxCount )
+{
+const size_t xBytes = ( size_t ) uxCount * ( size_t ) pxQueue->uxItemSize;
+size_t xBytesToTail;
+int8_t *pcReadFrom;
+
+	/* This function is called from a critical section. */
+
+	/* u.pcReadFrom points to the item that was read last, so the first item
+	to read follows it. */
+	pcReadFrom = pxQueue->u.pcReadFrom + pxQueue->uxItemSize;
+	if( pcReadFrom >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as use of the relational operator is the cleanest solutions. */
+	{
+		pcReadFrom = pxQueue->pcHead;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	xBytesToTail = ( size_t ) ( pxQueue->pcTail - pcReadFrom );
+
+	if( xBytes <= xBytesToTail )
+	{
+		( void ) memcpy( ( void * ) pcBuffer, ( void * ) pcReadFrom, xBytes );
+		pxQueue->u.pcReadFrom = pcReadFrom + ( xBytes - pxQueue->uxItemSize );
+	}
+	else
+	{
+		( void ) memcpy( ( void * ) pcBuffer, ( void * ) pcReadFrom, xBytesToTail );
+		( void ) memcpy( ( void * ) ( pcBuffer + xBytesToTail ), ( void * ) pxQueue->pcHead, xBytes - xBytesToTail );
+		pxQueue->u.pcReadFrom = pxQueue->pcHead + ( ( xBytes - xBytesToTail ) - pxQueue->uxItemSize );
+	}
+
+	queueSTATS_DEPTH_CHANGE( pxQueue, pxQueue->uxMessagesWaiting - uxCount );
+	pxQueue->uxMessagesWaiting -= uxCount;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUnblockWaitingTasks( List_t * const pxEventList, UBaseType_t uxMaxTasks )
+{
+BaseType_t xReturn = pdFALSE;
+
+	/* A single waiting task is woken once however many items were moved.
+	Further tasks are only woken while there are items or spaces left for
+	them, so none of them is left blocked while it could proceed. */
+	while( ( uxMaxTasks > ( UBaseType_t ) 0 ) && ( listLIST_IS_EMPTY( pxEventList ) == pdFALSE ) )
+	{
+		if( xTaskRemoveFromEventList( pxEventList ) != pdFALSE )
+		{
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		uxMaxTasks--;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUnblockReceiver( Queue_t * const pxQueue, const void *pvItem )
+{
+BaseType_t xReturn;
+
+	#if ( configUSE_KEYED_QUEUES == 1 )
+	{
+		if( pxQueue->ucKeySize != ( uint8_t ) 0U )
+		{
+			xReturn = xTaskRemoveFromEventListByKey( &( pxQueue->xTasksWaitingToReceive ), prvGetItemKey( pxQueue, pvItem ) );
+		}
+		else
+		{
+			xReturn = xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) );
+		}
+	}
+	#else
+	{
+		( void ) pvItem;
+		xReturn = xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) );
+	}
+	#endif
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUnblockReceivers( Queue_t * const pxQueue, const int8_t *pcItems, const UBaseType_t uxCount )
+{
+BaseType_t xReturn = pdFALSE;
+
+	#if ( configUSE_KEYED_QUEUES == 1 )
+	{
+		if( pxQueue->ucKeySize != ( uint8_t ) 0U )
+		{
+		UBaseType_t ux;
+
+			/* Each item can only wake a task that waits for its key. */
+			for( ux = 0; ( ux < uxCount ) && ( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE ); ux++ )
+			{
+				if( prvUnblockReceiver( pxQueue, pcItems + ( ux * pxQueue->uxItemSize ) ) != pdFALSE )
+				{
+					xReturn = pdTRUE;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
 		}
 		else
 		{
-			mtCOVERAGE_TEST_MARKER();
+			xReturn = prvUnblockWaitingTasks( &( pxQueue->xTasksWaitingToReceive ), uxCount );
 		}
 	}
 	#else
 	{
-		/* The queue must have been statically allocated, so is not going to be
-		deleted.  Avoid compiler warnings about the unused parameter. */
-		( void ) pxQueue;
+		( void ) pcItems;
+		xReturn = prvUnblockWaitingTasks( &( pxQueue->xTasksWaitingToReceive ), uxCount );
 	}
-	#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+	#endif
+
+	return xReturn;
 }
 /*-----------------------------------------------------------*/
 
-#if ( configUSE_TRACE_FACILITY == 1 )
+#if ( configUSE_KEYED_QUEUES == 1 )
 
-	UBaseType_t uxQueueGetQueueNumber( QueueHandle_t xQueue )
+	static UBaseType_t prvGetItemKey( const Queue_t * const pxQueue, const void *pvItem )
 	{
-		return ( ( Queue_t * ) xQueue )->uxQueueNumber;
-	}
-
-#endif /* configUSE_TRACE_FACILITY */
-/*-----------------------------------------------------------*/
-
-#if ( configUSE_TRACE_FACILITY == 1 )
+	const uint8_t * const pucKey = ( ( const uint8_t * ) pvItem ) + pxQueue->uxKeyOffset;
+	UBaseType_t uxKey;
 
-	void vQueueSetQueueNumber( QueueHandle_t xQueue, UBaseType_t uxQueueNumber )
-	{
-		( ( Queue_t * ) xQueue )->uxQueueNumber = uxQueueNumber;
-	}
+		/* The key field is copied out as the items are not necessarily
+		aligned for its type. */
+		if( pxQueue->ucKeySize == ( uint8_t ) sizeof( uint8_t ) )
+		{
+			uxKey = ( UBaseType_t ) *pucKey;
+		}
+		else if( pxQueue->ucKeySize == ( uint8_t ) sizeof( uint16_t ) )
+		{
+		uint16_t usKey;
 
-#endif /* configUSE_TRACE_FACILITY */
-/*-----------------------------------------------------------*/
+			( void ) memcpy( ( void * ) &usKey, ( const void * ) pucKey, sizeof( usKey ) );
+			uxKey = ( UBaseType_t ) usKey;
+		}
+		else
+		{
+		uint32_t ulKey;
 
-#if ( configUSE_TRACE_FACILITY == 1 )
+			( void ) memcpy( ( void * ) &ulKey, ( const void * ) pucKey, sizeof( ulKey ) );
+			uxKey = ( UBaseType_t ) ulKey;
+		}
 
-	uint8_t ucQueueGetQueueType( QueueHandle_t xQueue )
-	{
-		return ( ( Queue_t * ) xQueue )->ucQueueType;
+		return uxKey;
 	}
+	/*-----------------------------------------------------------*/
 
-#endif /* configUSE_TRACE_FACILITY */
-/*-----------------------------------------------------------*/
-
-static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvItemToQueue, const BaseType_t xPosition )
-{
-BaseType_t xReturn = pdFALSE;
-UBaseType_t uxMessagesWaiting;
-
-	/* This function is called from a critical section. */
+	static int8_t *prvFindKeyedItem( const Queue_t * const pxQueue, const UBaseType_t uxKey )
+	{
+	int8_t *pcItem = pxQueue->u.pcReadFrom;
+	UBaseType_t uxItems;
 
-	uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+		/* This function is called from a critical section. */
 
-	if( pxQueue->uxItemSize == ( UBaseType_t ) 0 )
-	{
-		#if ( configUSE_MUTEXES == 1 )
+		for( uxItems = pxQueue->uxMessagesWaiting; uxItems > ( UBaseType_t ) 0; uxItems-- )
 		{
-			if( pxQueue->uxQueueType == queueQUEUE_IS_MUTEX )
+			pcItem += pxQueue->uxItemSize;
+			if( pcItem >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
 			{
-				/* The mutex is no longer being held. */
-				xReturn = xTaskPriorityDisinherit( ( void * ) pxQueue->pxMutexHolder );
-				pxQueue->pxMutexHolder = NULL;
+				pcItem = pxQueue->pcHead;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			if( prvGetItemKey( pxQueue, pcItem ) == uxKey )
+			{
+				return pcItem;
 			}
 			else
 			{
 				mtCOVERAGE_TEST_MARKER();
 			}
 		}
-		#endif /* configUSE_MUTEXES */
+
+		return NULL;
 	}
-	else if( xPosition == queueSEND_TO_BACK )
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvIsKeyAbsent( const Queue_t *pxQueue, const UBaseType_t uxKey )
 	{
-		( void ) memcpy( ( void * ) pxQueue->pcWriteTo, pvItemToQueue, ( size_t ) pxQueue->uxItemSize ); /*lint !e961 !e418 MISRA exception as the casts are only redundant for some ports, plus previous logic ensures a null pointer can only be passed to memcpy() if the copy size is 0. */
-		pxQueue->pcWriteTo += pxQueue->uxItemSize;
-		if( pxQueue->pcWriteTo >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
-		{
-			pxQueue->pcWriteTo = pxQueue->pcHead;
-		}
-		else
+	BaseType_t xReturn;
+
+		taskENTER_CRITICAL();
 		{
-			mtCOVERAGE_TEST_MARKER();
+			if( prvFindKeyedItem( pxQueue, uxKey ) == NULL )
+			{
+				xReturn = pdTRUE;
+			}
+			else
+			{
+				xReturn = pdFALSE;
+			}
 		}
+		taskEXIT_CRITICAL();
+
+		return xReturn;
 	}
-	else
+	/*-----------------------------------------------------------*/
+
+	static void prvCopyKeyedItemFromQueue( Queue_t * const pxQueue, int8_t *pcItem, void * const pvBuffer )
 	{
-		( void ) memcpy( ( void * ) pxQueue->u.pcReadFrom, pvItemToQueue, ( size_t ) pxQueue->uxItemSize ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
-		pxQueue->u.pcReadFrom -= pxQueue->uxItemSize;
-		if( pxQueue->u.pcReadFrom < pxQueue->pcHead ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
+	int8_t *pcOldest, *pcPrevious;
+
+		/* This function is called from a critical section. */
+
+		( void ) memcpy( pvBuffer, ( void * ) pcItem, ( size_t ) pxQueue->uxItemSize );
+
+		pcOldest = pxQueue->u.pcReadFrom + pxQueue->uxItemSize;
+		if( pcOldest >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
 		{
-			pxQueue->u.pcReadFrom = ( pxQueue->pcTail - pxQueue->uxItemSize );
+			pcOldest = pxQueue->pcHead;
 		}
 		else
 		{
 			mtCOVERAGE_TEST_MARKER();
 		}
 
-		if( xPosition == queueOVERWRITE )
+		/* Move the items that were queued before the one taken up by one
+		place.  Nothing moves when the oldest item is taken. */
+		while( pcItem != pcOldest )
 		{
-			if( uxMessagesWaiting > ( UBaseType_t ) 0 )
+			if( pcItem == pxQueue->pcHead )
 			{
-				/* An item is not being added but overwritten, so subtract
-				one from the recorded number of items in the queue so when
-				one is added again below the number of recorded items remains
-				correct. */
-				--uxMessagesWaiting;
+				pcPrevious = pxQueue->pcTail - pxQueue->uxItemSize;
 			}
 			else
 			{
-				mtCOVERAGE_TEST_MARKER();
+				pcPrevious = pcItem - pxQueue->uxItemSize;
 			}
+
+			( void ) memcpy( ( void * ) pcItem, ( void * ) pcPrevious, ( size_t ) pxQueue->uxItemSize );
+			pcItem = pcPrevious;
 		}
-		else
-		{
-			mtCOVERAGE_TEST_MARKER();
-		}
-	}
 
-	pxQueue->uxMessagesWaiting = uxMessagesWaiting + 1;
+		/* The place of the oldest item is now free, which is what reading it
+		would have done. */
+		pxQueue->u.pcReadFrom = pcOldest;
 
-	return xReturn;
-}
+		queueSTATS_DEPTH_CHANGE( pxQueue, pxQueue->uxMessagesWaiting - 1 );
+		pxQueue->uxMessagesWaiting--;
+	}
+
+#endif /* configUSE_KEYED_QUEUES */
 /*-----------------------------------------------------------*/
 
-static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer )
+static int8_t prvAddToLockCount( const int8_t cLockCount, const UBaseType_t uxCount )
 {
-	if( pxQueue->uxItemSize != ( UBaseType_t ) 0 )
+int8_t cReturn;
+
+	/* Each count unblocks at most one task when the queue is unlocked, so
+	saturating loses nothing unless more than queueMAX_LOCK_COUNT tasks are
+	blocked on the queue. */
+	if( uxCount >= ( UBaseType_t ) ( queueMAX_LOCK_COUNT - cLockCount ) )
 	{
-		pxQueue->u.pcReadFrom += pxQueue->uxItemSize;
-		if( pxQueue->u.pcReadFrom >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as use of the relational operator is the cleanest solutions. */
-		{
-			pxQueue->u.pcReadFrom = pxQueue->pcHead;
-		}
-		else
-		{
-			mtCOVERAGE_TEST_MARKER();
-		}
-		( void ) memcpy( ( void * ) pvBuffer, ( void * ) pxQueue->u.pcReadFrom, ( size_t ) pxQueue->uxItemSize ); /*lint !e961 !e418 MISRA exception as the casts are only redundant for some ports.  Also previous logic ensures a null pointer can only be passed to memcpy() when the count is 0. */
+		cReturn = queueMAX_LOCK_COUNT;
+	}
+	else
+	{
+		cReturn = ( int8_t ) ( cLockCount + ( int8_t ) uxCount );
 	}
+
+	return cReturn;
 }
 /*-----------------------------------------------------------*/
 
@@ -1803,6 +2796,51 @@ static void prvUnlockQueue( Queue_t * const pxQueue )
 	{
 		int8_t cTxLock = pxQueue->cTxLock;
 
+		#if ( configUSE_KEYED_QUEUES == 1 )
+		{
+			if( ( cTxLock > queueLOCKED_UNMODIFIED ) && ( pxQueue->ucKeySize != ( uint8_t ) 0U ) )
+			{
+			int8_t *pcItem = pxQueue->u.pcReadFrom;
+			UBaseType_t uxItems = pxQueue->uxMessagesWaiting;
+
+				/* Only the number of items posted while the queue was locked
+				is known, not their keys.  A task only blocks while the queue
+				holds no item with its key, so offering every item in the queue
+				to the waiting tasks wakes exactly the tasks whose items
+				arrived. */
+				while( ( uxItems > ( UBaseType_t ) 0 ) && ( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE ) )
+				{
+					pcItem += pxQueue->uxItemSize;
+					if( pcItem >= pxQueue->pcTail ) /*lint !e946 MISRA exception justified as comparison of pointers is the cleanest solution. */
+					{
+						pcItem = pxQueue->pcHead;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+
+					if( prvUnblockReceiver( pxQueue, pcItem ) != pdFALSE )
+					{
+						vTaskMissedYield();
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+
+					uxItems--;
+				}
+
+				cTxLock = queueLOCKED_UNMODIFIED;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif /* configUSE_KEYED_QUEUES */
+
 		/* See if data was added to the queue while it was locked. */
 		while( cTxLock > queueLOCKED_UNMODIFIED )
 		{
@@ -2353,6 +3391,171 @@ BaseType_t xReturn;
 #endif /* configQUEUE_REGISTRY_SIZE */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_QUEUE_STATS == 1 )
+
+	static void prvRecordDepthChange( Queue_t * const pxQueue, const UBaseType_t uxNewMessagesWaiting )
+	{
+	const TickType_t xTimeNow = xTaskGetTickCountFromISR();
+	const UBaseType_t uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+	uint32_t ulArea;
+
+		/* This function is called from a critical section. */
+
+		/* The queue held uxMessagesWaiting items since the last change, so
+		add the area under the depth curve.  Every tick an item spends in the
+		queue adds exactly one to the integral, which is what allows the
+		average residency to be calculated without time stamping items. */
+		ulArea = ( uint32_t ) uxMessagesWaiting * ( uint32_t ) ( TickType_t ) ( xTimeNow - pxQueue->xLastDepthChange );
+		pxQueue->xLastDepthChange = xTimeNow;
+
+		/* The integral is below 0x80000000 here, so only an area that alone
+		is larger than that, a deep queue left unchanged for a long time, can
+		overflow it.  It saturates instead of wrapping. */
+		if( ulArea > ( 0xFFFFFFFFUL - pxQueue->ulDepthTicks ) )
+		{
+			pxQueue->ulDepthTicks = 0xFFFFFFFFUL;
+		}
+		else
+		{
+			pxQueue->ulDepthTicks += ulArea;
+		}
+
+		/* Halve both terms of the average before the integral can
+		overflow.  The ratio is preserved and older samples gradually carry
+		less weight.  This is done on every change, not only on removals, so
+		a queue that is never emptied does not overflow either. */
+		if( pxQueue->ulDepthTicks >= 0x80000000UL )
+		{
+			pxQueue->ulDepthTicks >>= 1;
+			pxQueue->ulResidencyItems >>= 1;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		if( uxNewMessagesWaiting < uxMessagesWaiting )
+		{
+			pxQueue->ulItemsRemoved += ( uint32_t ) ( uxMessagesWaiting - uxNewMessagesWaiting );
+			pxQueue->ulResidencyItems += ( uint32_t ) ( uxMessagesWaiting - uxNewMessagesWaiting );
+		}
+		else if( uxNewMessagesWaiting > pxQueue->uxMessagesWaitingHighWater )
+		{
+			pxQueue->uxMessagesWaitingHighWater = uxNewMessagesWaiting;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* configUSE_QUEUE_STATS */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_QUEUE_STATS == 1 )
+
+	void vQueueGetStats( QueueHandle_t xQueue, QueueStats_t *pxStats )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+
+		configASSERT( pxQueue );
+		configASSERT( pxStats );
+
+		taskENTER_CRITICAL();
+		{
+			/* Bring the depth integral up to date so items that are still
+			queued are accounted for. */
+			prvRecordDepthChange( pxQueue, pxQueue->uxMessagesWaiting );
+
+			pxStats->uxMessagesWaitingHighWater = pxQueue->uxMessagesWaitingHighWater;
+			pxStats->ulSendFailures = pxQueue->ulSendFailures;
+			pxStats->ulSendFailuresFromISR = pxQueue->ulSendFailuresFromISR;
+			pxStats->ulSendersBlocked = pxQueue->ulSendersBlocked;
+			pxStats->ulReceiversBlocked = pxQueue->ulReceiversBlocked;
+			pxStats->ulItemsRemoved = pxQueue->ulItemsRemoved;
+
+			if( pxQueue->ulResidencyItems > 0UL )
+			{
+				pxStats->xAverageResidency = ( TickType_t ) ( pxQueue->ulDepthTicks / pxQueue->ulResidencyItems );
+			}
+			else
+			{
+				pxStats->xAverageResidency = ( TickType_t ) 0;
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_QUEUE_STATS */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_QUEUE_STATS == 1 )
+
+	void vQueueResetStats( QueueHandle_t xQueue )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+
+		configASSERT( pxQueue );
+
+		taskENTER_CRITICAL();
+		{
+			pxQueue->uxMessagesWaitingHighWater = pxQueue->uxMessagesWaiting;
+			pxQueue->xLastDepthChange = xTaskGetTickCountFromISR();
+			pxQueue->ulSendFailures = 0UL;
+			pxQueue->ulSendFailuresFromISR = 0UL;
+			pxQueue->ulSendersBlocked = 0UL;
+			pxQueue->ulReceiversBlocked = 0UL;
+			pxQueue->ulItemsRemoved = 0UL;
+			pxQueue->ulDepthTicks = 0UL;
+			pxQueue->ulResidencyItems = 0UL;
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configUSE_QUEUE_STATS */
+/*-----------------------------------------------------------*/
+
+#if ( ( configUSE_QUEUE_STATS == 1 ) && ( configQUEUE_REGISTRY_SIZE > 0 ) )
+
+	BaseType_t xQueueGetRegistryStats( UBaseType_t uxIndex, const char **ppcQueueName, QueueStats_t *pxStats ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+	{
+	BaseType_t xReturn = pdFAIL;
+	const char *pcQueueName; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+	QueueHandle_t xHandle;
+
+		if( uxIndex < ( UBaseType_t ) configQUEUE_REGISTRY_SIZE )
+		{
+			/* Take a copy of the slot so it cannot change between the check
+			and the use. */
+			taskENTER_CRITICAL();
+			{
+				pcQueueName = xQueueRegistry[ uxIndex ].pcQueueName;
+				xHandle = xQueueRegistry[ uxIndex ].xHandle;
+			}
+			taskEXIT_CRITICAL();
+
+			if( pcQueueName != NULL )
+			{
+				*ppcQueueName = pcQueueName;
+				vQueueGetStats( xHandle, pxStats );
+				xReturn = pdPASS;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return xReturn;
+	}
+
+#endif /* configUSE_QUEUE_STATS && configQUEUE_REGISTRY_SIZE */
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_TIMERS == 1 )
 
 	void vQueueWaitForMessageRestricted( QueueHandle_t xQueue, TickType_t xTicksToWait, const BaseType_t xWaitIndefinitely )
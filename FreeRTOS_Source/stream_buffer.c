@@ -0,0 +1,789 @@
+/*
+ * Stream and message buffers, see stream_buffer.h and message_buffer.h.
+ *
+ * The buffer is a circular byte array with one byte always left free, so the
+ * head and tail indexes alone tell a full buffer from an empty one.  Only the
+ * writer moves the head and only the reader moves the tail, and each index is
+ * updated once, after the bytes it covers have been copied, so the two sides
+ * never need a critical section to move data.  Critical sections are only
+ * used to close the window between a task deciding to block and recording
+ * itself as the waiting task.
+ *
+ *    1 tab == 4 spaces!
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stream_buffer.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE /*lint !e961 !e750. */
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error stream_buffer.c requires configSUPPORT_DYNAMIC_ALLOCATION set to 1
+#endif
+
+#if( configUSE_TASK_NOTIFICATIONS != 1 )
+	#error stream_buffer.c requires configUSE_TASK_NOTIFICATIONS set to 1
+#endif
+
+#if( ( INCLUDE_xTaskGetCurrentTaskHandle != 1 ) && ( configUSE_MUTEXES != 1 ) )
+	#error stream_buffer.c requires INCLUDE_xTaskGetCurrentTaskHandle or configUSE_MUTEXES set to 1
+#endif
+
+/* Every message in a message buffer is preceded by its length. */
+#define sbBYTES_TO_STORE_MESSAGE_LENGTH		( sizeof( size_t ) )
+
+/* Bits used in ucFlags. */
+#define sbFLAGS_IS_MESSAGE_BUFFER			( ( uint8_t ) 1 )
+
+typedef struct xSTREAM_BUFFER
+{
+	volatile size_t xTail;						/*< Index of the next byte to read.  Only written by the reader. */
+	volatile size_t xHead;						/*< Index of the next byte to write.  Only written by the writer. */
+	size_t xLength;								/*< Size of the storage area, one byte more than the buffer can hold. */
+	size_t xTriggerLevelBytes;					/*< Bytes that must be in the buffer before a blocked reader is unblocked. */
+	volatile TaskHandle_t xTaskWaitingToReceive;	/*< Reader blocked on an empty buffer, or NULL. */
+	volatile TaskHandle_t xTaskWaitingToSend;		/*< Writer blocked on a full buffer, or NULL. */
+	uint8_t *pucBuffer;							/*< Storage area, placed directly after this structure. */
+	uint8_t ucFlags;
+} StreamBuffer_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Number of bytes that can be read from the buffer.
+ */
+static size_t prvBytesInBuffer( const StreamBuffer_t * const pxStreamBuffer ) PRIVILEGED_FUNCTION;
+
+/*
+ * Copy xCount bytes into the storage area starting at index xHead, wrapping at
+ * the end of the storage area.  Returns the index following the last byte
+ * written.  The head of the buffer itself is not moved.
+ */
+static size_t prvWriteBytes( StreamBuffer_t * const pxStreamBuffer, const uint8_t *pucData, size_t xCount, size_t xHead ) PRIVILEGED_FUNCTION;
+
+/*
+ * Copy xCount bytes out of the storage area starting at index xTail, wrapping
+ * at the end of the storage area.  Returns the index following the last byte
+ * read.  The tail of the buffer itself is not moved.
+ */
+static size_t prvReadBytes( const StreamBuffer_t * const pxStreamBuffer, uint8_t *pucData, size_t xCount, size_t xTail ) PRIVILEGED_FUNCTION;
+
+/*
+ * Write as much of pvTxData as the semantics of the buffer allow: as many
+ * bytes as fit for a stream buffer, the whole message or nothing for a message
+ * buffer.  Returns the number of data bytes written.
+ */
+static size_t prvWriteMessageToBuffer( StreamBuffer_t * const pxStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, size_t xSpace ) PRIVILEGED_FUNCTION;
+
+/*
+ * Read as many bytes as are available and fit in pvRxData from a stream
+ * buffer, or the oldest message from a message buffer if it fits in pvRxData.
+ * Returns the number of data bytes read.
+ */
+static size_t prvReadMessageFromBuffer( StreamBuffer_t * const pxStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, size_t xBytesAvailable ) PRIVILEGED_FUNCTION;
+
+/*
+ * Notify the task, if any, recorded in *pxWaitingTask and clear the record.
+ */
+static void prvUnblockWaitingTask( TaskHandle_t volatile * const pxWaitingTask ) PRIVILEGED_FUNCTION;
+static void prvUnblockWaitingTaskFromISR( TaskHandle_t volatile * const pxWaitingTask, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+StreamBufferHandle_t xStreamBufferGenericCreate( size_t xBufferSizeBytes, size_t xTriggerLevelBytes, BaseType_t xIsMessageBuffer )
+{
+StreamBuffer_t *pxStreamBuffer;
+size_t xLength;
+
+	if( xIsMessageBuffer != pdFALSE )
+	{
+		/* A message buffer must at least hold the length of one message. */
+		configASSERT( xBufferSizeBytes > sbBYTES_TO_STORE_MESSAGE_LENGTH );
+
+		/* Every message unblocks the reader. */
+		xTriggerLevelBytes = ( size_t ) 1;
+	}
+	else
+	{
+		configASSERT( xBufferSizeBytes > ( size_t ) 0 );
+	}
+
+	configASSERT( xTriggerLevelBytes <= xBufferSizeBytes );
+
+	if( xTriggerLevelBytes == ( size_t ) 0 )
+	{
+		xTriggerLevelBytes = ( size_t ) 1;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	/* One byte of the storage area is never used, see the top of this file.
+	Check the total does not wrap around. */
+	xLength = xBufferSizeBytes + ( size_t ) 1;
+	configASSERT( ( sizeof( StreamBuffer_t ) + xLength ) > xLength );
+
+	pxStreamBuffer = ( StreamBuffer_t * ) portMALLOC_TAGGED( sizeof( StreamBuffer_t ) + xLength, eHeapTagStreamBuffer );
+
+	if( pxStreamBuffer != NULL )
+	{
+		memset( ( void * ) pxStreamBuffer, 0x00, sizeof( StreamBuffer_t ) );
+		pxStreamBuffer->pucBuffer = ( ( uint8_t * ) pxStreamBuffer ) + sizeof( StreamBuffer_t );
+		pxStreamBuffer->xLength = xLength;
+		pxStreamBuffer->xTriggerLevelBytes = xTriggerLevelBytes;
+
+		if( xIsMessageBuffer != pdFALSE )
+		{
+			pxStreamBuffer->ucFlags |= sbFLAGS_IS_MESSAGE_BUFFER;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return ( StreamBufferHandle_t ) pxStreamBuffer;
+}
+/*-----------------------------------------------------------*/
+
+void vStreamBufferDelete( StreamBufferHandle_t xStreamBuffer )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+	configASSERT( pxStreamBuffer->xTaskWaitingToReceive == NULL );
+	configASSERT( pxStreamBuffer->xTaskWaitingToSend == NULL );
+
+	vPortFree( ( void * ) pxStreamBuffer );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferReset( StreamBufferHandle_t xStreamBuffer )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+BaseType_t xReturn = pdFAIL;
+
+	configASSERT( pxStreamBuffer );
+
+	taskENTER_CRITICAL();
+	{
+		if( ( pxStreamBuffer->xTaskWaitingToReceive == NULL ) && ( pxStreamBuffer->xTaskWaitingToSend == NULL ) )
+		{
+			pxStreamBuffer->xHead = ( size_t ) 0;
+			pxStreamBuffer->xTail = ( size_t ) 0;
+			xReturn = pdPASS;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferSetTriggerLevel( StreamBufferHandle_t xStreamBuffer, size_t xTriggerLevel )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+BaseType_t xReturn;
+
+	configASSERT( pxStreamBuffer );
+
+	if( xTriggerLevel == ( size_t ) 0 )
+	{
+		xTriggerLevel = ( size_t ) 1;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	/* The trigger level cannot exceed what the buffer can hold, the reader
+	would never be unblocked. */
+	if( xTriggerLevel < pxStreamBuffer->xLength )
+	{
+		pxStreamBuffer->xTriggerLevelBytes = xTriggerLevel;
+		xReturn = pdPASS;
+	}
+	else
+	{
+		xReturn = pdFAIL;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSpacesAvailable( StreamBufferHandle_t xStreamBuffer )
+{
+const StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+
+	return ( pxStreamBuffer->xLength - ( size_t ) 1 ) - prvBytesInBuffer( pxStreamBuffer );
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferBytesAvailable( StreamBufferHandle_t xStreamBuffer )
+{
+const StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+
+	return prvBytesInBuffer( pxStreamBuffer );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferIsEmpty( StreamBufferHandle_t xStreamBuffer )
+{
+const StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+
+	return ( pxStreamBuffer->xHead == pxStreamBuffer->xTail ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferIsFull( StreamBufferHandle_t xStreamBuffer )
+{
+const StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xBytesToStoreMessageLength;
+
+	configASSERT( pxStreamBuffer );
+
+	/* A message buffer is full when not even an empty message fits. */
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xBytesToStoreMessageLength = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xBytesToStoreMessageLength = ( size_t ) 0;
+	}
+
+	return ( xStreamBufferSpacesAvailable( xStreamBuffer ) <= xBytesToStoreMessageLength ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferNextMessageLengthBytes( StreamBufferHandle_t xStreamBuffer )
+{
+const StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xNextMessageLength = ( size_t ) 0;
+
+	configASSERT( pxStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		if( prvBytesInBuffer( pxStreamBuffer ) > sbBYTES_TO_STORE_MESSAGE_LENGTH )
+		{
+			( void ) prvReadBytes( pxStreamBuffer, ( uint8_t * ) &xNextMessageLength, sbBYTES_TO_STORE_MESSAGE_LENGTH, pxStreamBuffer->xTail );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xNextMessageLength;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSend( StreamBufferHandle_t xStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, TickType_t xTicksToWait )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xReturn, xSpace;
+size_t xRequiredSpace = xDataLengthBytes;
+TimeOut_t xTimeOut;
+
+	configASSERT( pvTxData );
+	configASSERT( pxStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xRequiredSpace += sbBYTES_TO_STORE_MESSAGE_LENGTH;
+
+		/* A message that cannot fit even in an empty buffer would block
+		forever. */
+		configASSERT( xRequiredSpace < pxStreamBuffer->xLength );
+	}
+	else
+	{
+		/* A stream buffer takes what fits, so the most it can be asked to
+		wait for is the space of an empty buffer. */
+		if( xRequiredSpace > ( pxStreamBuffer->xLength - ( size_t ) 1 ) )
+		{
+			xRequiredSpace = pxStreamBuffer->xLength - ( size_t ) 1;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+	if( xTicksToWait != ( TickType_t ) 0 )
+	{
+		vTaskSetTimeOutState( &xTimeOut );
+
+		do
+		{
+			/* The reader may free space between the check and the wait, so
+			the check and the recording of this task as the waiting task are
+			made in one critical section, and the notification state is
+			cleared first so a notification sent after it is not lost. */
+			taskENTER_CRITICAL();
+			{
+				xSpace = xStreamBufferSpacesAvailable( xStreamBuffer );
+
+				if( xSpace < xRequiredSpace )
+				{
+					( void ) xTaskNotifyStateClear( NULL );
+
+					/* Only one writer may use the buffer. */
+					configASSERT( pxStreamBuffer->xTaskWaitingToSend == NULL );
+					pxStreamBuffer->xTaskWaitingToSend = xTaskGetCurrentTaskHandle();
+				}
+				else
+				{
+					taskEXIT_CRITICAL();
+					break;
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+			pxStreamBuffer->xTaskWaitingToSend = NULL;
+
+		} while( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	xSpace = xStreamBufferSpacesAvailable( xStreamBuffer );
+	xReturn = prvWriteMessageToBuffer( pxStreamBuffer, pvTxData, xDataLengthBytes, xSpace );
+
+	if( xReturn > ( size_t ) 0 )
+	{
+		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+		{
+			prvUnblockWaitingTask( &( pxStreamBuffer->xTaskWaitingToReceive ) );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSendFromISR( StreamBufferHandle_t xStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xReturn, xSpace;
+
+	configASSERT( pvTxData );
+	configASSERT( pxStreamBuffer );
+
+	xSpace = xStreamBufferSpacesAvailable( xStreamBuffer );
+	xReturn = prvWriteMessageToBuffer( pxStreamBuffer, pvTxData, xDataLengthBytes, xSpace );
+
+	if( xReturn > ( size_t ) 0 )
+	{
+		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+		{
+			prvUnblockWaitingTaskFromISR( &( pxStreamBuffer->xTaskWaitingToReceive ), pxHigherPriorityTaskWoken );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferReceive( StreamBufferHandle_t xStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xReceivedLength = ( size_t ) 0, xBytesAvailable, xBytesToStoreMessageLength;
+
+	configASSERT( pvRxData );
+	configASSERT( pxStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xBytesToStoreMessageLength = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xBytesToStoreMessageLength = ( size_t ) 0;
+	}
+
+	if( xTicksToWait != ( TickType_t ) 0 )
+	{
+		/* As in xStreamBufferSend(), the check and the recording of this task
+		as the waiting task must not be separated by a write. */
+		taskENTER_CRITICAL();
+		{
+			xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+			if( xBytesAvailable <= xBytesToStoreMessageLength )
+			{
+				( void ) xTaskNotifyStateClear( NULL );
+
+				/* Only one reader may use the buffer. */
+				configASSERT( pxStreamBuffer->xTaskWaitingToReceive == NULL );
+				pxStreamBuffer->xTaskWaitingToReceive = xTaskGetCurrentTaskHandle();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( xBytesAvailable <= xBytesToStoreMessageLength )
+		{
+			/* The writer only notifies once the trigger level is reached, so
+			a single wait is enough. */
+			( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+			pxStreamBuffer->xTaskWaitingToReceive = NULL;
+
+			xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+	}
+
+	if( xBytesAvailable > xBytesToStoreMessageLength )
+	{
+		xReceivedLength = prvReadMessageFromBuffer( pxStreamBuffer, pvRxData, xBufferLengthBytes, xBytesAvailable );
+
+		if( xReceivedLength != ( size_t ) 0 )
+		{
+			prvUnblockWaitingTask( &( pxStreamBuffer->xTaskWaitingToSend ) );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReceivedLength;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferReceiveFromISR( StreamBufferHandle_t xStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xReceivedLength = ( size_t ) 0, xBytesAvailable, xBytesToStoreMessageLength;
+
+	configASSERT( pvRxData );
+	configASSERT( pxStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xBytesToStoreMessageLength = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xBytesToStoreMessageLength = ( size_t ) 0;
+	}
+
+	xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+	if( xBytesAvailable > xBytesToStoreMessageLength )
+	{
+		xReceivedLength = prvReadMessageFromBuffer( pxStreamBuffer, pvRxData, xBufferLengthBytes, xBytesAvailable );
+
+		if( xReceivedLength != ( size_t ) 0 )
+		{
+			prvUnblockWaitingTaskFromISR( &( pxStreamBuffer->xTaskWaitingToSend ), pxHigherPriorityTaskWoken );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReceivedLength;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvWriteMessageToBuffer( StreamBuffer_t * const pxStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, size_t xSpace )
+{
+size_t xNextHead = pxStreamBuffer->xHead;
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		/* The whole message and its length, or nothing.  An empty message is
+		not stored, the reader could not tell it from no message at all. */
+		if( ( xDataLengthBytes != ( size_t ) 0 ) && ( xSpace >= ( xDataLengthBytes + sbBYTES_TO_STORE_MESSAGE_LENGTH ) ) )
+		{
+			xNextHead = prvWriteBytes( pxStreamBuffer, ( const uint8_t * ) &xDataLengthBytes, sbBYTES_TO_STORE_MESSAGE_LENGTH, xNextHead );
+		}
+		else
+		{
+			xDataLengthBytes = ( size_t ) 0;
+		}
+	}
+	else if( xDataLengthBytes > xSpace )
+	{
+		xDataLengthBytes = xSpace;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	if( xDataLengthBytes != ( size_t ) 0 )
+	{
+		xNextHead = prvWriteBytes( pxStreamBuffer, ( const uint8_t * ) pvTxData, xDataLengthBytes, xNextHead );
+
+		/* Publish the length and the data to the reader in one step. */
+		pxStreamBuffer->xHead = xNextHead;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xDataLengthBytes;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvReadMessageFromBuffer( StreamBuffer_t * const pxStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, size_t xBytesAvailable )
+{
+size_t xCount, xNextMessageLength;
+size_t xNextTail = pxStreamBuffer->xTail;
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xNextTail = prvReadBytes( pxStreamBuffer, ( uint8_t * ) &xNextMessageLength, sbBYTES_TO_STORE_MESSAGE_LENGTH, xNextTail );
+		xBytesAvailable -= sbBYTES_TO_STORE_MESSAGE_LENGTH;
+
+		/* A message too long for pvRxData is left in the buffer. */
+		if( xNextMessageLength > xBufferLengthBytes )
+		{
+			xNextMessageLength = ( size_t ) 0;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	else
+	{
+		xNextMessageLength = xBufferLengthBytes;
+	}
+
+	xCount = ( xNextMessageLength < xBytesAvailable ) ? xNextMessageLength : xBytesAvailable;
+
+	if( xCount != ( size_t ) 0 )
+	{
+		xNextTail = prvReadBytes( pxStreamBuffer, ( uint8_t * ) pvRxData, xCount, xNextTail );
+
+		/* Hand the space back to the writer only once it has been copied
+		out. */
+		pxStreamBuffer->xTail = xNextTail;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvWriteBytes( StreamBuffer_t * const pxStreamBuffer, const uint8_t *pucData, size_t xCount, size_t xHead )
+{
+size_t xFirstLength;
+
+	/* Up to the end of the storage area, then the remainder from the start. */
+	xFirstLength = pxStreamBuffer->xLength - xHead;
+
+	if( xFirstLength > xCount )
+	{
+		xFirstLength = xCount;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	( void ) memcpy( ( void * ) &( pxStreamBuffer->pucBuffer[ xHead ] ), ( const void * ) pucData, xFirstLength );
+
+	if( xCount > xFirstLength )
+	{
+		( void ) memcpy( ( void * ) pxStreamBuffer->pucBuffer, ( const void * ) &( pucData[ xFirstLength ] ), xCount - xFirstLength );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	xHead += xCount;
+
+	if( xHead >= pxStreamBuffer->xLength )
+	{
+		xHead -= pxStreamBuffer->xLength;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xHead;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvReadBytes( const StreamBuffer_t * const pxStreamBuffer, uint8_t *pucData, size_t xCount, size_t xTail )
+{
+size_t xFirstLength;
+
+	xFirstLength = pxStreamBuffer->xLength - xTail;
+
+	if( xFirstLength > xCount )
+	{
+		xFirstLength = xCount;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	( void ) memcpy( ( void * ) pucData, ( const void * ) &( pxStreamBuffer->pucBuffer[ xTail ] ), xFirstLength );
+
+	if( xCount > xFirstLength )
+	{
+		( void ) memcpy( ( void * ) &( pucData[ xFirstLength ] ), ( const void * ) pxStreamBuffer->pucBuffer, xCount - xFirstLength );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	xTail += xCount;
+
+	if( xTail >= pxStreamBuffer->xLength )
+	{
+		xTail -= pxStreamBuffer->xLength;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xTail;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvBytesInBuffer( const StreamBuffer_t * const pxStreamBuffer )
+{
+size_t xCount;
+
+	/* Read each index once, the other side may move its own. */
+	xCount = pxStreamBuffer->xLength + pxStreamBuffer->xHead;
+	xCount -= pxStreamBuffer->xTail;
+
+	if( xCount >= pxStreamBuffer->xLength )
+	{
+		xCount -= pxStreamBuffer->xLength;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvUnblockWaitingTask( TaskHandle_t volatile * const pxWaitingTask )
+{
+	/* Only a blocked task records itself, and with a single writer and a
+	single reader no interrupt clears the record this side reads, so holding
+	the scheduler is enough to stop the waiting task clearing it first. */
+	vTaskSuspendAll();
+	{
+		if( *pxWaitingTask != NULL )
+		{
+			( void ) xTaskNotify( *pxWaitingTask, ( uint32_t ) 0, eNoAction );
+			*pxWaitingTask = NULL;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static void prvUnblockWaitingTaskFromISR( TaskHandle_t volatile * const pxWaitingTask, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+UBaseType_t uxSavedInterruptStatus;
+
+	uxSavedInterruptStatus = ( UBaseType_t ) portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( *pxWaitingTask != NULL )
+		{
+			( void ) xTaskNotifyFromISR( *pxWaitingTask, ( uint32_t ) 0, eNoAction, pxHigherPriorityTaskWoken );
+			*pxWaitingTask = NULL;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+}
+/*-----------------------------------------------------------*/
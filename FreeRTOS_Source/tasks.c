@@ -304,8 +304,8 @@ typedef struct tskTaskControlBlock
 	StackType_t			*pxStack;			/*< Points to the start of the stack. */
 	char				pcTaskName[ configMAX_TASK_NAME_LEN ];/*< Descriptive name given to the task when created.  Facilitates debugging only. */ /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 
-	#if ( portSTACK_GROWTH > 0 )
-		StackType_t		*pxEndOfStack;		/*< Points to the end of the stack on architectures where the stack grows up from low memory. */
+	#if ( ( portSTACK_GROWTH > 0 ) || ( configRECORD_STACK_HIGH_ADDRESS == 1 ) )
+		StackType_t		*pxEndOfStack;		/*< Points to the highest valid address for the stack. */
 	#endif
 
 	#if ( portCRITICAL_NESTING_IN_TCB == 1 )
@@ -360,6 +360,10 @@ typedef struct tskTaskControlBlock
 		uint8_t ucDelayAborted;
 	#endif
 
+	#if( configUSE_KEYED_QUEUES == 1 )
+		UBaseType_t		uxEventKey;			/*< Key of the item the task is waiting for while it is blocked on a keyed queue. */
+	#endif
+
 } tskTCB;
 
 /* The old tskTCB name is maintained above then typedefed to the new TCB_t name
@@ -640,7 +644,7 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB ) PRIVILEGED_FUNCTION;
 			/* Allocate space for the TCB.  Where the memory comes from depends
 			on the implementation of the port malloc function and whether or
 			not static allocation is being used. */
-			pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
+			pxNewTCB = ( TCB_t * ) portMALLOC_TAGGED( sizeof( TCB_t ), eHeapTagTCB );
 
 			if( pxNewTCB != NULL )
 			{
@@ -691,14 +695,14 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB ) PRIVILEGED_FUNCTION;
 			/* Allocate space for the TCB.  Where the memory comes from depends on
 			the implementation of the port malloc function and whether or not static
 			allocation is being used. */
-			pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
+			pxNewTCB = ( TCB_t * ) portMALLOC_TAGGED( sizeof( TCB_t ), eHeapTagTCB );
 
 			if( pxNewTCB != NULL )
 			{
 				/* Allocate space for the stack used by the task being created.
 				The base of the stack memory stored in the TCB so the task can
 				be deleted later if required. */
-				pxNewTCB->pxStack = ( StackType_t * ) pvPortMalloc( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+				pxNewTCB->pxStack = ( StackType_t * ) portMALLOC_TAGGED( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ), eHeapTagStack ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 
 				if( pxNewTCB->pxStack == NULL )
 				{
@@ -713,12 +717,12 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB ) PRIVILEGED_FUNCTION;
 		StackType_t *pxStack;
 
 			/* Allocate space for the stack used by the task being created. */
-			pxStack = ( StackType_t * ) pvPortMalloc( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+			pxStack = ( StackType_t * ) portMALLOC_TAGGED( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ), eHeapTagStack ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 
 			if( pxStack != NULL )
 			{
 				/* Allocate space for the TCB. */
-				pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) ); /*lint !e961 MISRA exception as the casts are only redundant for some paths. */
+				pxNewTCB = ( TCB_t * ) portMALLOC_TAGGED( sizeof( TCB_t ), eHeapTagTCB ); /*lint !e961 MISRA exception as the casts are only redundant for some paths. */
 
 				if( pxNewTCB != NULL )
 				{
@@ -809,6 +813,14 @@ UBaseType_t x;
 
 		/* Check the alignment of the calculated top of stack is correct. */
 		configASSERT( ( ( ( portPOINTER_SIZE_TYPE ) pxTopOfStack & ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK ) == 0UL ) );
+
+		#if( configRECORD_STACK_HIGH_ADDRESS == 1 )
+		{
+			/* Also record the stack's high address, which may assist
+			debugging and allows the allocated stack depth to be reported. */
+			pxNewTCB->pxEndOfStack = pxTopOfStack;
+		}
+		#endif /* configRECORD_STACK_HIGH_ADDRESS */
 	}
 	#else /* portSTACK_GROWTH */
 	{
@@ -2834,6 +2846,27 @@ void vTaskPlaceOnEventList( List_t * const pxEventList, const TickType_t xTicksT
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_KEYED_QUEUES == 1 )
+
+	void vTaskPlaceOnEventListKeyed( List_t * const pxEventList, const UBaseType_t uxKey, const TickType_t xTicksToWait )
+	{
+		configASSERT( pxEventList );
+
+		/* THIS FUNCTION MUST BE CALLED WITH EITHER INTERRUPTS DISABLED OR THE
+		SCHEDULER SUSPENDED AND THE QUEUE BEING ACCESSED LOCKED. */
+
+		/* The key is only read while the task is on the event list, which is
+		protected in the same way as the list itself. */
+		pxCurrentTCB->uxEventKey = uxKey;
+
+		vListInsert( pxEventList, &( pxCurrentTCB->xEventListItem ) );
+
+		prvAddCurrentTaskToDelayedList( xTicksToWait, pdTRUE );
+	}
+
+#endif /* configUSE_KEYED_QUEUES */
+/*-----------------------------------------------------------*/
+
 void vTaskPlaceOnUnorderedEventList( List_t * pxEventList, const TickType_t xItemValue, const TickType_t xTicksToWait )
 {
 	configASSERT( pxEventList );
@@ -2959,6 +2992,80 @@ BaseType_t xReturn;
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_KEYED_QUEUES == 1 )
+
+	BaseType_t xTaskRemoveFromEventListByKey( const List_t * const pxEventList, const UBaseType_t uxKey )
+	{
+	const ListItem_t *pxListItem;
+	const ListItem_t * const pxEndMarker = listGET_END_MARKER( pxEventList );
+	TCB_t *pxUnblockedTCB = NULL;
+	BaseType_t xReturn = pdFALSE;
+
+		/* THIS FUNCTION MUST BE CALLED FROM A CRITICAL SECTION.  It can also
+		be called from a critical section within an ISR. */
+
+		/* The event list is sorted in priority order, so the first task that
+		waits for the key is the highest priority task that does.  Tasks
+		waiting for other keys are left blocked. */
+		for( pxListItem = listGET_HEAD_ENTRY( pxEventList ); pxListItem != pxEndMarker; pxListItem = listGET_NEXT( pxListItem ) )
+		{
+			TCB_t * const pxTCB = ( TCB_t * ) listGET_LIST_ITEM_OWNER( pxListItem );
+
+			if( pxTCB->uxEventKey == uxKey )
+			{
+				pxUnblockedTCB = pxTCB;
+				break;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+
+		if( pxUnblockedTCB != NULL )
+		{
+			( void ) uxListRemove( &( pxUnblockedTCB->xEventListItem ) );
+
+			if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+			{
+				( void ) uxListRemove( &( pxUnblockedTCB->xStateListItem ) );
+				prvAddTaskToReadyList( pxUnblockedTCB );
+			}
+			else
+			{
+				/* The delayed and ready lists cannot be accessed, so hold this
+				task pending until the scheduler is resumed. */
+				vListInsertEnd( &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
+			}
+
+			if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+			{
+				/* See xTaskRemoveFromEventList(). */
+				xReturn = pdTRUE;
+				xYieldPending = pdTRUE;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			#if( configUSE_TICKLESS_IDLE != 0 )
+			{
+				prvResetNextTaskUnblockTime();
+			}
+			#endif
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return xReturn;
+	}
+
+#endif /* configUSE_KEYED_QUEUES */
+/*-----------------------------------------------------------*/
+
 BaseType_t xTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem, const TickType_t xItemValue )
 {
 TCB_t *pxUnblockedTCB;
@@ -3421,6 +3528,12 @@ static void prvCheckTasksWaitingTermination( void )
 		pxTaskStatus->pxStackBase = pxTCB->pxStack;
 		pxTaskStatus->xTaskNumber = pxTCB->uxTCBNumber;
 
+		#if ( ( portSTACK_GROWTH > 0 ) || ( configRECORD_STACK_HIGH_ADDRESS == 1 ) )
+		{
+			pxTaskStatus->pxEndOfStack = pxTCB->pxEndOfStack;
+		}
+		#endif
+
 		#if ( INCLUDE_vTaskSuspend == 1 )
 		{
 			/* If the task is in the suspended list then there is a chance it is
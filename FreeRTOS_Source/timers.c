@@ -319,7 +319,7 @@ BaseType_t xReturn = pdFAIL;
 	{
 	Timer_t *pxNewTimer;
 
-		pxNewTimer = ( Timer_t * ) pvPortMalloc( sizeof( Timer_t ) );
+		pxNewTimer = ( Timer_t * ) portMALLOC_TAGGED( sizeof( Timer_t ), eHeapTagTimer );
 
 		if( pxNewTimer != NULL )
 		{
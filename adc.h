@@ -18,5 +18,18 @@ typedef struct
     uint16_t value;
 } ADCmsg_t;
 
+/**
+ * @brief Post one conversion result to the ADC data queue
+ * @param eChannel channel the sample belongs to, S1 for A14 and S2 for A15
+ * @param usValue 12-bit conversion result
+ * @param pxHigherPriorityTaskWoken set to pdTRUE if a consumer was unblocked
+ * @return pdPASS, or errQUEUE_FULL if the sample was dropped
+ *
+ * Called from the ADC12 interrupt and from every other source of conversion
+ * results, so they all feed the pipeline the same way. Samples of a channel
+ * switched off with the channels command are discarded and pdPASS returned.
+ */
+extern BaseType_t xADCPostSampleFromISR( Button_t eChannel, uint16_t usValue, BaseType_t *pxHigherPriorityTaskWoken );
+
 
 #endif /* ADC_H_ */
@@ -0,0 +1,83 @@
+/**
+ * @file adc_capture.c
+ * @brief ADC capture replayed by adc_sim.c
+ *
+ * Generated by tools/adc_capture.py from example.csv, do not edit.
+ */
+
+#include "adc_sim.h"
+
+static const ADCCaptureRecord_t xRecords[] =
+{
+    {     1, 0x7f7, 0x4a4 },
+    {  1002, 0x86b, 0x4ab },
+    {   996, 0x8bc, 0x4bf },
+    {  1002, 0x933, 0x4b0 },
+    {   998, 0x97d, 0x4aa },
+    {  1002, 0x9b8, 0x4a7 },
+    {   999, 0x9eb, 0x4ab },
+    {  1002, 0xa1e, 0x4bc },
+    {  1002, 0xa42, 0x4a6 },
+    {   995, 0xa4e, 0x4b8 },
+    {  1001, 0xa65, 0x4b1 },
+    {   999, 0xa4e, 0x4a7 },
+    {  1004, 0xa20, 0x4a9 },
+    {   995, 0x9f1, 0x4ad },
+    {  1001, 0x9b6, 0x4b2 },
+    {  1001, 0x978, 0x4b3 },
+    {  1002, 0x90f, 0x4bb },
+    {   998, 0x8c8, 0x4b7 },
+    {  1000, 0x863, 0x4a4 },
+    {  1000, 0x7fb, 0x4b3 },
+    {  1002, 0x783, 0x4b0 },
+    {  1001, 0x742, 0x4ba },
+    {   996, 0x6cc, 0x4a7 },
+    {  1004, 0x689, 0x4a5 },
+    {   998, 0x646, 0x4b0 },
+    {  1001, 0x5f2, 0x4be },
+    {  1001, 0x5cb, 0x4b3 },
+    {   997, 0x5c4, 0x4bc },
+    {  1000, 0x5b7, 0x4b0 },
+    {   998, 0x5b8, 0x4a5 },
+    {  1003, 0x5b6, 0x834 },
+    {   997, 0x5e0, 0x839 },
+    {  1000, 0x627, 0x830 },
+    {  1001, 0x66d, 0x831 },
+    {  1005, 0x6b7, 0x83f },
+    {   998, 0x709, 0x825 },
+    {   997, 0x74a, 0x834 },
+    {  1002, 0x7c0, 0x82a },
+    {  1000, 0x824, 0x4a5 },
+    {   999, 0x886, 0x4b6 },
+    {  1003, 0x8e3, 0x4a5 },
+    {   997, 0x93a, 0x4b8 },
+    {  1004, 0x99d, 0x4aa },
+    {   995, 0x9d6, 0x4b7 },
+    {  1003, 0x9f5, 0x4bd },
+    {  1000, 0xa39, 0x4a5 },
+    {  1002, 0xa43, 0x4b4 },
+    {   999, 0xa5e, 0x4a1 },
+    {   999, 0xa60, 0x4b2 },
+    {  1002, 0xa43, 0x4b2 },
+    {   994, 0xa00, 0x4b9 },
+    {  1004, 0x9db, 0x4ae },
+    {  1001, 0x9a1, 0x4b0 },
+    {   999, 0x95d, 0x4b0 },
+    {  1002, 0x8fd, 0x4bb },
+    {  1000, 0x88e, 0x4a8 },
+    {   995, 0x82d, 0x4bf },
+    {  1001, 0x7e7, 0x4aa },
+    {  1001, 0x760, 0x4b9 },
+    {  1003, 0x703, 0x4be },
+    {   996, 0x6c8, 0x4b8 },
+    {   999, 0x678, 0x4a5 },
+    {  1000, 0x623, 0x4bf },
+    {   999, 0x5e7, 0x4bb },
+};
+
+const ADCCapture_t xADCCapture =
+{
+    "example.csv",
+    xRecords,
+    sizeof( xRecords ) / sizeof( xRecords[ 0 ] )
+};
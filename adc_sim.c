@@ -0,0 +1,310 @@
+/**
+ * @file adc_sim.c
+ * @brief Simulated and replayed ADC sources
+ *
+ * Timer_B0 runs from SMCLK/8 in continuous mode and CCR0 is moved forward on
+ * every compare interrupt. The time to the next event is kept as a 32-bit
+ * count and waits longer than half the timer range are split into several
+ * compares, so slow rates and long gaps in a capture need no prescaler
+ * switching.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "adc.h"
+#include "adc_sim.h"
+
+/* Hardware includes. */
+#include "msp430.h"
+#include "hal_ETF5438A.h"
+
+/* Timer_B0 clock, SMCLK divided by 8; SMCLK depends on the clock profile. */
+#define adcsimTIMER_HZ              ( hal430GetSystemClock() / 8UL )
+
+/* Timer counts per capture delay unit, multiplied by 16 to keep the fraction. */
+#define adcsimCOUNTS_PER_TICK_X16   ( ( adcsimTIMER_HZ * 16UL ) / ( 1000000UL / adcsimCAPTURE_TICK_US ) )
+
+/* Longest single step of CCR0; keeping it below half the timer range lets a
+late interrupt be told apart from a long wait. */
+#define adcsimMAX_STEP              ( 0x7fffU )
+
+/* Shortest step of CCR0, in timer counts, so the compare is never set behind
+the counter. */
+#define adcsimMIN_PERIOD            ( 16U )
+
+/* Seed of the jitter generator, any non-zero value. */
+#define adcsimLFSR_SEED             ( 0xace1U )
+
+/** @brief Nominal interrupt period of the synthetic source, in timer counts */
+static uint32_t ulPeriod;
+/** @brief Maximum deviation from ulPeriod in timer counts */
+static uint32_t ulJitterSpan;
+/** @brief Sequences posted per synthetic interrupt */
+static uint8_t ucBurst;
+/** @brief State of the jitter generator */
+static uint16_t usLfsr = adcsimLFSR_SEED;
+/** @brief Phase of the synthetic signal */
+static uint16_t usPhase;
+/** @brief Capture being replayed, NULL for the synthetic source */
+static const ADCCapture_t *pxReplay;
+/** @brief Next record of the capture */
+static uint16_t usReplayIndex;
+/** @brief Divisor applied to the recorded delays */
+static uint8_t ucReplaySpeedUp;
+/** @brief Start over after the last record */
+static BaseType_t xReplayLoop;
+/** @brief Timer counts left until the next event */
+static uint32_t ulWait;
+/** @brief Set while Timer_B0 is producing events */
+static volatile BaseType_t xRunning = pdFALSE;
+/** @brief Samples handed to the pipeline since start-up */
+static volatile uint32_t ulGenerated;
+
+/**
+ * @brief Advance the 16-bit Galois LFSR used for jitter
+ * @return next pseudo random value, never 0
+ */
+static uint16_t prvNextRandom( void )
+{
+    usLfsr = ( usLfsr >> 1 ) ^ ( -( usLfsr & 1U ) & 0xb400U );
+
+    return usLfsr;
+}
+
+/**
+ * @brief Calculate the time until the next synthetic interrupt
+ * @return period in timer counts with the jitter applied
+ */
+static uint32_t prvNextPeriod( void )
+{
+    uint32_t ulOffset;
+
+    if( ulJitterSpan == 0 )
+    {
+        return ulPeriod;
+    }
+
+    /* Uniform offset in [0, 2 * ulJitterSpan), scaled so the product always
+    fits 32 bits. */
+    if( ulJitterSpan <= 0xffffUL )
+    {
+        ulOffset = ( ulJitterSpan * prvNextRandom() ) >> 15;
+    }
+    else
+    {
+        ulOffset = ( ( ulJitterSpan >> 8 ) * prvNextRandom() ) >> 7;
+    }
+
+    /* The span is below the period, so the result stays positive. */
+    return ulPeriod - ulJitterSpan + ulOffset;
+}
+
+/**
+ * @brief Convert the delay of a capture record to timer counts
+ * @param usDelay delay in adcsimCAPTURE_TICK_US units
+ * @return delay in timer counts after the speed-up
+ */
+static uint32_t prvReplayDelay( uint16_t usDelay )
+{
+    return ( ( uint32_t ) usDelay * adcsimCOUNTS_PER_TICK_X16 ) / ( 16UL * ucReplaySpeedUp );
+}
+
+/**
+ * @brief Move CCR0 towards the next event
+ *
+ * Called with interrupts disabled, either from the interrupt or before the
+ * timer is started.
+ */
+static void prvScheduleNext( void )
+{
+    uint16_t usStep;
+
+    if( ulWait > adcsimMAX_STEP )
+    {
+        usStep = adcsimMAX_STEP;
+    }
+    else if( ulWait < adcsimMIN_PERIOD )
+    {
+        usStep = adcsimMIN_PERIOD;
+    }
+    else
+    {
+        usStep = ( uint16_t ) ulWait;
+    }
+
+    ulWait = ( ulWait > usStep ) ? ( ulWait - usStep ) : 0;
+    TB0CCR0 += usStep;
+
+    /* If the interrupt ran late the new compare may already be behind the
+    counter; fire as soon as possible instead of after a full wrap. */
+    if( ( int16_t ) ( TB0CCR0 - TB0R ) < ( int16_t ) adcsimMIN_PERIOD )
+    {
+        TB0CCR0 = TB0R + adcsimMIN_PERIOD;
+    }
+}
+
+/**
+ * @brief Start Timer_B0 with ulWait set to the time of the first event
+ */
+static void prvStartTimer( void )
+{
+    TB0CTL = TBSSEL_2 | ID_3 | TBCLR;
+    TB0EX0 = 0;
+    TB0CCR0 = 0;
+    prvScheduleNext();
+    TB0CCTL0 = CCIE;
+
+    xRunning = pdTRUE;
+    TB0CTL |= MC_2;
+}
+
+void vADCSimStart( const ADCSimPattern_t *pxPattern )
+{
+    uint32_t ulRate = pxPattern->ulRateHz;
+
+    configASSERT( ( ulRate != 0 ) && ( ulRate <= adcsimMAX_RATE_HZ ) );
+    configASSERT( pxPattern->ucBurst != 0 );
+    configASSERT( pxPattern->ucJitterPct < 100 );
+
+    vADCSimStop();
+
+    /* Time between two interrupts, which carry ucBurst sequences each. */
+    ulPeriod = ( adcsimTIMER_HZ * pxPattern->ucBurst ) / ulRate;
+    ulJitterSpan = ( ulPeriod * pxPattern->ucJitterPct ) / 100;
+    ucBurst = pxPattern->ucBurst;
+    pxReplay = NULL;
+
+    ulWait = prvNextPeriod();
+    prvStartTimer();
+}
+
+void vADCSimStartReplay( const ADCCapture_t *pxCapture, uint8_t ucSpeedUp, BaseType_t xLoop )
+{
+    configASSERT( ( pxCapture != NULL ) && ( pxCapture->usCount != 0 ) );
+    configASSERT( ucSpeedUp != 0 );
+
+    vADCSimStop();
+
+    pxReplay = pxCapture;
+    usReplayIndex = 0;
+    ucReplaySpeedUp = ucSpeedUp;
+    xReplayLoop = xLoop;
+
+    ulWait = prvReplayDelay( pxCapture->pxRecords[ 0 ].usDelay );
+    prvStartTimer();
+}
+
+void vADCSimStop( void )
+{
+    TB0CTL = 0;
+    TB0CCTL0 = 0;
+    xRunning = pdFALSE;
+}
+
+BaseType_t xADCSimIsRunning( void )
+{
+    return xRunning;
+}
+
+uint32_t ulADCSimGetGenerated( void )
+{
+    uint32_t ulCount;
+
+    /* The counter is updated from the interrupt and is wider than the CPU. */
+    taskENTER_CRITICAL();
+    ulCount = ulGenerated;
+    taskEXIT_CRITICAL();
+
+    return ulCount;
+}
+
+/**
+ * @brief Post one burst of the synthetic source
+ * @param pxHigherPriorityTaskWoken passed on to xADCPostSampleFromISR()
+ *
+ * A14 carries a rising ramp and A15 the same ramp mirrored, both limited to
+ * 12 bits like the real converter.
+ */
+static void prvPostSynthetic( BaseType_t *pxHigherPriorityTaskWoken )
+{
+    uint8_t uc;
+
+    for( uc = 0; uc < ucBurst; uc++ )
+    {
+        usPhase = ( usPhase + 7U ) & 0x0fffU;
+
+        xADCPostSampleFromISR( S1, usPhase, pxHigherPriorityTaskWoken );
+        xADCPostSampleFromISR( S2, 0x0fffU - usPhase, pxHigherPriorityTaskWoken );
+    }
+
+    ulGenerated += 2U * ucBurst;
+    ulWait = prvNextPeriod();
+}
+
+/**
+ * @brief Post every capture record that is due
+ * @param pxHigherPriorityTaskWoken passed on to xADCPostSampleFromISR()
+ *
+ * At most one pass over the capture is posted per interrupt. A looping
+ * capture whose delays are all 0 would otherwise never leave the interrupt;
+ * it is posted once per shortest period instead.
+ */
+static void prvPostReplay( BaseType_t *pxHigherPriorityTaskWoken )
+{
+    const ADCCaptureRecord_t *pxRecord;
+    uint16_t usPosted = 0;
+
+    do
+    {
+        pxRecord = &pxReplay->pxRecords[ usReplayIndex ];
+
+        xADCPostSampleFromISR( S1, pxRecord->usMem0, pxHigherPriorityTaskWoken );
+        xADCPostSampleFromISR( S2, pxRecord->usMem1, pxHigherPriorityTaskWoken );
+        ulGenerated += 2U;
+
+        if( ++usReplayIndex == pxReplay->usCount )
+        {
+            if( xReplayLoop == pdFALSE )
+            {
+                vADCSimStop();
+                break;
+            }
+
+            usReplayIndex = 0;
+        }
+
+        ulWait = prvReplayDelay( pxReplay->pxRecords[ usReplayIndex ].usDelay );
+
+    } while( ( ulWait == 0 ) && ( ++usPosted < pxReplay->usCount ) );
+}
+
+/**
+ * @brief Timer_B0 compare, the simulated end of conversion
+ */
+#pragma vector=TIMER0_B0_VECTOR
+__interrupt void vADCSimISR( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    /* Long waits take several compares; only the last one posts. */
+    if( ulWait == 0 )
+    {
+        if( pxReplay != NULL )
+        {
+            prvPostReplay( &xHigherPriorityTaskWoken );
+        }
+        else
+        {
+            prvPostSynthetic( &xHigherPriorityTaskWoken );
+        }
+    }
+
+    if( xRunning != pdFALSE )
+    {
+        prvScheduleNext();
+    }
+
+    __bic_SR_register_on_exit( SCG1 + SCG0 + OSCOFF + CPUOFF );
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
@@ -0,0 +1,100 @@
+/**
+ * @file adc_sim.h
+ * @brief Simulated and replayed ADC sources
+ *
+ * Produces A14/A15 conversion pairs from Timer_B0 instead of the ADC12, so the
+ * acquisition pipeline can be driven without analog hardware. Every
+ * conversion goes through xADCPostSampleFromISR(), exactly like the results
+ * of adc12_isr, so the queue and the consumer tasks see the same traffic they
+ * would see from the real converter.
+ *
+ * Two kinds of source are available, only one of them runs at a time:
+ *
+ * - Synthetic: a ramp at a steady rate, optionally in bursts, where several
+ *   sequences are posted back to back from one interrupt, and with jitter,
+ *   where the time between two interrupts is varied randomly around the
+ *   nominal period.
+ *
+ * - Replay: the ADC12MEM0/ADC12MEM1 values of a recorded capture, posted with
+ *   the recorded spacing or with the spacing divided by a speed-up factor.
+ *   Captures are converted to a C table by tools/adc_capture.py.
+ */
+
+#ifndef ADC_SIM_H_
+#define ADC_SIM_H_
+
+#include "FreeRTOS.h"
+
+/** @brief Highest sequence rate the synthetic source accepts, in Hz */
+#define adcsimMAX_RATE_HZ           ( 20000UL )
+
+/** @brief Unit of the time between two capture records, in microseconds */
+#define adcsimCAPTURE_TICK_US       ( 100UL )
+
+/** @brief Shape of the synthetic conversion traffic */
+typedef struct
+{
+    uint32_t ulRateHz;      /**< average number of A14/A15 sequences per second */
+    uint8_t ucBurst;        /**< sequences posted per interrupt, 1 for a steady rate */
+    uint8_t ucJitterPct;    /**< maximum deviation of the interrupt period, in percent */
+} ADCSimPattern_t;
+
+/** @brief One recorded A14/A15 sequence */
+typedef struct
+{
+    uint16_t usDelay;       /**< time since the previous record, in adcsimCAPTURE_TICK_US units */
+    uint16_t usMem0;        /**< recorded ADC12MEM0, channel A14 */
+    uint16_t usMem1;        /**< recorded ADC12MEM1, channel A15 */
+} ADCCaptureRecord_t;
+
+/** @brief A recorded capture */
+typedef struct
+{
+    const char *pcName;                     /**< name of the source file */
+    const ADCCaptureRecord_t *pxRecords;    /**< records in the order they were taken */
+    uint16_t usCount;                       /**< number of records */
+} ADCCapture_t;
+
+/** @brief Capture built into the image, generated by tools/adc_capture.py */
+extern const ADCCapture_t xADCCapture;
+
+/**
+ * @brief Start producing synthetic conversions
+ * @param pxPattern rate, burst length and jitter to use
+ *
+ * The interrupt period is ucBurst times the nominal sequence period, so the
+ * average rate does not depend on the burst length. Calling this while a
+ * source is running switches to the new pattern.
+ */
+extern void vADCSimStart( const ADCSimPattern_t *pxPattern );
+
+/**
+ * @brief Start replaying a capture
+ * @param pxCapture capture to replay
+ * @param ucSpeedUp 1 for the recorded timing, N to replay N times faster
+ * @param xLoop pdTRUE to start over after the last record
+ *
+ * Records with a delay of 0 are posted from the same interrupt as the one
+ * before them, up to one pass over the capture per interrupt. Delays shorter than the timer can resolve after the speed-up
+ * are stretched to the shortest period the source supports.
+ */
+extern void vADCSimStartReplay( const ADCCapture_t *pxCapture, uint8_t ucSpeedUp, BaseType_t xLoop );
+
+/**
+ * @brief Stop producing conversions
+ */
+extern void vADCSimStop( void );
+
+/**
+ * @brief Check whether a source is running
+ * @return pdFALSE once stopped or once a replay without looping has finished
+ */
+extern BaseType_t xADCSimIsRunning( void );
+
+/**
+ * @brief Get the number of samples produced since start-up
+ * @return samples handed to xADCPostSampleFromISR(), both channels counted
+ */
+extern uint32_t ulADCSimGetGenerated( void );
+
+#endif /* ADC_SIM_H_ */
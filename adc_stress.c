@@ -0,0 +1,142 @@
+/**
+ * @file adc_stress.c
+ * @brief Saturation test for the ADC acquisition pipeline
+ *
+ * The queue health counters (configUSE_QUEUE_STATS) provide the drops, depth
+ * and residency of every stage; they are cleared before the stage starts and
+ * read after the drain time.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "uart.h"
+#include "adc_sim.h"
+#include "adc_stress.h"
+
+#if( configUSE_QUEUE_STATS != 1 )
+	#error adc_stress.c requires configUSE_QUEUE_STATS set to 1
+#endif
+
+/* The source counts as keeping up when it produced at least this share of the
+requested samples, in percent; timer rounding and jitter cost a little. */
+#define adcstressMIN_DELIVERED_PCT  ( 95UL )
+
+/** @brief Traffic profile of one sweep */
+typedef struct
+{
+    const char *pcName;     /**< name printed in the results */
+    uint8_t ucBurst;        /**< sequences per interrupt */
+    uint8_t ucJitterPct;    /**< period jitter in percent */
+} StressProfile_t;
+
+/** @brief Profiles swept one after the other */
+static const StressProfile_t xProfiles[] =
+{
+    { "steady", 1,                      0 },
+    { "burst",  adcstressBURST_LENGTH,  0 },
+    { "jitter", 1,                      adcstressJITTER_PCT },
+};
+
+#define adcstressNUM_PROFILES       ( sizeof( xProfiles ) / sizeof( xProfiles[ 0 ] ) )
+
+/** @brief Queue under test */
+static QueueHandle_t xQueueUnderTest;
+/** @brief Highest sustainable rate of every profile */
+static uint32_t ulMaxRate[ adcstressNUM_PROFILES ];
+/** @brief Result line of a stage or of a profile, kept off the task stack */
+static char cResultLine[ 64 ];
+/** @brief UART port the results are printed on */
+static UartHandle_t xResultPort;
+
+uint32_t ulADCStressGetMaxRate( UBaseType_t uxProfile )
+{
+    if( uxProfile >= adcstressNUM_PROFILES )
+    {
+        return 0;
+    }
+
+    return ulMaxRate[ uxProfile ];
+}
+
+/**
+ * @brief Run one stage of a sweep
+ * @param pxProfile traffic profile
+ * @param ulRate sequence rate in Hz
+ * @return pdTRUE if the pipeline sustained the rate
+ */
+static BaseType_t prvRunStage( const StressProfile_t *pxProfile, uint32_t ulRate )
+{
+    ADCSimPattern_t xPattern;
+    QueueStats_t xStats;
+    uint32_t ulStart, ulPosted, ulExpected;
+    UBaseType_t uxLeft;
+
+    xPattern.ulRateHz = ulRate;
+    xPattern.ucBurst = pxProfile->ucBurst;
+    xPattern.ucJitterPct = pxProfile->ucJitterPct;
+
+    /* Start from an empty queue so earlier stages do not count. */
+    vTaskDelay( adcstressDRAIN_TIME );
+    vQueueResetStats( xQueueUnderTest );
+    ulStart = ulADCSimGetGenerated();
+
+    vADCSimStart( &xPattern );
+    vTaskDelay( adcstressSTAGE_TIME );
+    vADCSimStop();
+
+    ulPosted = ulADCSimGetGenerated() - ulStart;
+    vTaskDelay( adcstressDRAIN_TIME );
+    vQueueGetStats( xQueueUnderTest, &xStats );
+    uxLeft = uxQueueMessagesWaiting( xQueueUnderTest );
+
+    xUartPrintf( xResultPort, cResultLine, sizeof( cResultLine ), portMAX_DELAY,
+                 "STRESS,%s,%lu,%lu,%lu,%u,%u\r\n", pxProfile->pcName,
+                 ( unsigned long ) ulRate, ( unsigned long ) ulPosted,
+                 ( unsigned long ) xStats.ulSendFailuresFromISR,
+                 ( unsigned ) xStats.uxMessagesWaitingHighWater,
+                 ( unsigned ) ( xStats.xAverageResidency * portTICK_PERIOD_MS ) );
+
+    /* Two samples per sequence over the length of the stage. */
+    ulExpected = ( 2UL * ulRate * adcstressSTAGE_TIME ) / configTICK_RATE_HZ;
+
+    return ( xStats.ulSendFailuresFromISR == 0 ) &&
+           ( ulPosted * 100UL >= ulExpected * adcstressMIN_DELIVERED_PCT ) &&
+           ( uxLeft == 0 );
+}
+
+/**
+ * @brief Stress test task function
+ * @param pvParameters not used
+ */
+static void prvADCStressTask( void *pvParameters )
+{
+    UBaseType_t ux;
+    uint32_t ulRate;
+
+    for( ux = 0; ux < adcstressNUM_PROFILES; ux++ )
+    {
+        ulRate = adcstressSTART_RATE_HZ;
+
+        while( ( ulRate <= adcsimMAX_RATE_HZ ) && ( prvRunStage( &xProfiles[ ux ], ulRate ) != pdFALSE ) )
+        {
+            ulMaxRate[ ux ] = ulRate;
+            ulRate += ( ulRate >> 2 ) + 1;
+        }
+
+        xUartPrintf( xResultPort, cResultLine, sizeof( cResultLine ), portMAX_DELAY,
+                     "STRESS,%s,max_rate_hz,%lu\r\n", xProfiles[ ux ].pcName,
+                     ( unsigned long ) ulMaxRate[ ux ] );
+    }
+
+    vTaskSuspend( NULL );
+}
+
+void vADCStressStart( QueueHandle_t xDataQueue, UBaseType_t uxPriority, UartHandle_t xPort )
+{
+    xQueueUnderTest = xDataQueue;
+    xResultPort = xPort;
+
+    xTaskCreate( prvADCStressTask, "Stress", 2*configMINIMAL_STACK_SIZE, NULL, uxPriority, NULL );
+}
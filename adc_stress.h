@@ -0,0 +1,75 @@
+/**
+ * @file adc_stress.h
+ * @brief Saturation test for the ADC acquisition pipeline
+ *
+ * Drives the pipeline from the simulated ADC source (adc_sim.h) and sweeps the
+ * sequence rate upward in steps of 25% for each traffic profile: steady,
+ * bursts of adcstressBURST_LENGTH sequences, and adcstressJITTER_PCT percent of
+ * period jitter. Every stage runs for adcstressSTAGE_TIME, after which the
+ * source is stopped and the consumers get adcstressDRAIN_TIME to catch up.
+ * Each stage is reported as a CSV line over UART:
+ *
+ *     STRESS,<profile>,<rate_hz>,<posted>,<dropped>,<depth_hw>,<lag_ms>
+ *
+ * posted counts samples on both channels, dropped is the number of sends from
+ * the interrupt that found the queue full, depth_hw the highest queue depth
+ * and lag_ms the average time a sample waited in the queue. A rate is
+ * sustainable when nothing was dropped, the source kept up with the requested
+ * rate and the queue was empty again after the drain time. The sweep of a
+ * profile ends at the first rate that is not sustainable and the last good
+ * one is reported as
+ *
+ *     STRESS,<profile>,max_rate_hz,<rate_hz>
+ */
+
+#ifndef ADC_STRESS_H_
+#define ADC_STRESS_H_
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "uart.h"
+
+/** @brief Duration of one stage; at the top rate 100 times the sample count must fit 32 bits */
+#ifndef adcstressSTAGE_TIME
+#define adcstressSTAGE_TIME         ( pdMS_TO_TICKS( 1000 ) )
+#endif
+
+/** @brief Time the consumers get to empty the queue after a stage */
+#ifndef adcstressDRAIN_TIME
+#define adcstressDRAIN_TIME         ( pdMS_TO_TICKS( 200 ) )
+#endif
+
+/** @brief Sequence rate of the first stage, in Hz */
+#ifndef adcstressSTART_RATE_HZ
+#define adcstressSTART_RATE_HZ      ( 10UL )
+#endif
+
+/** @brief Sequences per interrupt in the burst profile */
+#ifndef adcstressBURST_LENGTH
+#define adcstressBURST_LENGTH       ( 8 )
+#endif
+
+/** @brief Period jitter of the jitter profile, in percent */
+#ifndef adcstressJITTER_PCT
+#define adcstressJITTER_PCT         ( 50 )
+#endif
+
+/**
+ * @brief Create the stress test task
+ * @param xDataQueue queue the conversion results are posted to
+ * @param uxPriority priority of the test task, above the consumers
+ * @param xPort UART port the results are printed on
+ *
+ * The real ADC must not be triggered while the test runs. The task prints the
+ * results and then suspends itself.
+ */
+extern void vADCStressStart( QueueHandle_t xDataQueue, UBaseType_t uxPriority, UartHandle_t xPort );
+
+/**
+ * @brief Get the result of a completed profile
+ * @param uxProfile 0 steady, 1 burst, 2 jitter
+ * @return highest sustainable sequence rate in Hz, 0 if not measured yet
+ */
+extern uint32_t ulADCStressGetMaxRate( UBaseType_t uxProfile );
+
+#endif /* ADC_STRESS_H_ */
@@ -0,0 +1,386 @@
+/**
+ * @file benchmark.c
+ * @brief Kernel microbenchmark suite
+ *
+ * Each benchmark consists of an optional setup step that puts the kernel
+ * object into the required state and an operation that is timed on every
+ * iteration. The cost of reading the counter and calling through the function
+ * pointer is measured first and subtracted from every sample.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "stream_buffer.h"
+#include "timers.h"
+#include "uart.h"
+#include "benchmark.h"
+
+#if( INCLUDE_xTimerPendFunctionCall != 1 )
+	#error benchmark.c requires INCLUDE_xTimerPendFunctionCall set to 1
+#endif
+
+/** @brief Operation or setup step of a benchmark */
+typedef void ( *BenchFunction_t )( void );
+
+/** @brief Item moved through the queue, the same size as ADCmsg_t */
+typedef struct
+{
+    uint16_t usChannel;
+    uint16_t usValue;
+} BenchMsg_t;
+
+/** @brief Items moved per call by the bulk queue benchmarks */
+#define benchBATCH              ( 8 )
+
+/** @brief Bytes the stream buffer holds, half of what the over-capacity send writes */
+#define benchSTREAM_SIZE        ( sizeof( xBenchBatch ) / 2 )
+
+/** @brief Block time of the over-capacity send, far longer than the send takes */
+#define benchSTREAM_WAIT        ( pdMS_TO_TICKS( 10 ) )
+
+/** @brief Description of a single benchmark */
+typedef struct
+{
+    const char *pcName;         /**< name printed in the results */
+    BenchFunction_t pxSetup;    /**< called once before the timed loop, may be NULL */
+    BenchFunction_t pxPrepare;  /**< called before every timed operation, not timed, may be NULL */
+    BenchFunction_t pxOperation;/**< timed operation */
+    BaseType_t xFromISR;        /**< pdTRUE to time the operation with interrupts disabled */
+} Benchmark_t;
+
+/** @brief Queue shaped like xADCDataQueue */
+static QueueHandle_t xBenchQueue;
+/** @brief Mailbox shaped like xQueue1 */
+static QueueHandle_t xBenchMailbox;
+/** @brief Stream buffer written by the over-capacity send */
+static StreamBufferHandle_t xBenchStream;
+/** @brief Mutex taken and given by the mutex benchmarks */
+static SemaphoreHandle_t xBenchMutex;
+/** @brief Handle of the benchmark task, notified by the helpers */
+static TaskHandle_t xBenchTask;
+/** @brief Handle of the partner task used for context switches */
+static TaskHandle_t xPartnerTask;
+/** @brief Message moved through the queue */
+static BenchMsg_t xBenchMsg = { 14, 0x0abc };
+/** @brief Batch moved by the bulk queue benchmarks */
+static BenchMsg_t xBenchBatch[ benchBATCH ];
+/** @brief Value written to the mailbox */
+static uint16_t usBenchValue;
+/** @brief Cycles spent reading the counter around an empty operation */
+static uint16_t usOverhead;
+/** @brief Result line, static as the benchmark task stack is sized for the kernel calls */
+static char cResultLine[ 48 ];
+/** @brief UART port the results are printed on */
+static UartHandle_t xResultPort;
+
+/*-----------------------------------------------------------*/
+
+static void prvOpEmpty( void )
+{
+}
+
+static void prvOpQueueSend( void )
+{
+    xQueueSendToBack( xBenchQueue, &xBenchMsg, 0 );
+}
+
+static void prvOpQueueReceive( void )
+{
+    BenchMsg_t xMsg;
+
+    xQueueReceive( xBenchQueue, &xMsg, 0 );
+}
+
+static void prvOpQueueSendFromISR( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    xQueueSendToBackFromISR( xBenchQueue, &xBenchMsg, &xHigherPriorityTaskWoken );
+}
+
+static void prvOpQueueReceiveFromISR( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    BenchMsg_t xMsg;
+
+    xQueueReceiveFromISR( xBenchQueue, &xMsg, &xHigherPriorityTaskWoken );
+}
+
+static void prvOpQueuePeek( void )
+{
+    BenchMsg_t xMsg;
+
+    xQueuePeek( xBenchQueue, &xMsg, 0 );
+}
+
+static void prvOpQueueSendMultiple( void )
+{
+    xQueueSendMultiple( xBenchQueue, xBenchBatch, benchBATCH, 0 );
+}
+
+static void prvOpQueueReceiveMultiple( void )
+{
+    BenchMsg_t xMsgs[ benchBATCH ];
+
+    xQueueReceiveMultiple( xBenchQueue, xMsgs, benchBATCH, 0 );
+}
+
+static void prvOpMutexTake( void )
+{
+    xSemaphoreTake( xBenchMutex, 0 );
+}
+
+static void prvOpMutexGive( void )
+{
+    xSemaphoreGive( xBenchMutex );
+}
+
+static void prvOpOverwrite( void )
+{
+    usBenchValue++;
+    xQueueOverwrite( xBenchMailbox, &usBenchValue );
+}
+
+static void prvOpStreamSendOver( void )
+{
+    xStreamBufferSend( xBenchStream, xBenchBatch, sizeof( xBenchBatch ), benchSTREAM_WAIT );
+}
+
+/**
+ * @brief Runs in the timer task and wakes the benchmark task
+ */
+static void prvPendedFunction( void *pvParameter1, uint32_t ulParameter2 )
+{
+    ( void ) pvParameter1;
+    ( void ) ulParameter2;
+
+    xTaskNotifyGive( xBenchTask );
+}
+
+static void prvOpTimerRoundTrip( void )
+{
+    /* The timer task has a higher priority, so the command is processed
+    before xTimerPendFunctionCall() returns. */
+    xTimerPendFunctionCall( prvPendedFunction, NULL, 0, portMAX_DELAY );
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+}
+
+static void prvOpContextSwitch( void )
+{
+    /* Two switches: to the higher priority partner and back again when it
+    blocks. */
+    xTaskNotifyGive( xPartnerTask );
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvSetupEmptyQueue( void )
+{
+    xQueueReset( xBenchQueue );
+}
+
+static void prvSetupFullQueue( void )
+{
+    xQueueReset( xBenchQueue );
+    while( xQueueSendToBack( xBenchQueue, &xBenchMsg, 0 ) == pdPASS );
+}
+
+static void prvPrepareBatchQueued( void )
+{
+    xQueueReset( xBenchQueue );
+    xQueueSendMultiple( xBenchQueue, xBenchBatch, benchBATCH, 0 );
+}
+
+static void prvPrepareEmptyStream( void )
+{
+    xStreamBufferReset( xBenchStream );
+}
+
+static void prvPrepareMutexTaken( void )
+{
+    xSemaphoreTake( xBenchMutex, 0 );
+}
+
+static void prvPrepareMutexGiven( void )
+{
+    xSemaphoreGive( xBenchMutex );
+}
+
+/*-----------------------------------------------------------*/
+
+/** @brief The suite; queue benchmarks never block as setup leaves room or data */
+static const Benchmark_t xBenchmarks[] =
+{
+    { "queue_send",             prvSetupEmptyQueue, NULL,                   prvOpQueueSend,            pdFALSE },
+    { "queue_receive",          prvSetupFullQueue,  NULL,                   prvOpQueueReceive,         pdFALSE },
+    { "queue_send_isr",         prvSetupEmptyQueue, NULL,                   prvOpQueueSendFromISR,     pdTRUE  },
+    { "queue_receive_isr",      prvSetupFullQueue,  NULL,                   prvOpQueueReceiveFromISR,  pdTRUE  },
+    { "queue_peek",             prvSetupFullQueue,  NULL,                   prvOpQueuePeek,            pdFALSE },
+    { "queue_send_x8",          NULL,               prvSetupEmptyQueue,     prvOpQueueSendMultiple,    pdFALSE },
+    { "queue_receive_x8",       NULL,               prvPrepareBatchQueued,  prvOpQueueReceiveMultiple, pdFALSE },
+    { "mutex_take",             NULL,               prvPrepareMutexGiven,   prvOpMutexTake,            pdFALSE },
+    { "mutex_give",             NULL,               prvPrepareMutexTaken,   prvOpMutexGive,            pdFALSE },
+    { "queue_overwrite",        NULL,               NULL,                   prvOpOverwrite,            pdFALSE },
+    { "stream_send_over",       NULL,               prvPrepareEmptyStream,  prvOpStreamSendOver,       pdFALSE },
+    { "timer_round_trip",       NULL,               NULL,                   prvOpTimerRoundTrip,       pdFALSE },
+    { "context_switch_pair",    NULL,               NULL,                   prvOpContextSwitch,        pdFALSE },
+};
+
+/** @brief Calibration entry, timed exactly like a real benchmark */
+static const Benchmark_t xCalibration = { "overhead", NULL, NULL, prvOpEmpty, pdFALSE };
+
+/**
+ * @brief Time one benchmark
+ * @param pxBenchmark benchmark to run
+ * @param pusMin set to the fastest iteration
+ * @param pusMax set to the slowest iteration
+ * @return average cycles per iteration
+ */
+static uint16_t prvTimeBenchmark( const Benchmark_t *pxBenchmark, uint16_t *pusMin, uint16_t *pusMax )
+{
+    uint16_t usStart, usCycles;
+    uint16_t usMin = 0xffff, usMax = 0;
+    uint32_t ulSum = 0;
+    UBaseType_t ux;
+
+    if( pxBenchmark->pxSetup != NULL )
+    {
+        pxBenchmark->pxSetup();
+    }
+
+    for( ux = 0; ux < benchITERATIONS; ux++ )
+    {
+        if( pxBenchmark->pxPrepare != NULL )
+        {
+            pxBenchmark->pxPrepare();
+        }
+
+        /* The FromISR API must only be called where an interrupt handler
+        would call it, with interrupts disabled. The counter keeps running,
+        so masking them around the reads times the call alone. */
+        if( pxBenchmark->xFromISR != pdFALSE )
+        {
+            taskDISABLE_INTERRUPTS();
+        }
+
+        usStart = benchGET_CYCLES();
+        pxBenchmark->pxOperation();
+        usCycles = ( uint16_t ) ( benchGET_CYCLES() - usStart ) - usOverhead;
+
+        if( pxBenchmark->xFromISR != pdFALSE )
+        {
+            taskENABLE_INTERRUPTS();
+        }
+
+        ulSum += usCycles;
+        if( usCycles < usMin ) usMin = usCycles;
+        if( usCycles > usMax ) usMax = usCycles;
+    }
+
+    *pusMin = usMin;
+    *pusMax = usMax;
+
+    return ( uint16_t ) ( ulSum / benchITERATIONS );
+}
+
+/**
+ * @brief Time one benchmark and print its result line
+ * @param pxBenchmark benchmark to run
+ */
+static void prvRunBenchmark( const Benchmark_t *pxBenchmark )
+{
+    uint16_t usMin, usMax, usAverage;
+
+    usAverage = prvTimeBenchmark( pxBenchmark, &usMin, &usMax );
+
+    xUartPrintf( xResultPort, cResultLine, sizeof( cResultLine ), portMAX_DELAY,
+                 "BENCH,%s,%u,%u,%u,%u\r\n", pxBenchmark->pcName,
+                 ( unsigned ) benchITERATIONS, ( unsigned ) usMin,
+                 ( unsigned ) usAverage, ( unsigned ) usMax );
+}
+
+/**
+ * @brief Measure the cost of the timing itself
+ *
+ * The minimum is used, any interrupt that hits the calibration would only
+ * make the overhead look larger.
+ */
+static void prvCalibrate( void )
+{
+    uint16_t usMax;
+
+    usOverhead = 0;
+    ( void ) prvTimeBenchmark( &xCalibration, &usOverhead, &usMax );
+}
+
+/**
+ * @brief Check that a send larger than the stream buffer does not block
+ *
+ * An empty buffer must take what fits and return at once, not wait the whole
+ * block time for space it can never have; stream_send_over would otherwise
+ * time the block time.
+ */
+static void prvCheckStreamSendOver( void )
+{
+    TickType_t xStart;
+    size_t xSent;
+
+    xStreamBufferReset( xBenchStream );
+    xStart = xTaskGetTickCount();
+    xSent = xStreamBufferSend( xBenchStream, xBenchBatch, sizeof( xBenchBatch ), benchSTREAM_WAIT );
+
+    configASSERT( xSent == benchSTREAM_SIZE );
+    configASSERT( ( xTaskGetTickCount() - xStart ) < benchSTREAM_WAIT );
+}
+
+/**
+ * @brief Partner task for the context switch benchmark
+ * @param pvParameters not used
+ */
+static void prvPartnerTask( void *pvParameters )
+{
+    for( ;; )
+    {
+        ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+        xTaskNotifyGive( xBenchTask );
+    }
+}
+
+/**
+ * @brief Benchmark task function
+ * @param pvParameters not used
+ */
+static void prvBenchmarkTask( void *pvParameters )
+{
+    UBaseType_t ux;
+
+    prvCheckStreamSendOver();
+    prvCalibrate();
+
+    xUartPrintf( xResultPort, cResultLine, sizeof( cResultLine ), portMAX_DELAY,
+                 "BENCH,clock_khz,%u\r\n", ( unsigned ) benchCYCLES_PER_MS );
+
+    for( ux = 0; ux < sizeof( xBenchmarks ) / sizeof( xBenchmarks[ 0 ] ); ux++ )
+    {
+        prvRunBenchmark( &xBenchmarks[ ux ] );
+    }
+
+    vTaskSuspend( NULL );
+}
+
+void vBenchmarkStart( UBaseType_t uxPriority, UartHandle_t xPort )
+{
+    xResultPort = xPort;
+
+    xBenchQueue = xQueueCreate( benchITERATIONS, sizeof( BenchMsg_t ) );
+    xBenchMailbox = xQueueCreate( 1, sizeof( uint16_t ) );
+    xBenchMutex = xSemaphoreCreateMutex();
+    xBenchStream = xStreamBufferCreate( benchSTREAM_SIZE, 1 );
+
+    xTaskCreate( prvBenchmarkTask, "Bench", 2*configMINIMAL_STACK_SIZE, NULL, uxPriority, &xBenchTask );
+    xTaskCreate( prvPartnerTask, "BenchPtnr", configMINIMAL_STACK_SIZE, NULL, uxPriority + 1, &xPartnerTask );
+}
@@ -0,0 +1,55 @@
+/**
+ * @file benchmark.h
+ * @brief Kernel microbenchmark suite
+ *
+ * Measures the cost in CPU cycles of the kernel paths the application relies
+ * on: queue send and receive from tasks and interrupts, bulk send and receive
+ * of eight items, peek, mutex take and give, mailbox overwrite, a stream
+ * buffer send of more bytes than it holds, timer command round trip and task
+ * to task context switch. Every operation is timed individually and the
+ * minimum, average and maximum are reported as CSV lines over UART:
+ *
+ *     BENCH,clock_khz,<kHz>
+ *     BENCH,<name>,<iterations>,<min>,<avg>,<max>
+ *
+ * The interrupt variants are timed with interrupts disabled, the state an
+ * interrupt handler calls them in, so they show what the ADC and UART
+ * interrupts pay. Before timing, the suite checks that the over-capacity
+ * stream buffer send writes what fits and returns without waiting.
+ *
+ * The suite only uses the public FreeRTOS API and benchGET_CYCLES(), so it
+ * can be built for any port by defining benchGET_CYCLES() and
+ * benchCYCLES_PER_MS before this header is included.
+ */
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include "FreeRTOS.h"
+#include "uart.h"
+
+/* Cycle counter used for timing; on target this is Timer_A1 running at MCLK */
+#ifndef benchGET_CYCLES
+#include "hal_ETF5438A.h"
+#define benchGET_CYCLES()       halCYCLE_COUNT()
+#define benchCYCLES_PER_MS      ( hal430GetSystemClock() / 1000UL )
+#endif
+
+/** @brief Number of timed iterations per benchmark */
+#ifndef benchITERATIONS
+#define benchITERATIONS         ( 32 )
+#endif
+
+/**
+ * @brief Create the benchmark task
+ * @param uxPriority priority of the benchmark task
+ * @param xPort UART port the results are printed on
+ *
+ * The task runs every benchmark once, prints the results and then suspends
+ * itself. The priority should be above the application tasks but below the
+ * UART and timer tasks, which the suite depends on. A partner task used for
+ * the context switch benchmark is created one priority level higher.
+ */
+extern void vBenchmarkStart( UBaseType_t uxPriority, UartHandle_t xPort );
+
+#endif /* BENCHMARK_H_ */
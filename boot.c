@@ -0,0 +1,92 @@
+/**
+ * @file boot.c
+ * @brief Boot milestones
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "boot.h"
+
+/* Hardware includes. */
+#include "msp430.h"
+
+/** @brief Counter value of every milestone, valid where usReached has its bit set */
+static uint32_t ulBootCount[ bootMILESTONES ];
+/** @brief One bit per milestone reached */
+static volatile uint16_t usReached = 0;
+
+/**
+ * @brief Read the 32-bit RTC counter
+ *
+ * The counter runs from ACLK, asynchronously to MCLK, and a carry between
+ * the two halves can come between their reads, so the counter is read until
+ * two readings agree.
+ */
+static uint32_t prvReadCounter( void )
+{
+    uint32_t ulFirst;
+    uint32_t ulSecond;
+
+    do
+    {
+        ulFirst = ( ( uint32_t ) RTCNT34 << 16 ) | RTCNT12;
+        ulSecond = ( ( uint32_t ) RTCNT34 << 16 ) | RTCNT12;
+    } while( ulFirst != ulSecond );
+
+    return ulFirst;
+}
+
+/**
+ * @brief Record a milestone, with interrupts disabled
+ */
+static void prvRecord( BootMilestone_t eMilestone )
+{
+    uint16_t usBit = ( uint16_t ) ( 1U << eMilestone );
+
+    if( ( usReached & usBit ) == 0 )
+    {
+        ulBootCount[ eMilestone ] = prvReadCounter();
+        usReached |= usBit;
+    }
+}
+
+void vBootStart( void )
+{
+    /* Counter mode, ACLK, 32 bits, held while it is cleared */
+    RTCCTL01 = RTCHOLD | RTCSSEL_0 | RTCTEV_3;
+    RTCNT12 = 0;
+    RTCNT34 = 0;
+    RTCCTL01 &= ~RTCHOLD;
+
+    prvRecord( eBootMain );
+}
+
+void vBootMilestone( BootMilestone_t eMilestone )
+{
+    /* Before the scheduler starts interrupts stay disabled on exit */
+    taskENTER_CRITICAL();
+    prvRecord( eMilestone );
+    taskEXIT_CRITICAL();
+}
+
+void vBootMilestoneFromISR( BootMilestone_t eMilestone )
+{
+    prvRecord( eMilestone );
+}
+
+BaseType_t xBootGetMilestone( BootMilestone_t eMilestone, uint32_t *pulTimeUs )
+{
+    uint32_t ulCount;
+    BaseType_t xReached;
+
+    taskENTER_CRITICAL();
+    ulCount = ulBootCount[ eMilestone ] - ulBootCount[ eBootMain ];
+    xReached = ( ( usReached & ( 1U << eMilestone ) ) != 0 ) ? pdPASS : pdFAIL;
+    taskEXIT_CRITICAL();
+
+    /* 1000000 / 32768 = 15625 / 512, split so the product fits in 32 bits */
+    *pulTimeUs = ( ( ulCount >> 9 ) * 15625UL ) + ( ( ( ulCount & 511UL ) * 15625UL ) >> 9 );
+
+    return xReached;
+}
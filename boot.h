@@ -0,0 +1,60 @@
+/**
+ * @file boot.h
+ * @brief Boot milestones
+ *
+ * The RTC, in counter mode from ACLK, counts from the start of main() and
+ * time stamps the steps of the boot with a resolution of 1/32768 s. The
+ * counter is not touched by anything else and keeps running in LPM3, so the
+ * milestones after the scheduler has started are on the same time base as
+ * those before. The time from reset to main(), the C startup, is not counted.
+ *
+ * Each milestone is recorded the first time it is reached only.
+ */
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include "FreeRTOS.h"
+
+/** @brief Step of the boot */
+typedef enum
+{
+    eBootMain = 0,          /**< main() entered, time 0 */
+    eBootClock,             /**< clock profile set, the FLL may still settle */
+    eBootAdc,               /**< ADC12 configured */
+    eBootScheduler,         /**< objects created, scheduler about to start */
+    eBootFirstSample,       /**< first conversion result posted */
+    eBootReady              /**< deferred initialisation done */
+} BootMilestone_t;
+
+/** @brief Number of milestones */
+#define bootMILESTONES              ( 6 )
+
+/**
+ * @brief Start the counter and record eBootMain
+ *
+ * Called first thing in main(), with interrupts disabled.
+ */
+extern void vBootStart( void );
+
+/**
+ * @brief Record a milestone from a task, or from main() before the scheduler starts
+ * @param eMilestone milestone reached
+ */
+extern void vBootMilestone( BootMilestone_t eMilestone );
+
+/**
+ * @brief Record a milestone from an interrupt
+ * @param eMilestone milestone reached
+ */
+extern void vBootMilestoneFromISR( BootMilestone_t eMilestone );
+
+/**
+ * @brief Get the time of a milestone
+ * @param eMilestone milestone to look up
+ * @param pulTimeUs set to the time since main() was entered, in microseconds
+ * @return pdPASS if the milestone has been reached, pdFAIL if not
+ */
+extern BaseType_t xBootGetMilestone( BootMilestone_t eMilestone, uint32_t *pulTimeUs );
+
+#endif /* BOOT_H_ */
@@ -0,0 +1,313 @@
+/**
+ * @file command.c
+ * @brief Command interpreter on the UART
+ *
+ * Assembles the bytes received over UART into lines, splits each line into
+ * words and calls the handler of the command named by the first word.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "uart.h"
+#include "command.h"
+
+/* Stack depth of the command task, in words. */
+#define cmdSTACK_SIZE           ( 2 * configMINIMAL_STACK_SIZE )
+
+/* Number of received bytes taken from the UART at once. */
+#define cmdRX_CHUNK             ( 8 )
+
+/* Block time for sending a reply; the PC is expected to read what it asks for. */
+#define cmdREPLY_BLOCK_TIME     ( pdMS_TO_TICKS( 100 ) )
+
+static BaseType_t prvHelpCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+
+/** @brief Commands that are always available */
+static const Command_t xBuiltinCommands[] =
+{
+    { "help", "[command]", prvHelpCommand }
+};
+
+/** @brief Registered command tables, the built-in one first */
+static const Command_t *pxCommandTables[ cmdMAX_TABLES + 1 ] = { xBuiltinCommands };
+/** @brief Number of commands in each table */
+static UBaseType_t uxCommandCounts[ cmdMAX_TABLES + 1 ] = { sizeof( xBuiltinCommands ) / sizeof( xBuiltinCommands[ 0 ] ) };
+/** @brief Number of registered tables */
+static UBaseType_t uxTableCount = 1;
+
+/** @brief UART port commands are read from and answered on */
+static UartHandle_t xCommandPort;
+
+/** @brief Line being assembled, static so it does not need to fit on the task stack */
+static char cLine[ cmdLINE_LENGTH ];
+/** @brief Reply text written by the handler */
+static char cReply[ cmdREPLY_LENGTH ];
+/** @brief Line that is sent back to the PC */
+static char cReplyLine[ cmdREPLY_LENGTH + 8 ];
+
+void vCommandRegister( const Command_t *pxCommands, UBaseType_t uxCount )
+{
+    configASSERT( uxTableCount < cmdMAX_TABLES + 1 );
+
+    pxCommandTables[ uxTableCount ] = pxCommands;
+    uxCommandCounts[ uxTableCount ] = uxCount;
+    uxTableCount++;
+}
+
+BaseType_t xCommandParseNumber( const char *pcArg, uint32_t ulMin, uint32_t ulMax, uint32_t *pulValue )
+{
+    uint32_t ulValue = 0;
+
+    if( *pcArg == '\0' )
+    {
+        return pdFAIL;
+    }
+
+    while( *pcArg != '\0' )
+    {
+        if( ( *pcArg < '0' ) || ( *pcArg > '9' ) )
+        {
+            return pdFAIL;
+        }
+
+        ulValue = ( ulValue * 10 ) + ( uint32_t ) ( *pcArg - '0' );
+
+        /* Stop before the value can overflow. */
+        if( ulValue > ulMax )
+        {
+            return pdFAIL;
+        }
+
+        pcArg++;
+    }
+
+    if( ulValue < ulMin )
+    {
+        return pdFAIL;
+    }
+
+    *pulValue = ulValue;
+
+    return pdPASS;
+}
+
+/**
+ * @brief Find a command by name
+ * @param pcName first word of the line
+ * @return the command, NULL if no table has it
+ */
+static const Command_t *prvFindCommand( const char *pcName )
+{
+    UBaseType_t uxTable, ux;
+
+    for( uxTable = 0; uxTable < uxTableCount; uxTable++ )
+    {
+        for( ux = 0; ux < uxCommandCounts[ uxTable ]; ux++ )
+        {
+            if( strcmp( pxCommandTables[ uxTable ][ ux ].pcName, pcName ) == 0 )
+            {
+                return &pxCommandTables[ uxTable ][ ux ];
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Send the answer to a command
+ * @param xResult pdPASS for OK, pdFAIL for ERR
+ * @param pcText text that follows, may be empty
+ */
+static void prvSendReply( BaseType_t xResult, const char *pcText )
+{
+    sprintf( cReplyLine, "%s%s%s\r\n",
+             ( xResult == pdPASS ) ? "OK" : "ERR",
+             ( *pcText != '\0' ) ? " " : "",
+             pcText );
+    xUartSendString( xCommandPort, cReplyLine, cmdREPLY_BLOCK_TIME );
+}
+
+/**
+ * @brief Built-in help command
+ *
+ * Without an argument sends the usage of every command, one line each, before
+ * the OK; with the name of a command answers with its usage only.
+ */
+static BaseType_t prvHelpCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    const Command_t *pxCommand;
+    UBaseType_t uxTable, ux;
+
+    if( uxArgc > 2 )
+    {
+        return pdFAIL;
+    }
+
+    if( uxArgc == 2 )
+    {
+        pxCommand = prvFindCommand( ppcArgv[ 1 ] );
+
+        if( pxCommand == NULL )
+        {
+            snprintf( pcReply, xReplyLength, "unknown command" );
+            return pdFAIL;
+        }
+
+        snprintf( pcReply, xReplyLength, "%s %s", pxCommand->pcName, pxCommand->pcUsage );
+        return pdPASS;
+    }
+
+    for( uxTable = 0; uxTable < uxTableCount; uxTable++ )
+    {
+        for( ux = 0; ux < uxCommandCounts[ uxTable ]; ux++ )
+        {
+            pxCommand = &pxCommandTables[ uxTable ][ ux ];
+            snprintf( cReplyLine, sizeof( cReplyLine ), "%s %s\r\n", pxCommand->pcName, pxCommand->pcUsage );
+            xUartSendString( xCommandPort, cReplyLine, cmdREPLY_BLOCK_TIME );
+        }
+    }
+
+    return pdPASS;
+}
+
+/**
+ * @brief Split a line into words and run the command
+ * @param pcLine zero terminated line, modified in place
+ */
+static void prvExecuteLine( char *pcLine )
+{
+    char *ppcArgv[ cmdMAX_ARGS ];
+    UBaseType_t uxArgc = 0;
+    const Command_t *pxCommand;
+    BaseType_t xResult;
+
+    for( ;; )
+    {
+        /* Skip the spaces before the next word. */
+        while( *pcLine == ' ' )
+        {
+            *pcLine++ = '\0';
+        }
+
+        if( *pcLine == '\0' )
+        {
+            break;
+        }
+
+        if( uxArgc == cmdMAX_ARGS )
+        {
+            prvSendReply( pdFAIL, "too many arguments" );
+            return;
+        }
+
+        ppcArgv[ uxArgc++ ] = pcLine;
+
+        while( ( *pcLine != ' ' ) && ( *pcLine != '\0' ) )
+        {
+            pcLine++;
+        }
+    }
+
+    /* An empty line is not answered, so a terminal can send CR LF. */
+    if( uxArgc == 0 )
+    {
+        return;
+    }
+
+    pxCommand = prvFindCommand( ppcArgv[ 0 ] );
+
+    if( pxCommand == NULL )
+    {
+        prvSendReply( pdFAIL, "unknown command" );
+        return;
+    }
+
+    cReply[ 0 ] = '\0';
+    xResult = pxCommand->pxHandler( uxArgc, ppcArgv, cReply, sizeof( cReply ) );
+    cReply[ sizeof( cReply ) - 1 ] = '\0';
+
+    if( ( xResult != pdPASS ) && ( cReply[ 0 ] == '\0' ) )
+    {
+        snprintf( cReply, sizeof( cReply ), "usage: %s %s", pxCommand->pcName, pxCommand->pcUsage );
+    }
+
+    prvSendReply( xResult, cReply );
+}
+
+/**
+ * @brief Command task function
+ * @param pvParameters not used
+ *
+ * Collects received bytes until CR or LF and executes the line. Backspace
+ * removes the last byte, so commands can be typed in a terminal. A line that
+ * does not fit is thrown away up to its end and answered with ERR.
+ */
+static void prvCommandTask( void *pvParameters )
+{
+    uint8_t ucChunk[ cmdRX_CHUNK ];
+    uint16_t usReceived, us;
+    uint16_t usLength = 0;
+    BaseType_t xOverflow = pdFALSE;
+    char cByte;
+
+    for( ;; )
+    {
+        if( xUartReceive( xCommandPort, ucChunk, sizeof( ucChunk ), &usReceived, portMAX_DELAY ) != pdPASS )
+        {
+            continue;
+        }
+
+        for( us = 0; us < usReceived; us++ )
+        {
+            cByte = ( char ) ucChunk[ us ];
+
+            if( ( cByte == '\r' ) || ( cByte == '\n' ) )
+            {
+                if( xOverflow != pdFALSE )
+                {
+                    prvSendReply( pdFAIL, "line too long" );
+                }
+                else
+                {
+                    cLine[ usLength ] = '\0';
+                    prvExecuteLine( cLine );
+                }
+
+                usLength = 0;
+                xOverflow = pdFALSE;
+            }
+            else if( ( cByte == '\b' ) || ( cByte == 0x7f ) )
+            {
+                if( usLength > 0 )
+                {
+                    usLength--;
+                }
+            }
+            else if( xOverflow != pdFALSE )
+            {
+                /* Wait for the end of the line that did not fit. */
+            }
+            else if( usLength < ( cmdLINE_LENGTH - 1 ) )
+            {
+                cLine[ usLength++ ] = cByte;
+            }
+            else
+            {
+                xOverflow = pdTRUE;
+            }
+        }
+    }
+}
+
+void vCommandStart( UBaseType_t uxPriority, UartHandle_t xPort )
+{
+    xCommandPort = xPort;
+
+    xTaskCreate( prvCommandTask, "Cmd", cmdSTACK_SIZE, NULL, uxPriority, NULL );
+}
@@ -0,0 +1,95 @@
+/**
+ * @file command.h
+ * @brief Command interpreter on the UART
+ *
+ * A task reads the bytes received from the PC, assembles them into lines and
+ * runs each line as a command. A line is a command name followed by up to
+ * five arguments separated by spaces and ends with CR, LF or both. Commands
+ * are looked up in tables registered by the application, so the interpreter
+ * itself knows nothing about what it configures.
+ *
+ * Every command is answered with one line, "OK" or "ERR", optionally followed
+ * by a text set by the handler:
+ *
+ *     > period 50
+ *     < OK period 50
+ *     > window 3 8
+ *     < ERR usage: window <1|2> <samples>
+ *
+ * The built-in "help" command lists the registered commands and their usage.
+ */
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+#include "FreeRTOS.h"
+#include "uart.h"
+
+/** @brief Maximum length of a command line, longer lines are rejected */
+#ifndef cmdLINE_LENGTH
+#define cmdLINE_LENGTH          ( 40 )
+#endif
+
+/** @brief Maximum number of words in a command line, the command name included */
+#ifndef cmdMAX_ARGS
+#define cmdMAX_ARGS             ( 6 )
+#endif
+
+/** @brief Maximum number of command tables that can be registered */
+#ifndef cmdMAX_TABLES
+#define cmdMAX_TABLES           ( 2 )
+#endif
+
+/** @brief Size of the buffer the handlers write their reply text into */
+#define cmdREPLY_LENGTH         ( 48 )
+
+/**
+ * @brief Command handler function pointer type
+ * @param uxArgc number of words in the line, the command name included
+ * @param ppcArgv the words, ppcArgv[ 0 ] is the command name
+ * @param pcReply buffer for the text that follows OK or ERR, empty on entry
+ * @param xReplyLength size of @p pcReply
+ * @return pdPASS to answer OK, pdFAIL to answer ERR
+ *
+ * Runs in the command task. If the handler fails without setting a reply the
+ * usage of the command is sent back.
+ */
+typedef BaseType_t ( *CommandHandler_t )( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+
+/** @brief Entry of a command table */
+typedef struct
+{
+    const char *pcName;             /**< word that selects the command */
+    const char *pcUsage;            /**< arguments, shown by help and on errors */
+    CommandHandler_t pxHandler;     /**< function that executes the command */
+} Command_t;
+
+/**
+ * @brief Register a table of commands
+ * @param pxCommands array of commands, must stay valid while the task runs
+ * @param uxCount number of entries in @p pxCommands
+ *
+ * Must be called before vCommandStart().
+ */
+extern void vCommandRegister( const Command_t *pxCommands, UBaseType_t uxCount );
+
+/**
+ * @brief Create the command task
+ * @param uxPriority priority of the command task
+ * @param xPort UART port commands are read from and answered on
+ *
+ * The task is the only reader of the port, see xUartReceive().
+ */
+extern void vCommandStart( UBaseType_t uxPriority, UartHandle_t xPort );
+
+/**
+ * @brief Parse an unsigned decimal argument
+ * @param pcArg argument to parse
+ * @param ulMin smallest accepted value
+ * @param ulMax largest accepted value
+ * @param pulValue set to the value if it is valid
+ * @return pdPASS if @p pcArg is a number between @p ulMin and @p ulMax, pdFAIL if not
+ */
+extern BaseType_t xCommandParseNumber( const char *pcArg, uint32_t ulMin, uint32_t ulMax, uint32_t *pulValue );
+
+#endif /* COMMAND_H_ */
@@ -0,0 +1,165 @@
+/**
+ * @file dvfs.c
+ * @brief Frequency and core voltage governor
+ *
+ * The tick hook counts the ticks that find the idle task running. Once per
+ * period the governor task turns the count into the load and moves one
+ * operating point up or down. A change holds the UART ports, starts the DCO
+ * at the new clock through vHALClockStartChange(), sleeps while the FLL
+ * settles and retunes the ports.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "uart.h"
+#include "log.h"
+#include "dvfs.h"
+
+/* Hardware includes. */
+#include "msp430.h"
+#include "hal_ETF5438A.h"
+
+#if( INCLUDE_xTaskGetIdleTaskHandle != 1 ) || ( configUSE_TICK_HOOK != 1 )
+	#error dvfs.c requires INCLUDE_xTaskGetIdleTaskHandle and configUSE_TICK_HOOK set to 1
+#endif
+
+/* Block time to wait for the UART ports to send what they have queued before
+the clock changes; if they do not make it the change waits for the next
+period. */
+#define dvfsUART_WAIT               ( pdMS_TO_TICKS( 50 ) )
+
+/** @brief Operating points, slowest first; above 4 MHz the fastest MCLK of VCore levels 0 to 3 */
+static const uint32_t ulOperatingPoints[] =
+{
+    4000000UL, 8000000UL, 12000000UL, 20000000UL, 25000000UL
+};
+
+#define dvfsPOINTS                  ( sizeof( ulOperatingPoints ) / sizeof( ulOperatingPoints[ 0 ] ) )
+
+/** @brief Idle task, NULL until the governor task runs */
+static TaskHandle_t xIdleTask = NULL;
+/** @brief Ticks that found the idle task running, a running count */
+static volatile uint16_t usIdleTicks = 0;
+/** @brief Load of the last period in % */
+static volatile UBaseType_t uxLoad = 0;
+/** @brief Index of the current operating point */
+static UBaseType_t uxPoint;
+
+void vDvfsTickHook( void )
+{
+    if( ( xIdleTask != NULL ) && ( xTaskGetCurrentTaskHandle() == xIdleTask ) )
+    {
+        usIdleTicks++;
+    }
+}
+
+UBaseType_t uxDvfsGetLoad( void )
+{
+    return uxLoad;
+}
+
+/**
+ * @brief Move to another operating point
+ * @param uxNewPoint index of the operating point
+ * @return pdPASS if the clock was changed, pdFAIL if not
+ *
+ * Points at which a UART port cannot keep its baud rate are refused.
+ */
+static BaseType_t prvSetOperatingPoint( UBaseType_t uxNewPoint )
+{
+    uint32_t ulClockHz = ulOperatingPoints[ uxNewPoint ];
+
+    if( xUartClockSupported( ulClockHz ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+
+    if( xUartPrepareClockChange( dvfsUART_WAIT ) != pdPASS )
+    {
+        return pdFAIL;
+    }
+
+    /* The FLL settles while the governor sleeps, the other tasks keep running
+    as long as they leave the ports alone */
+    vHALClockStartChange( ulClockHz );
+    vTaskDelay( pdMS_TO_TICKS( HAL_FLL_SETTLE_MS ) );
+    vHALClockSettled();
+    vUartClockChanged();
+
+    uxPoint = uxNewPoint;
+    logMESSAGE2( eLogClockChanged, ( uint16_t ) ( hal430GetSystemClock() / 1000UL ), ( uint16_t ) uxLoad );
+
+    return pdPASS;
+}
+
+/**
+ * @brief Governor task function
+ * @param pvParameters not used
+ *
+ * The load is measured over the ticks that really passed, so a period
+ * stretched by a clock change is still measured correctly. A step that
+ * cannot be made, because a port would lose its baud rate or did not drain in
+ * time, is tried again in the next period.
+ */
+static void prvDvfsTask( void *pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    TickType_t xPeriodStart = xLastWakeTime;
+    TickType_t xElapsed;
+    uint16_t usIdleStart = usIdleTicks;
+    uint16_t usIdle;
+
+    ( void ) pvParameters;
+
+    /* The idle task exists once the scheduler runs */
+    xIdleTask = xTaskGetIdleTaskHandle();
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, dvfsPERIOD );
+
+        /* Both counters are 16 bits wide and read with one instruction, and
+        the differences are valid as long as a period is shorter than 65536
+        ticks. */
+        usIdle = usIdleTicks - usIdleStart;
+        xElapsed = xTaskGetTickCount() - xPeriodStart;
+        usIdleStart += usIdle;
+        xPeriodStart += xElapsed;
+
+        if( ( xElapsed == 0 ) || ( usIdle >= xElapsed ) )
+        {
+            uxLoad = 0;
+        }
+        else
+        {
+            uxLoad = 100 - ( UBaseType_t ) ( ( 100UL * usIdle ) / xElapsed );
+        }
+
+        if( ( uxLoad >= dvfsUP_LOAD ) && ( uxPoint < ( dvfsPOINTS - 1 ) ) )
+        {
+            ( void ) prvSetOperatingPoint( uxPoint + 1 );
+        }
+        else if( ( uxLoad <= dvfsDOWN_LOAD ) && ( uxPoint > 0 ) )
+        {
+            ( void ) prvSetOperatingPoint( uxPoint - 1 );
+        }
+    }
+}
+
+void vDvfsStart( UBaseType_t uxPriority )
+{
+    uint32_t ulClockHz = hal430GetSystemClock();
+
+    /* Start from the slowest point at least as fast as the boot clock, the
+    clock itself is not touched until the load asks for it. */
+    for( uxPoint = 0; uxPoint < ( dvfsPOINTS - 1 ); uxPoint++ )
+    {
+        if( ulOperatingPoints[ uxPoint ] >= ulClockHz )
+        {
+            break;
+        }
+    }
+
+    xTaskCreate( prvDvfsTask, "Dvfs", configMINIMAL_STACK_SIZE, NULL, uxPriority, NULL );
+}
@@ -0,0 +1,71 @@
+/**
+ * @file dvfs.h
+ * @brief Frequency and core voltage governor
+ *
+ * The share of ticks that interrupt the idle task gives the CPU load of the
+ * last period. Under load the governor raises MCLK one operating point at a
+ * time, and with it VCore; when the CPU is mostly idle it lowers both again.
+ * Each operating point but the slowest is the fastest MCLK its VCore level
+ * allows, so every step up buys the most speed for the supply it costs.
+ *
+ * MCLK and SMCLK both run from the DCO, so every change of the clock moves
+ * SMCLK too. Operating points at which a UART port cannot keep its baud rate
+ * are skipped. For a change the ports are held, see xUartPrepareClockChange():
+ * first until the bytes queued on them have been sent, at most 50 ms, then for
+ * the HAL_FLL_SETTLE_MS the FLL takes to settle, during which the governor
+ * sleeps rather than spins. A task that sends on a port meanwhile waits, and
+ * drops its bytes if its block time is shorter than the hold. The bit clocks
+ * are computed again before the ports are released.
+ *
+ * The kernel tick runs from ACLK (REFO or XT1) and does not depend on the
+ * DCO, so it needs no change. Timers clocked from SMCLK, the cycle counter
+ * and the simulated ADC, do change speed, so the benchmarks and the simulated
+ * ADC must not run with the governor.
+ */
+
+#ifndef DVFS_H_
+#define DVFS_H_
+
+#include "FreeRTOS.h"
+
+/** @brief Time between two load measurements, in ticks */
+#ifndef dvfsPERIOD
+#define dvfsPERIOD                  ( pdMS_TO_TICKS( 100 ) )
+#endif
+
+/** @brief Load in % at or above which the clock is raised */
+#ifndef dvfsUP_LOAD
+#define dvfsUP_LOAD                 ( 80 )
+#endif
+
+/** @brief Load in % at or below which the clock is lowered */
+#ifndef dvfsDOWN_LOAD
+#define dvfsDOWN_LOAD               ( 30 )
+#endif
+
+/**
+ * @brief Create the governor task
+ * @param uxPriority priority of the governor task, at most that of the tasks
+ * whose load it should follow; at the same priority time slicing still lets it
+ * run while they keep the CPU busy, and it never takes time from them
+ *
+ * Must be called after the UART ports have been opened, and only under the
+ * FLL clock profiles, see hal_clock.h. The governor starts from the clock
+ * eHALClockInit() set at boot.
+ */
+extern void vDvfsStart( UBaseType_t uxPriority );
+
+/**
+ * @brief Count the tick towards the load measurement
+ *
+ * Called from vApplicationTickHook().
+ */
+extern void vDvfsTickHook( void );
+
+/**
+ * @brief Get the load of the last period
+ * @return share of the period the CPU was not idle, in %
+ */
+extern UBaseType_t uxDvfsGetLoad( void );
+
+#endif /* DVFS_H_ */
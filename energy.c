@@ -0,0 +1,135 @@
+/**
+ * @file energy.c
+ * @brief Energy per sample estimate
+ *
+ * The tick hook only adds to running counters; the energy is computed from
+ * their differences when a report is taken, in the task that asks for it. The
+ * running CPU is counted as the sum of MCLK over the ticks that found it
+ * running, one sum per VCore level, so a change of the clock between two
+ * reports is accounted for with the current of each operating point.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "uart.h"
+#include "lpm.h"
+#include "energy.h"
+
+/* Hardware includes. */
+#include "msp430.h"
+#include "hal_ETF5438A.h"
+
+#if( configUSE_TICK_HOOK != 1 )
+	#error energy.c requires configUSE_TICK_HOOK set to 1
+#endif
+
+/* MCLK is summed in units of 2^energyCLOCK_SHIFT Hz, which takes a shift
+instead of a division in the tick interrupt. At 25 MHz the sum of one VCore
+level wraps after about three hours, far longer than a report period. */
+#define energyCLOCK_SHIFT           ( 16 )
+
+/* Number of VCore levels */
+#define energyVCORE_LEVELS          ( 4 )
+
+/** @brief Current of the running CPU per VCore level, in uA per MHz */
+static const uint16_t usActiveUaPerMHz[ energyVCORE_LEVELS ] =
+{
+    energyACTIVE_UA_PER_MHZ_0, energyACTIVE_UA_PER_MHZ_1,
+    energyACTIVE_UA_PER_MHZ_2, energyACTIVE_UA_PER_MHZ_3
+};
+
+/** @brief Running counters */
+typedef struct
+{
+    uint32_t ulClock[ energyVCORE_LEVELS ]; /**< MCLK summed over the ticks that found the CPU running */
+    uint32_t ulAdcTicks;                    /**< ticks that found the ADC12 on */
+    uint32_t ulUartTicks;                   /**< ticks that found a UART port busy */
+    uint32_t ulSamples;                     /**< samples delivered to the ADC queue */
+} EnergyCounters_t;
+
+/** @brief Counters, updated from the tick and ADC interrupts */
+static EnergyCounters_t xCounters;
+/** @brief Counters at the last report */
+static EnergyCounters_t xLastCounters;
+/** @brief Low power mode statistics at the last report */
+static LpmStats_t xLastLpm;
+
+void vEnergyTickHook( void )
+{
+    if( xLpmIsActive() != pdFALSE )
+    {
+        xCounters.ulClock[ PMMCTL0 & PMMCOREV_3 ] += hal430GetSystemClock() >> energyCLOCK_SHIFT;
+    }
+
+    if( ADC12CTL0 & ADC12ON )
+    {
+        xCounters.ulAdcTicks++;
+    }
+
+    if( xUartIsBusy() != pdFALSE )
+    {
+        xCounters.ulUartTicks++;
+    }
+}
+
+void vEnergySampleDeliveredFromISR( void )
+{
+    xCounters.ulSamples++;
+}
+
+/**
+ * @brief Energy of a fixed current
+ * @param ulTicks ticks the current flowed
+ * @param usMicroAmps current in uA
+ * @return energy in nJ
+ */
+static uint64_t prvFixedNj( uint32_t ulTicks, uint16_t usMicroAmps )
+{
+    return ( ( uint64_t ) ulTicks * usMicroAmps * energyVCC_MV * portTICK_PERIOD_MS ) / 1000U;
+}
+
+void vEnergyGetReport( EnergyReport_t *pxReport )
+{
+    EnergyCounters_t xNow;
+    LpmStats_t xLpm;
+    uint64_t ullClockUa = 0;
+    uint64_t ullActiveNj, ullLpmNj, ullAdcNj, ullUartNj, ullTotalNj;
+    uint32_t ulLpm0Ticks, ulLpm3Ticks;
+    UBaseType_t uxLevel;
+
+    /* The counters are wider than the CPU and change in interrupts */
+    taskENTER_CRITICAL();
+    xNow = xCounters;
+    taskEXIT_CRITICAL();
+    vLpmGetStats( &xLpm );
+
+    /* The sum of MCLK times the current per MHz, in uA and units of
+    2^energyCLOCK_SHIFT / 1000000 */
+    for( uxLevel = 0; uxLevel < energyVCORE_LEVELS; uxLevel++ )
+    {
+        ullClockUa += ( uint64_t ) ( xNow.ulClock[ uxLevel ] - xLastCounters.ulClock[ uxLevel ] ) * usActiveUaPerMHz[ uxLevel ];
+    }
+    ullActiveNj = ( ( ullClockUa << energyCLOCK_SHIFT ) * energyVCC_MV * portTICK_PERIOD_MS ) / 1000000000ULL;
+
+    ulLpm0Ticks = xLpm.xModes[ eLpm0 ].ulTicks - xLastLpm.xModes[ eLpm0 ].ulTicks;
+    ulLpm3Ticks = xLpm.xModes[ eLpm3 ].ulTicks - xLastLpm.xModes[ eLpm3 ].ulTicks;
+    ullLpmNj = prvFixedNj( ulLpm0Ticks, energyLPM0_UA ) + prvFixedNj( ulLpm3Ticks, energyLPM3_UA );
+
+    ullAdcNj = prvFixedNj( xNow.ulAdcTicks - xLastCounters.ulAdcTicks, energyADC_UA );
+    ullUartNj = prvFixedNj( xNow.ulUartTicks - xLastCounters.ulUartTicks, energyUART_UA );
+    ullTotalNj = ullActiveNj + ullLpmNj + ullAdcNj + ullUartNj;
+
+    /* LPM4 stops the tick, so the ticks counted are the time that passed */
+    pxReport->ulTicks = ( xLpm.ulActiveTicks - xLastLpm.ulActiveTicks ) + ulLpm0Ticks + ulLpm3Ticks;
+    pxReport->ulSamples = xNow.ulSamples - xLastCounters.ulSamples;
+    pxReport->ulPerSampleNj = ( pxReport->ulSamples == 0 ) ? 0 : ( uint32_t ) ( ullTotalNj / pxReport->ulSamples );
+    pxReport->ulTotalUj = ( uint32_t ) ( ullTotalNj / 1000U );
+    pxReport->ulActiveUj = ( uint32_t ) ( ullActiveNj / 1000U );
+    pxReport->ulLpmUj = ( uint32_t ) ( ullLpmNj / 1000U );
+    pxReport->ulAdcUj = ( uint32_t ) ( ullAdcNj / 1000U );
+    pxReport->ulUartUj = ( uint32_t ) ( ullUartNj / 1000U );
+
+    xLastCounters = xNow;
+    xLastLpm = xLpm;
+}
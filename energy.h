@@ -0,0 +1,112 @@
+/**
+ * @file energy.h
+ * @brief Energy per sample estimate
+ *
+ * The tick hook samples what draws current when the tick comes: the CPU
+ * running, and at which VCore level and MCLK, the ADC12 switched on, and a
+ * UART port moving bits. Together with the low power mode residency counted
+ * by lpm.c this gives the time spent in each state; multiplied by a supply
+ * current per state and the supply voltage it gives the energy used. Divided
+ * by the samples delivered to the ADC queue in the same time it gives the
+ * energy per sample.
+ *
+ * The currents are typical values from the MSP430F5438A data sheet at 3 V,
+ * not measurements; they should be calibrated against a measurement of the
+ * board before the absolute numbers are trusted. Changes between builds or
+ * settings are meaningful as they are. The running CPU draws about
+ * proportionally to MCLK, so its current is given per MHz and per VCore
+ * level; the other currents are fixed. LPM0 keeps the DCO running and draws
+ * more the faster it runs, the value below is for the default clock.
+ *
+ * LPM4 stops the tick, so its time is not counted; at about 1 uA it adds
+ * little next to the other states. The sampling resolution is one tick, so
+ * short activity such as a single UART character is counted statistically
+ * and the estimate is only good over many ticks.
+ */
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+#include "FreeRTOS.h"
+
+/** @brief Supply voltage in mV */
+#ifndef energyVCC_MV
+#define energyVCC_MV                ( 3000 )
+#endif
+
+/** @brief Current of the running CPU at VCore level 0, in uA per MHz of MCLK */
+#ifndef energyACTIVE_UA_PER_MHZ_0
+#define energyACTIVE_UA_PER_MHZ_0   ( 230 )
+#endif
+
+/** @brief Current of the running CPU at VCore level 1, in uA per MHz of MCLK */
+#ifndef energyACTIVE_UA_PER_MHZ_1
+#define energyACTIVE_UA_PER_MHZ_1   ( 245 )
+#endif
+
+/** @brief Current of the running CPU at VCore level 2, in uA per MHz of MCLK */
+#ifndef energyACTIVE_UA_PER_MHZ_2
+#define energyACTIVE_UA_PER_MHZ_2   ( 255 )
+#endif
+
+/** @brief Current of the running CPU at VCore level 3, in uA per MHz of MCLK */
+#ifndef energyACTIVE_UA_PER_MHZ_3
+#define energyACTIVE_UA_PER_MHZ_3   ( 270 )
+#endif
+
+/** @brief Current in LPM0, in uA */
+#ifndef energyLPM0_UA
+#define energyLPM0_UA               ( 90 )
+#endif
+
+/** @brief Current in LPM3, in uA */
+#ifndef energyLPM3_UA
+#define energyLPM3_UA               ( 3 )
+#endif
+
+/** @brief Additional current of the ADC12 while switched on, in uA */
+#ifndef energyADC_UA
+#define energyADC_UA                ( 150 )
+#endif
+
+/** @brief Additional current of a UART port while moving bits, in uA */
+#ifndef energyUART_UA
+#define energyUART_UA               ( 30 )
+#endif
+
+/** @brief Energy used between two reports */
+typedef struct
+{
+    uint32_t ulTicks;           /**< length of the interval in ticks */
+    uint32_t ulSamples;         /**< samples delivered to the ADC queue */
+    uint32_t ulPerSampleNj;     /**< energy per delivered sample in nJ, 0 without samples */
+    uint32_t ulTotalUj;         /**< energy of the interval in uJ, the four below add up to it within rounding */
+    uint32_t ulActiveUj;        /**< of it the running CPU, every VCore level */
+    uint32_t ulLpmUj;           /**< of it LPM0 and LPM3 */
+    uint32_t ulAdcUj;           /**< of it the ADC12 */
+    uint32_t ulUartUj;          /**< of it the UART ports */
+} EnergyReport_t;
+
+/**
+ * @brief Sample the current consumers
+ *
+ * Called from vApplicationTickHook().
+ */
+extern void vEnergyTickHook( void );
+
+/**
+ * @brief Count a sample delivered to the ADC queue
+ *
+ * Called from the ADC interrupt.
+ */
+extern void vEnergySampleDeliveredFromISR( void );
+
+/**
+ * @brief Get the energy used since the last call
+ * @param pxReport set to the energy used since the last call, or since boot
+ *
+ * Meant for a single caller, the telemetry task.
+ */
+extern void vEnergyGetReport( EnergyReport_t *pxReport );
+
+#endif /* ENERGY_H_ */
@@ -0,0 +1,104 @@
+/**
+ * @file log.c
+ * @brief Deferred-format log
+ *
+ * The log is an array of fixed size entries used as a ring. Producers may be
+ * tasks and interrupts at once, so a slot is reserved by advancing the head
+ * with interrupts masked for a handful of instructions; the MSP430 has no
+ * atomic fetch-and-add to do it otherwise. The entry is then written with
+ * interrupts enabled and published by setting ucReady last. The single
+ * consumer stops at the first entry that is reserved but not yet ready.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "log.h"
+
+/* Hardware includes. */
+#include "msp430.h"
+
+#if( ( logBUFFER_ENTRIES & ( logBUFFER_ENTRIES - 1 ) ) != 0 )
+	#error logBUFFER_ENTRIES must be a power of two
+#endif
+
+/** @brief Log entries, accessed through volatile pointers as they are shared with interrupts */
+static LogEntry_t xLogEntries[ logBUFFER_ENTRIES ];
+/** @brief Free running index of the next slot to reserve */
+static volatile uint16_t usLogHead = 0;
+/** @brief Free running index of the next entry to read, written by the consumer only */
+static volatile uint16_t usLogTail = 0;
+/** @brief Messages dropped because the log was full */
+static volatile uint16_t usDropped = 0;
+
+void vLogPost( LogMessage_t eId, uint16_t usArg0, uint16_t usArg1, uint16_t usArg2 )
+{
+    volatile LogEntry_t *pxEntry;
+    unsigned short usInterruptState;
+    uint16_t usSlot;
+
+    /* Reserve a slot. Restoring the saved state keeps interrupts disabled
+    when called from an interrupt or a critical section. */
+    usInterruptState = __get_interrupt_state();
+    __disable_interrupt();
+
+    usSlot = usLogHead;
+
+    if( ( uint16_t ) ( usSlot - usLogTail ) >= logBUFFER_ENTRIES )
+    {
+        usDropped++;
+        __set_interrupt_state( usInterruptState );
+        return;
+    }
+
+    usLogHead = usSlot + 1;
+
+    __set_interrupt_state( usInterruptState );
+
+    pxEntry = &xLogEntries[ usSlot & ( logBUFFER_ENTRIES - 1 ) ];
+    pxEntry->ucId = ( uint8_t ) eId;
+    pxEntry->usTick = ( uint16_t ) xTaskGetTickCountFromISR();
+    pxEntry->usArg[ 0 ] = usArg0;
+    pxEntry->usArg[ 1 ] = usArg1;
+    pxEntry->usArg[ 2 ] = usArg2;
+    pxEntry->ucReady = pdTRUE;
+}
+
+UBaseType_t uxLogRead( LogEntry_t *pxEntries, UBaseType_t uxMaxEntries )
+{
+    volatile LogEntry_t *pxEntry;
+    UBaseType_t uxCount = 0;
+    uint16_t usTail = usLogTail;
+
+    while( ( uxCount < uxMaxEntries ) && ( usTail != usLogHead ) )
+    {
+        pxEntry = &xLogEntries[ usTail & ( logBUFFER_ENTRIES - 1 ) ];
+
+        /* Reserved by a producer that has been interrupted, later entries
+        wait for it so the order is kept. */
+        if( pxEntry->ucReady == pdFALSE )
+        {
+            break;
+        }
+
+        pxEntries[ uxCount ].ucId = pxEntry->ucId;
+        pxEntries[ uxCount ].ucReady = pdTRUE;
+        pxEntries[ uxCount ].usTick = pxEntry->usTick;
+        pxEntries[ uxCount ].usArg[ 0 ] = pxEntry->usArg[ 0 ];
+        pxEntries[ uxCount ].usArg[ 1 ] = pxEntry->usArg[ 1 ];
+        pxEntries[ uxCount ].usArg[ 2 ] = pxEntry->usArg[ 2 ];
+        uxCount++;
+
+        /* The slot is handed back only after it has been marked empty. */
+        pxEntry->ucReady = pdFALSE;
+        usTail++;
+        usLogTail = usTail;
+    }
+
+    return uxCount;
+}
+
+uint16_t usLogDropped( void )
+{
+    return usDropped;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file log.h
+ * @brief Deferred-format log
+ *
+ * Messages are not formatted on the board. A log call stores the index of its
+ * format string, the tick count and up to three 16-bit arguments in a fixed
+ * size entry, which costs a function call and a few dozen cycles, from a task
+ * or an interrupt alike, and never blocks. The telemetry task takes the
+ * entries out and sends them to the PC, where the messages are rendered from
+ * the table in log_messages.h.
+ *
+ * When the log is full new messages are dropped and counted; the count is
+ * sent along with the entries so the PC can tell where messages are missing.
+ */
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#include "FreeRTOS.h"
+#include "log_messages.h"
+
+/** @brief Set to 0 to compile every log call away */
+#ifndef logENABLED
+#define logENABLED              ( 1 )
+#endif
+
+/** @brief Number of entries the log holds, a power of two */
+#ifndef logBUFFER_ENTRIES
+#define logBUFFER_ENTRIES       ( 16 )
+#endif
+
+/** @brief Number of arguments an entry holds */
+#define logMAX_ARGS             ( 3 )
+
+/** @brief Message ids, one per entry of logMESSAGES */
+#define logENUM( eId, pcFormat )    eId,
+typedef enum
+{
+    logMESSAGES( logENUM )
+    eLogCount
+} LogMessage_t;
+#undef logENUM
+
+/** @brief One message as it is stored and sent, 10 bytes */
+typedef struct
+{
+    uint8_t ucId;                       /**< LogMessage_t of the message */
+    uint8_t ucReady;                    /**< set when the entry has been written completely */
+    uint16_t usTick;                    /**< tick count when the message was logged */
+    uint16_t usArg[ logMAX_ARGS ];      /**< arguments, unused ones are 0 */
+} LogEntry_t;
+
+#if( logENABLED == 1 )
+    #define logMESSAGE0( eId )                  vLogPost( ( eId ), 0, 0, 0 )
+    #define logMESSAGE1( eId, a )               vLogPost( ( eId ), ( a ), 0, 0 )
+    #define logMESSAGE2( eId, a, b )            vLogPost( ( eId ), ( a ), ( b ), 0 )
+    #define logMESSAGE3( eId, a, b, c )         vLogPost( ( eId ), ( a ), ( b ), ( c ) )
+#else
+    #define logMESSAGE0( eId )
+    #define logMESSAGE1( eId, a )
+    #define logMESSAGE2( eId, a, b )
+    #define logMESSAGE3( eId, a, b, c )
+#endif
+
+/**
+ * @brief Log a message
+ * @param eId id of the message
+ * @param usArg0 first argument
+ * @param usArg1 second argument
+ * @param usArg2 third argument
+ *
+ * Use the logMESSAGEn macros. Can be called from tasks, interrupts and before
+ * the scheduler is started.
+ */
+extern void vLogPost( LogMessage_t eId, uint16_t usArg0, uint16_t usArg1, uint16_t usArg2 );
+
+/**
+ * @brief Take logged messages out of the log
+ * @param pxEntries array the entries are copied to
+ * @param uxMaxEntries size of @p pxEntries
+ * @return number of entries copied
+ *
+ * Entries come out in the order they were reserved. One task only.
+ */
+extern UBaseType_t uxLogRead( LogEntry_t *pxEntries, UBaseType_t uxMaxEntries );
+
+/**
+ * @brief Number of messages dropped because the log was full
+ * @return running count, wraps at 65536
+ */
+extern uint16_t usLogDropped( void );
+
+#endif /* LOG_H_ */
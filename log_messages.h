@@ -0,0 +1,27 @@
+/**
+ * @file log_messages.h
+ * @brief Format strings of the deferred log
+ *
+ * Every message is listed once as X( id, format ). The board only sends the
+ * index of the message and its arguments; tools/telemetry_decode.py reads this
+ * file and renders the messages on the PC, so the formats never take up space
+ * in the image. Arguments are 16-bit words, use %u, %d or %x. New messages go
+ * at the end, so the ids of recorded logs stay valid.
+ */
+
+#ifndef LOG_MESSAGES_H_
+#define LOG_MESSAGES_H_
+
+#define logMESSAGES( X ) \
+    X( eLogBoot,                "boot, reset cause %x" ) \
+    X( eLogAdcQueueFull,        "ADC queue full, channel %u sample %u lost" ) \
+    X( eLogPeriodChanged,       "sampling period set to %u ms" ) \
+    X( eLogWindowChanged,       "window of task %u set to %u samples" ) \
+    X( eLogChannelsChanged,     "channel mask set to %x" ) \
+    X( eLogTelemetryChanged,    "telemetry period %u ms, raw %u" ) \
+    X( eLogBaudChanged,         "telemetry port set to %u00 baud, error %d in 0.01 %%" ) \
+    X( eLogClockChanged,        "clock set to %u kHz at %u %% load" ) \
+    X( eLogClockProfile,        "clock profile %u of %u, MCLK %u kHz" ) \
+    X( eLogBootMilestone,       "boot milestone %u at %u.%03u ms" )
+
+#endif /* LOG_MESSAGES_H_ */
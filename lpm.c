@@ -0,0 +1,177 @@
+/**
+ * @file lpm.c
+ * @brief Low power mode manager
+ *
+ * The idle loop calls the idle hook and then, if the expected idle time is at
+ * least configEXPECTED_IDLE_TIME_BEFORE_SLEEP, vLpmSleep(). Only one of them
+ * sleeps in each pass: the idle hook skips its LPM0 when vLpmSleep() slept in
+ * the pass before, so a long idle period is spent in vLpmSleep() and a short
+ * one in the idle hook.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "uart.h"
+#include "lpm.h"
+
+/* Hardware includes. */
+#include "msp430.h"
+#include "hal_ETF5438A.h"
+
+#if( configUSE_TICKLESS_IDLE == 0 ) || ( configUSE_TICK_HOOK != 1 ) || ( configUSE_IDLE_HOOK != 1 )
+	#error lpm.c requires configUSE_TICKLESS_IDLE, configUSE_TICK_HOOK and configUSE_IDLE_HOOK
+#endif
+
+/* Value of uxCurrentMode while the CPU runs */
+#define lpmACTIVE                   ( lpmMODES )
+
+/** @brief Mode the CPU sleeps in, lpmACTIVE while it runs */
+static volatile UBaseType_t uxCurrentMode = lpmACTIVE;
+/** @brief pdTRUE if vLpmSleep() slept in the last pass of the idle loop */
+static BaseType_t xSleptInPass = pdFALSE;
+/** @brief Statistics, updated with interrupts disabled or from the tick interrupt */
+static LpmStats_t xStats;
+
+/**
+ * @brief Find the deepest mode the peripherals allow
+ * @return eLpm0 if a peripheral needs SMCLK, eLpm4 otherwise
+ *
+ * Called with interrupts disabled, so no peripheral starts meanwhile.
+ */
+static LpmMode_t prvDeepestAllowed( void )
+{
+    /* The FLL stops in LPM3 and would never settle */
+    if( xHALClockIsSettling() != pdFALSE )
+    {
+        return eLpm0;
+    }
+
+    /* Bits on the wire must keep their timing to the last stop bit */
+    if( xUartIsBusy() != pdFALSE )
+    {
+        return eLpm0;
+    }
+
+    /* A conversion clocked from anything but MODOSC */
+    if( ( ADC12CTL1 & ADC12BUSY ) && ( ( ADC12CTL1 & ADC12SSEL_3 ) != ADC12SSEL_0 ) )
+    {
+        return eLpm0;
+    }
+
+    /* The cycle counter and the simulated ADC */
+    if( ( TA1CTL & MC_3 ) && ( ( TA1CTL & TASSEL_3 ) == TASSEL_2 ) )
+    {
+        return eLpm0;
+    }
+
+    if( ( TB0CTL & MC_3 ) && ( ( TB0CTL & TBSSEL_3 ) == TBSSEL_2 ) )
+    {
+        return eLpm0;
+    }
+
+    return eLpm4;
+}
+
+/**
+ * @brief Sleep in a mode until an interrupt wakes the CPU
+ *
+ * Called with interrupts disabled; the mode is entered with the instruction
+ * that enables them, so no interrupt can come between the decision and the
+ * sleep. Interrupts are enabled on return.
+ */
+static void prvEnterMode( LpmMode_t eMode )
+{
+    xStats.xModes[ eMode ].ulWakeups++;
+    uxCurrentMode = eMode;
+
+    switch( eMode )
+    {
+        case eLpm4:
+            __bis_SR_register( LPM4_bits + GIE );
+            break;
+
+        case eLpm3:
+            __bis_SR_register( LPM3_bits + GIE );
+            break;
+
+        default:
+            __bis_SR_register( LPM0_bits + GIE );
+            break;
+    }
+    __no_operation();
+
+    uxCurrentMode = lpmACTIVE;
+}
+
+void vLpmSleep( TickType_t xExpectedIdleTime )
+{
+    LpmMode_t eMode;
+    LpmMode_t eAllowed;
+
+    xSleptInPass = pdTRUE;
+
+    portDISABLE_INTERRUPTS();
+
+    switch( eTaskConfirmSleepModeStatus() )
+    {
+        case eAbortSleep:
+            /* A task became ready after the scheduler was suspended */
+            portENABLE_INTERRUPTS();
+            return;
+
+        case eNoTasksWaitingTimeout:
+            /* Nothing needs the tick until an interrupt readies a task */
+            eMode = eLpm4;
+            break;
+
+        default:
+            eMode = ( xExpectedIdleTime >= lpmLPM3_MIN_IDLE ) ? eLpm3 : eLpm0;
+            break;
+    }
+
+    eAllowed = prvDeepestAllowed();
+    if( eMode > eAllowed )
+    {
+        eMode = eAllowed;
+    }
+
+    prvEnterMode( eMode );
+}
+
+void vLpmIdleHook( void )
+{
+    if( xSleptInPass != pdFALSE )
+    {
+        xSleptInPass = pdFALSE;
+        return;
+    }
+
+    portDISABLE_INTERRUPTS();
+    prvEnterMode( eLpm0 );
+}
+
+void vLpmTickHook( void )
+{
+    if( uxCurrentMode < lpmMODES )
+    {
+        xStats.xModes[ uxCurrentMode ].ulTicks++;
+    }
+    else
+    {
+        xStats.ulActiveTicks++;
+    }
+}
+
+BaseType_t xLpmIsActive( void )
+{
+    return ( uxCurrentMode < lpmMODES ) ? pdFALSE : pdTRUE;
+}
+
+void vLpmGetStats( LpmStats_t *pxStats )
+{
+    /* The counters are wider than the CPU and change in the tick interrupt */
+    taskENTER_CRITICAL();
+    *pxStats = xStats;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,107 @@
+/**
+ * @file lpm.h
+ * @brief Low power mode manager
+ *
+ * The idle task sleeps in the deepest low power mode that the time until the
+ * next task wakes and the peripherals still at work allow:
+ *
+ *     LPM0   CPU off; MCLK off, SMCLK and the DCO keep running
+ *     LPM3   SMCLK, the DCO and the FLL off as well; only ACLK runs
+ *     LPM4   every clock off, ACLK included
+ *
+ * The kernel passes the expected idle time, the ticks until the next task
+ * that waits with a timeout wakes (xNextTaskUnblockTime), through
+ * portSUPPRESS_TICKS_AND_SLEEP(). The tick itself is not suppressed: it keeps
+ * running from ACLK and ends every sleep in LPM0 or LPM3, so kernel time and
+ * the tick hooks carry on as before. An idle period shorter than lpmLPM3_MIN_IDLE
+ * ticks is spent in LPM0, where waking costs nothing but the interrupt.
+ *
+ * LPM4 stops ACLK and with it the tick, so it is only used while no task
+ * waits with a timeout; only an interrupt such as a received character wakes
+ * the system then, and kernel time stands still meanwhile.
+ *
+ * The FLL settling after boot, see xHALClockIsSettling(), and peripherals
+ * that need SMCLK keep the system in LPM0: a UART port moving bits, the
+ * ADC12 converting from SMCLK, and Timer_A1 or Timer_B0 running from SMCLK.
+ * A UART port waiting for characters does not: the USCI starts its clock by
+ * itself on a start edge. The ADC12 converting from MODOSC needs nothing
+ * either, MODOSC runs on request in every mode.
+ *
+ * The tick hook samples which mode the CPU was in when the tick came, which
+ * gives the share of time spent in LPM0 and LPM3. LPM4 stops the tick, so
+ * only its wakeups are counted.
+ */
+
+#ifndef LPM_H_
+#define LPM_H_
+
+#include "FreeRTOS.h"
+
+/** @brief Shortest expected idle time in ticks that is spent in LPM3 */
+#ifndef lpmLPM3_MIN_IDLE
+#define lpmLPM3_MIN_IDLE            ( 2 )
+#endif
+
+/** @brief Low power mode */
+typedef enum
+{
+    eLpm0 = 0,                  /**< CPU off */
+    eLpm3,                      /**< CPU, SMCLK and DCO off */
+    eLpm4                       /**< every clock off */
+} LpmMode_t;
+
+/** @brief Number of low power modes the manager uses */
+#define lpmMODES                    ( 3 )
+
+/** @brief Statistics of one low power mode */
+typedef struct
+{
+    uint32_t ulWakeups;         /**< number of times the mode was entered and left */
+    uint32_t ulTicks;           /**< ticks that found the CPU in the mode, 0 for LPM4 */
+} LpmModeStats_t;
+
+/** @brief Statistics of the low power mode manager */
+typedef struct
+{
+    LpmModeStats_t xModes[ lpmMODES ];  /**< per mode, indexed by LpmMode_t */
+    uint32_t ulActiveTicks;             /**< ticks that found the CPU running */
+} LpmStats_t;
+
+/**
+ * @brief Sleep until the next interrupt
+ * @param xExpectedIdleTime ticks until the next task waiting with a timeout wakes
+ *
+ * Called by the idle task through portSUPPRESS_TICKS_AND_SLEEP() with the
+ * scheduler suspended.
+ */
+extern void vLpmSleep( TickType_t xExpectedIdleTime );
+
+/**
+ * @brief Sleep in LPM0 when the idle time is too short for vLpmSleep()
+ *
+ * Called from vApplicationIdleHook().
+ */
+extern void vLpmIdleHook( void );
+
+/**
+ * @brief Count the tick towards the residency of the current mode
+ *
+ * Called from vApplicationTickHook().
+ */
+extern void vLpmTickHook( void );
+
+/**
+ * @brief Check whether the CPU runs
+ * @return pdFALSE while the idle task sleeps in a low power mode, pdTRUE otherwise
+ *
+ * Meant for the tick hooks, which see the mode the tick interrupted.
+ */
+extern BaseType_t xLpmIsActive( void );
+
+/**
+ * @brief Get the statistics
+ * @param pxStats set to the statistics since boot
+ */
+extern void vLpmGetStats( LpmStats_t *pxStats );
+
+#endif /* LPM_H_ */
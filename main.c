@@ -17,6 +17,8 @@
 /* Standard includes */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 
 /* FreeRTOS includes */
 #include "FreeRTOS.h"
@@ -26,6 +28,17 @@
 #include "uart.h"
 #include "adc.h"
 #include "semphr.h"
+#include "stack_monitor.h"
+#include "benchmark.h"
+#include "adc_stress.h"
+#include "adc_sim.h"
+#include "command.h"
+#include "telemetry.h"
+#include "log.h"
+#include "dvfs.h"
+#include "lpm.h"
+#include "boot.h"
+#include "energy.h"
 
 /* Hardware includes */
 #include "msp430.h"
@@ -40,9 +53,67 @@
 /* Timer periods */
 #define mainTIMER100_PERIOD     ( pdMS_TO_TICKS(100) )
 
+/* Time from the start of the scheduler to the deferred initialisation; the
+UART ports need the FLL settled */
+#define mainDEFER_DELAY         ( pdMS_TO_TICKS( HAL_FLL_SETTLE_MS ) )
+
+/* Stack of the initialisation task, freed when it deletes itself; it opens
+the ports and creates the other tasks, and the interrupts stack on it too */
+#define mainINIT_STACK_SIZE     ( 3 * configMINIMAL_STACK_SIZE )
+
+/* Time between two stack usage reports */
+#define mainSTACKMON_PERIOD     ( pdMS_TO_TICKS(10000) )
+
 /* Task Priorities */
 #define mainHP_TASK_PRIO        ( 2 )
 #define mainLP_TASK_PRIO        ( 1 )
+#define mainBENCH_TASK_PRIO     ( 4 )
+#define mainSTRESS_TASK_PRIO    ( 3 )
+#define mainCMD_TASK_PRIO       ( 1 )
+#define mainDVFS_TASK_PRIO      ( mainHP_TASK_PRIO )
+#define mainINIT_TASK_PRIO      ( configTIMER_TASK_PRIORITY - 1 )
+
+/* Set to 1 to run the kernel microbenchmark suite once after start-up */
+#define mainRUN_BENCHMARKS      ( 0 )
+
+/* Set to 1 to drive the pipeline from the simulated ADC and find its saturation rate */
+#define mainRUN_ADC_STRESS      ( 0 )
+
+/* Set to 1 to feed the pipeline from the capture in adc_capture.c instead of A14/A15 */
+#define mainADC_REPLAY          ( 0 )
+
+/* Clock sources, see hal_clock.h: eHALClockRefoFll needs no crystal,
+eHALClockXt2 and eHALClockXt2Xt1 need the XT2 crystal of configXT2_CLOCK_HZ */
+#define mainCLOCK_PROFILE       ( eHALClockRefoFll )
+
+/* Set to 1 to scale the clock and VCore with the CPU load; only under the
+FLL profiles, as the governor scales the DCO */
+#define mainRUN_DVFS            ( 1 )
+
+#if( mainRUN_DVFS == 1 ) && ( ( mainRUN_BENCHMARKS == 1 ) || ( mainRUN_ADC_STRESS == 1 ) || ( mainADC_REPLAY == 1 ) )
+	#error The benchmarks and the simulated ADC are timed from SMCLK, which the governor changes
+#endif
+
+/* 1 replays with the recorded timing, N replays N times faster */
+#define mainADC_REPLAY_SPEEDUP  ( 1 )
+
+/* pdTRUE starts the capture over after the last record */
+#define mainADC_REPLAY_LOOP     ( pdFALSE )
+
+/* UART ports: text console with commands and reports, binary telemetry.
+Both may be the same port, frames and text can share it, but then without
+XON/XOFF, as frames may contain those characters. */
+#define mainCONSOLE_PORT        ( eUartA0 )
+#define mainTELEMETRY_PORT      ( eUartA1 )
+#define mainCONSOLE_BAUD        ( 115200UL )
+#define mainTELEMETRY_BAUD      ( 921600UL )
+
+/* Limits of the settings that can be changed with commands */
+#define mainMIN_PERIOD_MS       ( 10 )
+#define mainMAX_PERIOD_MS       ( 10000 )
+#define mainMIN_TELEMETRY_MS    ( 50 )
+#define mainMIN_BAUD            ( 1200UL )
+#define mainMAX_BAUD            ( 3000000UL )
 
 /* Start konverzije */
 #define adcSTART_CONV       do { ADC12CTL0 |= ADC12SC; } while( 0 )
@@ -54,6 +125,18 @@ static void prvTask2( void *pvParameters );
 static void prvTask3( void *pvParameters );
 static void vTimer100Callback( TimerHandle_t xTimer100 );   // software timer
 static void vTimerLEDCallback( TimerHandle_t xTimer );
+static void prvDeferredInit( void *pvParameters );
+static void prvGetAverages( uint16_t *pusAverages );
+static BaseType_t prvPeriodCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+static BaseType_t prvWindowCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+static BaseType_t prvChannelsCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+static BaseType_t prvTelemetryCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+static BaseType_t prvRawCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+static BaseType_t prvBaudCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+static BaseType_t prvClockCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+static BaseType_t prvLpmCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+static BaseType_t prvBootCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
+static BaseType_t prvStatusCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength );
 
 /* Handler declarations */
 static TaskHandle_t      xTask3         = NULL;
@@ -62,13 +145,45 @@ static TimerHandle_t     xTimer100      = NULL;
 static QueueHandle_t     xADCDataQueue  = NULL;
 static QueueHandle_t     xQueue1        = NULL; //For task1
 static QueueHandle_t     xQueue2        = NULL; //For task2
-static SemaphoreHandle_t xMutex_ADCQueue= NULL;
+static UartHandle_t      xConsolePort   = NULL;
+static UartHandle_t      xTelemetryPort = NULL;
+
+/* Console port: 64 bytes of commands can wait to be read, the terminal is
+paced with XON/XOFF */
+static const UartConfig_t xConsoleConfig =
+{
+    mainCONSOLE_BAUD, 128, 64, 0, eUartFlowXonXoff
+};
+
+/* Telemetry port: transmit only, frames are lent rather than copied */
+static const UartConfig_t xTelemetryConfig =
+{
+    mainTELEMETRY_BAUD, 16, 0, telemetryFRAME_BUFFERS, eUartFlowNone
+};
 
 /* Variables that counting the number of bounces received for Task1 and Task2 */
 uint8_t ucCounter1, ucCounter2;
 
-/* The number of bounces based on which is calculat average value for Task1 and Task2 */
-const uint16_t usSamples1=16, usSamples2=32;
+/* The number of bounces based on which is calculat average value for Task1 and Task2, changed with the window command */
+volatile uint16_t usSamples1=16, usSamples2=32;
+
+/* Channels whose conversion results are posted, one bit per Button_t, changed with the channels command */
+volatile uint8_t ucChannelMask = ( 1 << S1 ) | ( 1 << S2 );
+
+/* Commands that configure the acquisition at runtime */
+static const Command_t xMainCommands[] =
+{
+    { "period",    "<ms>",                  prvPeriodCommand },
+    { "window",    "<1|2> <samples>",       prvWindowCommand },
+    { "channels",  "[14] [15]",             prvChannelsCommand },
+    { "telemetry", "<ms, 0 is off>",        prvTelemetryCommand },
+    { "raw",       "<0|1>",                 prvRawCommand },
+    { "baud",      "<telemetry baud rate>", prvBaudCommand },
+    { "clock",     "",                      prvClockCommand },
+    { "lpm",       "[wake]",                prvLpmCommand },
+    { "boot",      "",                      prvBootCommand },
+    { "status",    "",                      prvStatusCommand }
+};
 
 /* The mean value of the 16 bounces for Task 1 */
 uint16_t usADCAvg_value1 = 0;
@@ -103,41 +218,29 @@ const uint8_t pucTabelaseg[] = {    0x7e,
 /**
  * @brief Entering the mean value of the last 16 buffers measured on channel A14
  *
- * Check if the message at the top of the message line is for Task1.
- * If it is, it reads the message and the swab is out of line.
+ * Waits for the next message of channel A14 and takes it out of the line; messages of other channels are left for their tasks.
  * After that, the average value of the last 32 received bounces is recalculated and the new medium is entered into the mailbox with overwrite.
  *
  */
 static void prvTask1( void *pvParameters )
 {
-    /* Check whether the message in the row with the messages belongs to Task1 */
-    ADCmsg_t xCheckQueue;
-
-    /* Enters the data if it belongs to Tasku1 */
+    /* Message of channel A14 taken from the line */
     ADCmsg_t xReadQueue;
 
     /* The sum of the last 32 */
     uint16_t usSum=0;
 
+    /* Window length used for this sample, the window command may change it meanwhile */
+    uint16_t usWindow;
+
     int i = 0;
     for ( ;; )
     {
 
-        /* Read the message without deleting it from the message line */
-        xQueuePeek ( xADCDataQueue , &xCheckQueue , portMAX_DELAY ) ;
-
-        /* If the message represents a conversion value from channel A14 then it belongs to Tasku1 */
-        if( xCheckQueue.buttonNum == S1)
+        /* Block until a conversion value from channel A14 is in the line and take it out atomically */
+        if( xQueueReceiveKeyed( xADCDataQueue, &xReadQueue, S1, portMAX_DELAY ) == pdPASS )
         {
-
-            /* Take the mutex to access the line with the messages containing the conversion results */
-            xSemaphoreTake( xMutex_ADCQueue, portMAX_DELAY );
-
-            /* Read the message */
-            xQueueReceive( xADCDataQueue, &xReadQueue, portMAX_DELAY );
-
-            /* Release the mutex */
-            xSemaphoreGive( xMutex_ADCQueue );
+            usWindow = usSamples1;
 
             /* In the array with the index counter, the value of the read data is entered */
             usADCRead1[ ucCounter1 ] = xReadQueue.value;
@@ -147,15 +250,16 @@ static void prvTask1( void *pvParameters )
 
             /* If the counter has exceeded 16, it resets to 0 */
             /* This way, the cyclical entry of the last 16 readers received is provided */
-            if( ucCounter1 == usSamples1) ucCounter1 = 0;
+            /* A window that was made shorter resets the counter as well */
+            if( ucCounter1 >= usWindow) ucCounter1 = 0;
 
             /* The calculation of the last 32 */
             usSum = 0;
-            for (i = 0; i < usSamples1; i++)
+            for (i = 0; i < usWindow; i++)
                 usSum += usADCRead1[ i ];
 
             /* The mean value of the last 16 bets is calculated */
-            usADCAvg_value1 = usSum / usSamples1;
+            usADCAvg_value1 = usSum / usWindow;
 
             /* A mailbox with an overwrite is entered */
             xQueueOverwrite ( xQueue1 , &usADCAvg_value1 );
@@ -169,41 +273,30 @@ static void prvTask1( void *pvParameters )
 /**
  * @brief Entering the mean value of the last 32 buffers measured on channel A15
  *
- * Check if the message at the top of the message line is for Task2.
- * If it is, it reads the message and the swab is out of line.
+ * Waits for the next message of channel A15 and takes it out of the line; messages of other channels are left for their tasks.
  * After that, the average value of the last 32 received bounces is recalculated and the new medium is entered into the mailbox with overwrite.
  *
  */
 static void prvTask2( void *pvParameters )
 {
 
-    /* Check whether the message in the row with the messages belongs to Task2 */
-    ADCmsg_t xCheckQueue;
-
-    /* Enters the data if it belongs to Tasku2 */
+    /* Message of channel A15 taken from the line */
     ADCmsg_t xReadQueue;
 
     /* The sum of the last 32 */
     uint32_t usSum=0;
+
+    /* Window length used for this sample, the window command may change it meanwhile */
+    uint16_t usWindow;
+
     int i = 0;
     for ( ;; )
     {
 
-        /* Read the message without deleting it from the message line */
-        xQueuePeek ( xADCDataQueue , &xCheckQueue , portMAX_DELAY ) ;
-
-        /* If the message represents a conversion value from channel A15 then it belongs to Tasku2 */
-        if( xCheckQueue.buttonNum == S2 )
+        /* Block until a conversion value from channel A15 is in the line and take it out atomically */
+        if( xQueueReceiveKeyed( xADCDataQueue, &xReadQueue, S2, portMAX_DELAY ) == pdPASS )
         {
-
-            /* Take the mutex to access the line with the messages containing the conversion results */
-            xSemaphoreTake( xMutex_ADCQueue, portMAX_DELAY );
-
-            /* Read the message */
-            xQueueReceive( xADCDataQueue, &xReadQueue, portMAX_DELAY );
-
-            /* Release the mutex */
-            xSemaphoreGive( xMutex_ADCQueue );
+            usWindow = usSamples2;
 
             /* In the array with the index counter, the value of the read data is entered */
             ulADCRead2[ ucCounter2 ] = xReadQueue.value;
@@ -213,15 +306,16 @@ static void prvTask2( void *pvParameters )
 
             /* If the counter has exceeded 32, it resets to 0 */
             /* This way, the cyclical entry of the last 32 readers received is provided */
-            if( ucCounter2 == usSamples2) ucCounter2 = 0;
+            /* A window that was made shorter resets the counter as well */
+            if( ucCounter2 >= usWindow) ucCounter2 = 0;
 
             /* The calculation of the last 32 */
             usSum = 0;
-            for (i = 1; i < usSamples2; i++)
+            for (i = 1; i < usWindow; i++)
                 usSum += ulADCRead2[ i ];
 
             /* The mean value of the last 32 is calculated */
-            usADCAvg_value2 = usSum / usSamples2;
+            usADCAvg_value2 = usSum / usWindow;
 
             /* A mailbox with an overwrite is entered */
             xQueueOverwrite ( xQueue2 , &usADCAvg_value2 );
@@ -376,6 +470,282 @@ static void vTimer100Callback( TimerHandle_t xTimer100 )
     adcSTART_CONV;
 }
 
+/**
+ * @brief Provide the averages for telemetry
+ *
+ * Called from the telemetry task; each average is a single word, so it is read whole.
+ */
+static void prvGetAverages( uint16_t *pusAverages )
+{
+    pusAverages[ 0 ] = usADCAvg_value1;
+    pusAverages[ 1 ] = usADCAvg_value2;
+}
+
+/**
+ * @brief period command, sets the time between two conversions of the channels
+ */
+static BaseType_t prvPeriodCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    uint32_t ulPeriod;
+
+    if( ( uxArgc != 2 ) || ( xCommandParseNumber( ppcArgv[ 1 ], mainMIN_PERIOD_MS, mainMAX_PERIOD_MS, &ulPeriod ) != pdPASS ) )
+    {
+        return pdFAIL;
+    }
+
+    /* Changing the period would start the timer, so leave it alone while simulated samples are used */
+    if( xTimerIsTimerActive( xTimer100 ) == pdFALSE )
+    {
+        snprintf( pcReply, xReplyLength, "sampling timer not running" );
+        return pdFAIL;
+    }
+
+    if( xTimerChangePeriod( xTimer100, pdMS_TO_TICKS( ulPeriod ), pdMS_TO_TICKS( 10 ) ) != pdPASS )
+    {
+        snprintf( pcReply, xReplyLength, "timer busy" );
+        return pdFAIL;
+    }
+
+    logMESSAGE1( eLogPeriodChanged, ( uint16_t ) ulPeriod );
+
+    snprintf( pcReply, xReplyLength, "period %u", ( unsigned ) ulPeriod );
+    return pdPASS;
+}
+
+/**
+ * @brief window command, sets the number of samples averaged for channel A14 (1) or A15 (2)
+ */
+static BaseType_t prvWindowCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    uint32_t ulTask, ulSamples;
+
+    if( ( uxArgc != 3 ) || ( xCommandParseNumber( ppcArgv[ 1 ], 1, 2, &ulTask ) != pdPASS ) )
+    {
+        return pdFAIL;
+    }
+
+    /* The window can not be longer than the array the samples are kept in */
+    if( ulTask == 1 )
+    {
+        if( xCommandParseNumber( ppcArgv[ 2 ], 1, sizeof( usADCRead1 ) / sizeof( usADCRead1[ 0 ] ), &ulSamples ) != pdPASS )
+        {
+            return pdFAIL;
+        }
+
+        usSamples1 = ( uint16_t ) ulSamples;
+    }
+    else
+    {
+        if( xCommandParseNumber( ppcArgv[ 2 ], 1, sizeof( ulADCRead2 ) / sizeof( ulADCRead2[ 0 ] ), &ulSamples ) != pdPASS )
+        {
+            return pdFAIL;
+        }
+
+        usSamples2 = ( uint16_t ) ulSamples;
+    }
+
+    logMESSAGE2( eLogWindowChanged, ( uint16_t ) ulTask, ( uint16_t ) ulSamples );
+
+    snprintf( pcReply, xReplyLength, "window %u %u", ( unsigned ) ulTask, ( unsigned ) ulSamples );
+    return pdPASS;
+}
+
+/**
+ * @brief channels command, selects the channels whose samples are processed; without arguments none are
+ */
+static BaseType_t prvChannelsCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    uint8_t ucMask = 0;
+    UBaseType_t ux;
+
+    for( ux = 1; ux < uxArgc; ux++ )
+    {
+        if( strcmp( ppcArgv[ ux ], "14" ) == 0 )
+        {
+            ucMask |= ( 1 << S1 );
+        }
+        else if( strcmp( ppcArgv[ ux ], "15" ) == 0 )
+        {
+            ucMask |= ( 1 << S2 );
+        }
+        else
+        {
+            return pdFAIL;
+        }
+    }
+
+    ucChannelMask = ucMask;
+    logMESSAGE1( eLogChannelsChanged, ucMask );
+
+    snprintf( pcReply, xReplyLength, "channels%s%s",
+              ( ucMask & ( 1 << S1 ) ) ? " 14" : "",
+              ( ucMask & ( 1 << S2 ) ) ? " 15" : "" );
+    return pdPASS;
+}
+
+/**
+ * @brief telemetry command, sets the time between two averages and counters records
+ */
+static BaseType_t prvTelemetryCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    uint32_t ulPeriod;
+
+    if( ( uxArgc != 2 ) || ( xCommandParseNumber( ppcArgv[ 1 ], 0, mainMAX_PERIOD_MS, &ulPeriod ) != pdPASS ) )
+    {
+        return pdFAIL;
+    }
+
+    /* Keep the UART free for command replies */
+    if( ( ulPeriod != 0 ) && ( ulPeriod < mainMIN_TELEMETRY_MS ) )
+    {
+        return pdFAIL;
+    }
+
+    vTelemetrySetPeriod( ( uint16_t ) ulPeriod );
+    logMESSAGE2( eLogTelemetryChanged, ( uint16_t ) ulPeriod, ( uint16_t ) xTelemetryGetRaw() );
+
+    snprintf( pcReply, xReplyLength, "telemetry %u", ( unsigned ) ulPeriod );
+    return pdPASS;
+}
+
+/**
+ * @brief raw command, switches streaming of every conversion result on or off
+ */
+static BaseType_t prvRawCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    uint32_t ulEnable;
+
+    if( ( uxArgc != 2 ) || ( xCommandParseNumber( ppcArgv[ 1 ], 0, 1, &ulEnable ) != pdPASS ) )
+    {
+        return pdFAIL;
+    }
+
+    vTelemetrySetRaw( ( ulEnable != 0 ) ? pdTRUE : pdFALSE );
+    logMESSAGE2( eLogTelemetryChanged, usTelemetryGetPeriod(), ( uint16_t ) ulEnable );
+
+    snprintf( pcReply, xReplyLength, "raw %u", ( unsigned ) ulEnable );
+    return pdPASS;
+}
+
+/**
+ * @brief baud command, changes the baud rate of the telemetry port
+ *
+ * The reply reports the error of the rate reached in 0.01 %, also when it is
+ * too large and the old rate is kept.
+ */
+static BaseType_t prvBaudCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    uint32_t ulBaud;
+    UartBaud_t xBaud;
+
+    if( ( uxArgc != 2 ) || ( xCommandParseNumber( ppcArgv[ 1 ], mainMIN_BAUD, mainMAX_BAUD, &ulBaud ) != pdPASS ) )
+    {
+        return pdFAIL;
+    }
+
+    /* Frames already queued go out at the old rate first */
+    if( xUartSetBaud( xTelemetryPort, ulBaud, &xBaud, pdMS_TO_TICKS( 100 ) ) != pdPASS )
+    {
+        snprintf( pcReply, xReplyLength, "baud %lu err %d, kept %lu", ( unsigned long ) ulBaud,
+                  ( int ) xBaud.sError, ( unsigned long ) ulUartGetBaud( xTelemetryPort ) );
+        return pdFAIL;
+    }
+
+    logMESSAGE2( eLogBaudChanged, ( uint16_t ) ( ulBaud / 100 ), ( uint16_t ) xBaud.sError );
+
+    snprintf( pcReply, xReplyLength, "baud %lu err %d", ( unsigned long ) ulBaud, ( int ) xBaud.sError );
+    return pdPASS;
+}
+
+/**
+ * @brief clock command, reports the clock, the clock profile and the load of the last period
+ */
+static BaseType_t prvClockCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    ( void ) uxArgc;
+    ( void ) ppcArgv;
+
+    snprintf( pcReply, xReplyLength, "clock %lu kHz profile %u load %u %%",
+              ( unsigned long ) ( hal430GetSystemClock() / 1000UL ), ( unsigned ) eHALClockGetProfile(),
+              ( unsigned ) uxDvfsGetLoad() );
+    return pdPASS;
+}
+
+/**
+ * @brief lpm command, reports the share of time spent running and in LPM0 and
+ * LPM3, or with "wake" the number of wakeups from LPM0, LPM3 and LPM4
+ */
+static BaseType_t prvLpmCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    LpmStats_t xStats;
+    uint32_t ulPercent;
+
+    vLpmGetStats( &xStats );
+
+    if( uxArgc == 2 )
+    {
+        if( strcmp( ppcArgv[ 1 ], "wake" ) != 0 )
+        {
+            return pdFAIL;
+        }
+
+        snprintf( pcReply, xReplyLength, "wake %lu %lu %lu",
+                  ( unsigned long ) xStats.xModes[ eLpm0 ].ulWakeups,
+                  ( unsigned long ) xStats.xModes[ eLpm3 ].ulWakeups,
+                  ( unsigned long ) xStats.xModes[ eLpm4 ].ulWakeups );
+        return pdPASS;
+    }
+
+    /* One percent of the ticks, so the counts need not be multiplied */
+    ulPercent = ( xStats.ulActiveTicks + xStats.xModes[ eLpm0 ].ulTicks + xStats.xModes[ eLpm3 ].ulTicks ) / 100UL;
+    if( ulPercent == 0 )
+    {
+        ulPercent = 1;
+    }
+
+    snprintf( pcReply, xReplyLength, "run %u lpm0 %u lpm3 %u %%",
+              ( unsigned ) ( xStats.ulActiveTicks / ulPercent ),
+              ( unsigned ) ( xStats.xModes[ eLpm0 ].ulTicks / ulPercent ),
+              ( unsigned ) ( xStats.xModes[ eLpm3 ].ulTicks / ulPercent ) );
+    return pdPASS;
+}
+
+/**
+ * @brief boot command, reports when the clock was set, the first sample was
+ * taken and the deferred initialisation was done, in us from main()
+ */
+static BaseType_t prvBootCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    uint32_t ulClock, ulSample, ulReady;
+
+    ( void ) uxArgc;
+    ( void ) ppcArgv;
+
+    ( void ) xBootGetMilestone( eBootClock, &ulClock );
+    ( void ) xBootGetMilestone( eBootFirstSample, &ulSample );
+    ( void ) xBootGetMilestone( eBootReady, &ulReady );
+
+    snprintf( pcReply, xReplyLength, "clock %lu sample %lu ready %lu us",
+              ( unsigned long ) ulClock, ( unsigned long ) ulSample, ( unsigned long ) ulReady );
+    return pdPASS;
+}
+
+/**
+ * @brief status command, reports the current settings
+ */
+static BaseType_t prvStatusCommand( UBaseType_t uxArgc, char *ppcArgv[], char *pcReply, size_t xReplyLength )
+{
+    uint8_t ucMask = ucChannelMask;
+
+    snprintf( pcReply, xReplyLength, "per %u win %u %u ch%s%s tlm %u raw %u",
+              ( unsigned ) xTimerGetPeriod( xTimer100 ),
+              ( unsigned ) usSamples1, ( unsigned ) usSamples2,
+              ( ucMask & ( 1 << S1 ) ) ? " 14" : "",
+              ( ucMask & ( 1 << S2 ) ) ? " 15" : "",
+              ( unsigned ) usTelemetryGetPeriod(), ( unsigned ) xTelemetryGetRaw() );
+    return pdPASS;
+}
+
 /**
  * @brief Kreiranje potrebnih taskova i semafora
  *
@@ -386,9 +756,23 @@ static void vTimer100Callback( TimerHandle_t xTimer100 )
  */
 void main( void )
 {
+    /* Paint the system stack before it is used, so its peak usage can be measured */
+    vStackMonitorPaintSystemStack();
+
+    /* Boot milestones are timed from here */
+    vBootStart();
+
     /* Inicijalizacija hardvera */
     prvSetupHardware();
 
+    /* The reason of the last reset is the first message in the log */
+    logMESSAGE1( eLogBoot, SYSRSTIV );
+    logMESSAGE3( eLogClockProfile, ( uint16_t ) eHALClockGetProfile(), ( uint16_t ) mainCLOCK_PROFILE,
+                 ( uint16_t ) ( hal430GetSystemClock() / 1000UL ) );
+
+    /* Only what the first sample needs is set up before the scheduler starts,
+    the rest is done by prvDeferredInit() */
+
     /* Kreiranje taskova */
     xTaskCreate(prvTask1, "LP Task", configMINIMAL_STACK_SIZE, NULL, mainLP_TASK_PRIO, NULL );
     xTaskCreate(prvTask2, "LP Task", configMINIMAL_STACK_SIZE, NULL, mainLP_TASK_PRIO, NULL);
@@ -397,24 +781,41 @@ void main( void )
     /* Kreiranje tajmera za multipleksiranje displeja */
     xTimerLED = xTimerCreate("TimerLED", mainTIMERLED_PERIOD, pdTRUE, NULL, vTimerLEDCallback);
 
-    /* Create timers
+    /* Create timers */
     xTimer100 = xTimerCreate("Timer100", mainTIMER100_PERIOD, pdTRUE, NULL, vTimer100Callback);
 
     /* Red sa porukama u koji se upisuju konvertovani podaci */
     xADCDataQueue = xQueueCreate( 64, sizeof( ADCmsg_t ) );
 
+    /* Each task receives only the messages of its own channel */
+    vQueueSetKeyField( xADCDataQueue, offsetof( ADCmsg_t, buttonNum ), sizeof( Button_t ) );
+
     /* Red sa porukama duzine 1 u koji se upisuje srednja vrednost poslednjih 16 odbiraka koji pripadaju Tasku1 */
     xQueue1 = xQueueCreate ( 1, sizeof( uint16_t) );
 
     /* Red sa porukama duzine 1 u koji se upisuje srednja vrednost poslednjih 32 odbiraka koji pripadaju Tasku2 */
     xQueue2 = xQueueCreate ( 1, sizeof( uint16_t) );
 
-    /* Koristi se za pristup redu sa porukama gde se nalaze konvertovani podaci */
-    xMutex_ADCQueue = xSemaphoreCreateMutex();
+    /* Name the queues so their health counters can be read through the queue registry */
+    vQueueAddToRegistry( xADCDataQueue, "ADCData" );
+    vQueueAddToRegistry( xQueue1, "Mailbox1" );
+    vQueueAddToRegistry( xQueue2, "Mailbox2" );
+
+#if( mainRUN_ADC_STRESS == 1 )
+    /* The stress test reports on the console, it starts with the deferred initialisation */
+#elif( mainADC_REPLAY == 1 )
+    /* Recorded conversion results replace the real ones */
+    vADCSimStartReplay( &xADCCapture, mainADC_REPLAY_SPEEDUP, mainADC_REPLAY_LOOP );
+#else
+    /* The first sequence is converted now, its interrupt is the first thing
+    to run once the scheduler enables interrupts; the timer takes over after
+    one period */
+    adcSTART_CONV;
+    xTimerStart( xTimer100, 0 );
+#endif
 
-    /* Ukljucuje se tajmer koji sluzi za multipleksiranje LED-a */
-    xTimerStart( xTimer100, 0 ); 
-    xTimerStart( xTimerLED, 0 );
+    xTaskCreate( prvDeferredInit, "Init", mainINIT_STACK_SIZE, NULL, mainINIT_TASK_PRIO, NULL );
+    vBootMilestone( eBootScheduler );
 
     /* Startuj scheduler */
     vTaskStartScheduler();
@@ -440,6 +841,9 @@ void vADCInitHardware( void )
      /*  Setting the SHC bit for the sample source and hold signal and the conversion mode is the sequence of the channel */
      ADC12CTL1 = ADC12SHS_0 | ADC12CONSEQ_1 | ADC12SHP;
 
+     /* The conversion clock follows the clock profile */
+     ADC12CTL1 |= usHALClockAdcSource();
+
      /* In MEM0, the converted values from the A14 channel are entered */
      ADC12MCTL0 = ADC12INCH_14;
 
@@ -454,6 +858,78 @@ void vADCInitHardware( void )
 
 }
 
+/**
+ * @brief Finish the boot once the first sample has been taken
+ *
+ * A task of its own, which sleeps mainDEFER_DELAY after the scheduler has
+ * started until the FLL has settled; the first conversion, started before the
+ * scheduler, was taken right at its start. Everything the acquisition does
+ * not need is set up here: the UART ports and the tasks that use them, and
+ * the LED display. The boot milestones are logged last, then the task deletes
+ * itself and its stack goes back to the heap. The timer task would have to
+ * be given the deepest stack of the boot for all of the run time.
+ */
+static void prvDeferredInit( void *pvParameters )
+{
+    UBaseType_t uxMilestone;
+    uint32_t ulTimeUs;
+
+    ( void ) pvParameters;
+
+    vTaskDelay( mainDEFER_DELAY );
+
+    /* The UART bit clocks are computed from the settled SMCLK */
+    vHALClockSettled();
+
+    /* UART is used to report diagnostics to the PC */
+    xConsolePort = xUartOpen( mainCONSOLE_PORT, &xConsoleConfig );
+    xTelemetryPort = xUartOpen( mainTELEMETRY_PORT, &xTelemetryConfig );
+
+    /* Averages and raw samples are streamed to the PC as binary frames */
+    vTelemetryStart( mainLP_TASK_PRIO, xTelemetryPort, prvGetAverages );
+
+    /* Settings can be changed over UART while the system runs */
+    vCommandRegister( xMainCommands, sizeof( xMainCommands ) / sizeof( xMainCommands[ 0 ] ) );
+    vCommandStart( mainCMD_TASK_PRIO, xConsolePort );
+
+#if( mainRUN_DVFS == 1 )
+    /* The clock follows the load; the governor retunes the ports it opened above */
+    if( ( eHALClockGetProfile() == eHALClockRefoFll ) || ( eHALClockGetProfile() == eHALClockXt1Fll ) )
+    {
+        vDvfsStart( mainDVFS_TASK_PRIO );
+    }
+#endif
+
+    /* Stack usage is reported periodically by a low priority task */
+    vStackMonitorStart( mainLP_TASK_PRIO, mainSTACKMON_PERIOD, xConsolePort );
+
+#if( mainRUN_BENCHMARKS == 1 )
+    /* Results are printed over UART as CSV lines */
+    vBenchmarkStart( mainBENCH_TASK_PRIO, xConsolePort );
+#endif
+
+#if( mainRUN_ADC_STRESS == 1 )
+    /* The simulated source replaces the real conversions while the test runs */
+    vADCStressStart( xADCDataQueue, mainSTRESS_TASK_PRIO, xConsolePort );
+#endif
+
+    /* Ukljucuje se tajmer koji sluzi za multipleksiranje LED-a */
+    xTimerStart( xTimerLED, 0 );
+
+    vBootMilestone( eBootReady );
+
+    for( uxMilestone = 0; uxMilestone < bootMILESTONES; uxMilestone++ )
+    {
+        if( xBootGetMilestone( ( BootMilestone_t ) uxMilestone, &ulTimeUs ) == pdPASS )
+        {
+            logMESSAGE3( eLogBootMilestone, ( uint16_t ) uxMilestone,
+                         ( uint16_t ) ( ulTimeUs / 1000UL ), ( uint16_t ) ( ulTimeUs % 1000UL ) );
+        }
+    }
+
+    vTaskDelete( NULL );
+}
+
 /**
  * @brief Configure hardware upon boot
  *
@@ -466,14 +942,21 @@ static void prvSetupHardware( void )
     /* Disable the watchdog. */
     WDTCTL = WDTPW + WDTHOLD;
 
-    /* Initialization of AD converter */
+    /* Configure Clock. A profile whose crystal does not start falls back to */
+    /* REFOCLK and the DCO, the profile that was set is logged at boot. The */
+    /* FLL settles while the boot goes on. */
+    ( void ) eHALClockInit( mainCLOCK_PROFILE );
+    vBootMilestone( eBootClock );
+
+    /* Initialization of AD converter, after the clock it depends on */
     vADCInitHardware();
+    vBootMilestone( eBootAdc );
 
-    /* Configure Clock. Since we aren't using XT1 on the board, */
-    /* configure REFOCLK to source FLL adn ACLK. */
-    SELECT_FLLREF(SELREF__REFOCLK);
-    SELECT_ACLK(SELA__REFOCLK);
-    hal430SetSystemClock( configCPU_CLOCK_HZ, configLFXT_CLOCK_HZ );
+#if( mainRUN_BENCHMARKS == 1 )
+    /* Timer_A1 counts CPU cycles for profiling; it keeps SMCLK running, so
+    only when it is needed, see lpm.h */
+    vHALInitCycleCounter();
+#endif
 
     /* Enable buttons S1 and S2 as output*/
     P2DIR &= ~(0x30);
@@ -486,6 +969,41 @@ static void prvSetupHardware( void )
     P6DIR |= ~BIT7;
 }
 
+/**
+ * @brief Send one conversion result to the queue with the converted data
+ *
+ */
+BaseType_t xADCPostSampleFromISR( Button_t eChannel, uint16_t usValue, BaseType_t *pxHigherPriorityTaskWoken )
+{
+    ADCmsg_t xMsg;
+
+    vBootMilestoneFromISR( eBootFirstSample );
+
+    /* Samples of channels switched off with the channels command are dropped on purpose */
+    if( ( ucChannelMask & ( 1 << eChannel ) ) == 0 )
+    {
+        return pdPASS;
+    }
+
+    /* Raw samples are streamed before the queue, so the PC sees them even if the queue is full */
+    vTelemetryPostSampleFromISR( ( uint8_t ) eChannel, usValue );
+
+    xMsg.buttonNum = eChannel;
+    xMsg.value = usValue;
+
+    /* Send that message to ADC queue */
+    if( xQueueSendToBackFromISR( xADCDataQueue, &xMsg, pxHigherPriorityTaskWoken ) != pdPASS )
+    {
+        /* Logging does not format anything here, so it is cheap enough for the interrupt */
+        logMESSAGE2( eLogAdcQueueFull, ( uint16_t ) eChannel, usValue );
+        return errQUEUE_FULL;
+    }
+
+    vEnergySampleDeliveredFromISR();
+
+    return pdPASS;
+}
+
 /**
  * @brief Interupt cycle ADC.
  *
@@ -502,32 +1020,23 @@ __interrupt void adc12_isr()
     {
 
     case  6: /* Vector  6: ADC12IFG0 */
-		{
 
         /* When the button S1 is pressed, make a message with two fields
 		 * report that is's S1 and send the data read from ADC channel 14
 		 * resized to 12bits
 		 */
-        ADCmsg_t  xMsg = { S1, ADC12MEM0 };
+        xADCPostSampleFromISR( S1, ADC12MEM0, &xHigherPriorityTaskWoken );
 
-        /* Send that message to ADC queue */
-        xQueueSendToBackFromISR( xADCDataQueue, &xMsg, &xHigherPriorityTaskWoken );
-
-		}
     break;
 
     case  8: /* Vector  8: ADC12IFG1 */
-		{
+
 		/* When the button S2 is pressed, make a message with two fields
 		 * report that is's S2 and send the data read from ADC channel 15
 		 * resized to 12bits
 		 */
-        ADCmsg_t xMsg = { S2, ADC12MEM1 };
-
-        /* Send that message to ADC queue */
-        xQueueSendToBackFromISR( xADCDataQueue, &xMsg, &xHigherPriorityTaskWoken );
+        xADCPostSampleFromISR( S2, ADC12MEM1, &xHigherPriorityTaskWoken );
 
-		}
     break;
 	
     default:
@@ -535,4 +1044,8 @@ __interrupt void adc12_isr()
 
     }
 
+    /* Leave low power mode and switch to a woken consumer straight away,
+    rather than at the next tick */
+    __bic_SR_register_on_exit( SCG1 + SCG0 + OSCOFF + CPUOFF );
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
 }
@@ -0,0 +1,249 @@
+/**
+ * @file stack_monitor.c
+ * @brief Stack high-water monitoring service
+ *
+ * Periodically reports the stack high-water mark of every task and of the C
+ * system stack, and derives a recommended stack depth for each task. When the
+ * heap keeps an allocation map (configUSE_HEAP_MAP) the use of the heap is
+ * reported along with it.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "uart.h"
+#include "stack_monitor.h"
+
+/* Hardware includes. */
+#include "msp430.h"
+
+#if( configUSE_TRACE_FACILITY != 1 ) || ( configRECORD_STACK_HIGH_ADDRESS != 1 )
+	#error stack_monitor.c requires configUSE_TRACE_FACILITY and configRECORD_STACK_HIGH_ADDRESS set to 1
+#endif
+
+/* Pattern used to paint the system stack, the same one the kernel uses for
+task stacks. */
+#define stackmonFILL_BYTE           ( 0xa5U )
+
+/* Number of bytes below the current stack pointer that are left unpainted, to
+stay clear of the frame of the painting function itself. */
+#define stackmonPAINT_GUARD         ( 16 )
+
+/* Recommended depths are rounded up to a multiple of this many words. */
+#define stackmonROUND_WORDS         ( 8 )
+
+/* Symbols created by the linker for the .stack section. */
+extern uint8_t __STACK_END;
+extern uint8_t __STACK_SIZE;
+
+/** @brief Task status snapshot, on the heap so it does not need to fit on the monitor stack */
+static TaskStatus_t *pxTaskStatus = NULL;
+/** @brief Results of the last scan */
+static StackReport_t *pxStackReport = NULL;
+/** @brief Number of entries the two tables have room for */
+static UBaseType_t uxTableSize = 0;
+/** @brief Number of valid entries in pxStackReport */
+static UBaseType_t uxReportCount = 0;
+/** @brief Tasks that did not fit in the tables at the last scan */
+static UBaseType_t uxTasksNotShown = 0;
+/** @brief Time between two reports */
+static TickType_t xReportPeriod;
+/** @brief One line of the report, formatted here rather than on the monitor stack */
+static char cReportLine[ 48 ];
+/** @brief UART port the reports are printed on */
+static UartHandle_t xReportPort;
+
+void vStackMonitorPaintSystemStack( void )
+{
+    uint8_t *pucStackLimit = &__STACK_END - ( uint16_t ) &__STACK_SIZE;
+    uint8_t *pucStackPointer = ( uint8_t * ) _get_SP_register() - stackmonPAINT_GUARD;
+
+    /* The stack grows down, so everything between the bottom of the section
+    and the current stack pointer has not been used yet. */
+    while( pucStackLimit < pucStackPointer )
+    {
+        *pucStackLimit++ = stackmonFILL_BYTE;
+    }
+}
+
+uint16_t usStackMonitorSystemStackUsed( uint16_t *pusStackSize )
+{
+    const uint16_t usStackSize = ( uint16_t ) &__STACK_SIZE;
+    const uint8_t *pucStackByte = &__STACK_END - usStackSize;
+    uint16_t usUnused = 0;
+
+    while( ( usUnused < usStackSize ) && ( *pucStackByte == stackmonFILL_BYTE ) )
+    {
+        pucStackByte++;
+        usUnused++;
+    }
+
+    *pusStackSize = usStackSize;
+
+    return usStackSize - usUnused;
+}
+
+UBaseType_t uxStackMonitorGetReport( const StackReport_t **ppxReport )
+{
+    *ppxReport = pxStackReport;
+
+    return uxReportCount;
+}
+
+/**
+ * @brief Calculate the recommended depth for a task
+ * @param usStackDepth depth the task was created with, in words
+ * @param usHighWaterMark words the task has never used
+ * @return recommended depth in words
+ *
+ * Observed usage gets 12.5% headroom for paths that have not run yet plus the
+ * fixed interrupt frame margin, rounded up.
+ */
+static uint16_t prvRecommendDepth( uint16_t usStackDepth, uint16_t usHighWaterMark )
+{
+    uint16_t usUsed = usStackDepth - usHighWaterMark;
+    uint16_t usDepth = usUsed + ( usUsed >> 3 ) + stackmonISR_MARGIN_WORDS;
+
+    return ( usDepth + ( stackmonROUND_WORDS - 1 ) ) & ~( stackmonROUND_WORDS - 1 );
+}
+
+/**
+ * @brief Take a snapshot of all tasks and update the report table
+ */
+static void prvScanTasks( void )
+{
+    UBaseType_t uxTasks, ux;
+
+    /* uxTaskGetSystemState() fills nothing if the array cannot hold every
+    task, so with more tasks than expected only their number is reported. */
+    uxTasks = uxTaskGetSystemState( pxTaskStatus, uxTableSize, NULL );
+    if( uxTasks == 0 )
+    {
+        uxReportCount = 0;
+        uxTasksNotShown = uxTaskGetNumberOfTasks();
+        return;
+    }
+
+    for( ux = 0; ux < uxTasks; ux++ )
+    {
+        TaskStatus_t *pxStatus = &pxTaskStatus[ ux ];
+        StackReport_t *pxReport = &pxStackReport[ ux ];
+
+        pxReport->pcTaskName = pxStatus->pcTaskName;
+        pxReport->usStackDepth = ( uint16_t ) ( pxStatus->pxEndOfStack - pxStatus->pxStackBase + 1 );
+        pxReport->usHighWaterMark = pxStatus->usStackHighWaterMark;
+        pxReport->usRecommendedDepth = prvRecommendDepth( pxReport->usStackDepth, pxReport->usHighWaterMark );
+    }
+
+    uxReportCount = uxTasks;
+    uxTasksNotShown = 0;
+}
+
+#if( configUSE_HEAP_MAP == 1 )
+/**
+ * @brief Print the breakdown of the heap
+ *
+ * One line per kind of object that holds memory, then the free space and the
+ * bytes lost to slack and block headers.
+ */
+static void prvReportHeap( void )
+{
+    static HeapMap_t xHeapMap;
+    UBaseType_t ux;
+
+    vPortGetHeapMap( &xHeapMap );
+
+    for( ux = 0; ux < ( UBaseType_t ) eHeapTagCount; ux++ )
+    {
+        if( xHeapMap.uxTagBlocks[ ux ] != 0 )
+        {
+            xUartPrintf( xReportPort, cReportLine, sizeof( cReportLine ), portMAX_DELAY,
+                         "HEAP %s %u bytes in %u\r\n",
+                         pcPortGetHeapTagName( ( HeapTag_t ) ux ),
+                         ( unsigned ) xHeapMap.xTagBytes[ ux ],
+                         ( unsigned ) xHeapMap.uxTagBlocks[ ux ] );
+        }
+    }
+
+    xUartPrintf( xReportPort, cReportLine, sizeof( cReportLine ), portMAX_DELAY,
+                 "HEAP free %u in %u, largest %u\r\n",
+                 ( unsigned ) xHeapMap.xFreeBytes, ( unsigned ) xHeapMap.uxFreeBlocks,
+                 ( unsigned ) xHeapMap.xLargestFreeBlock );
+
+    xUartPrintf( xReportPort, cReportLine, sizeof( cReportLine ), portMAX_DELAY,
+                 "HEAP slack %u overhead %u of %u\r\n",
+                 ( unsigned ) xHeapMap.xSlackBytes, ( unsigned ) xHeapMap.xOverheadBytes,
+                 ( unsigned ) xHeapMap.xHeapSize );
+}
+#endif /* configUSE_HEAP_MAP */
+
+/**
+ * @brief Stack monitor task function
+ * @param pvParameters not used
+ *
+ * Scans all tasks once per period and prints one line per task. The line
+ * buffer is reused, which is safe because xUartPrintf() copies the text into
+ * the port's ring buffer before it returns.
+ */
+static void prvStackMonitorTask( void *pvParameters )
+{
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    UBaseType_t ux;
+    uint16_t usSystemStackSize, usSystemStackUsed;
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, xReportPeriod );
+
+        prvScanTasks();
+
+        for( ux = 0; ux < uxReportCount; ux++ )
+        {
+            xUartPrintf( xReportPort, cReportLine, sizeof( cReportLine ), portMAX_DELAY,
+                         "STK %s %u/%u rec %u\r\n",
+                         pxStackReport[ ux ].pcTaskName,
+                         ( unsigned ) ( pxStackReport[ ux ].usStackDepth - pxStackReport[ ux ].usHighWaterMark ),
+                         ( unsigned ) pxStackReport[ ux ].usStackDepth,
+                         ( unsigned ) pxStackReport[ ux ].usRecommendedDepth );
+        }
+
+        if( uxTasksNotShown != 0 )
+        {
+            xUartPrintf( xReportPort, cReportLine, sizeof( cReportLine ), portMAX_DELAY,
+                         "STK %u tasks not shown, room for %u\r\n",
+                         ( unsigned ) uxTasksNotShown, ( unsigned ) uxTableSize );
+        }
+
+        usSystemStackUsed = usStackMonitorSystemStackUsed( &usSystemStackSize );
+        xUartPrintf( xReportPort, cReportLine, sizeof( cReportLine ), portMAX_DELAY,
+                     "STK system %u/%u bytes\r\n",
+                     ( unsigned ) usSystemStackUsed, ( unsigned ) usSystemStackSize );
+
+#if( configUSE_HEAP_MAP == 1 )
+        prvReportHeap();
+#endif
+    }
+}
+
+void vStackMonitorStart( UBaseType_t uxPriority, TickType_t xPeriod, UartHandle_t xPort )
+{
+    xReportPeriod = xPeriod;
+    xReportPort = xPort;
+
+    /* Room for the tasks that exist now, the monitor and the spare entries;
+    without the tables every scan only reports how many tasks there are. */
+    uxTableSize = uxTaskGetNumberOfTasks() + 1 + stackmonSPARE_TASKS;
+    pxTaskStatus = ( TaskStatus_t * ) pvPortMalloc( uxTableSize * sizeof( TaskStatus_t ) );
+    pxStackReport = ( StackReport_t * ) pvPortMalloc( uxTableSize * sizeof( StackReport_t ) );
+
+    if( ( pxTaskStatus == NULL ) || ( pxStackReport == NULL ) )
+    {
+        uxTableSize = 0;
+    }
+
+    /* vsnprintf() is the deepest call the monitor makes. */
+    xTaskCreate( prvStackMonitorTask, "StackMon", 2*configMINIMAL_STACK_SIZE, NULL, uxPriority, NULL );
+}
@@ -0,0 +1,93 @@
+/**
+ * @file stack_monitor.h
+ * @brief Stack high-water monitoring service
+ *
+ * A low priority task periodically walks every task in the system, reads the
+ * stack high-water mark the kernel maintains and turns it into a recommended
+ * stack depth. The results are kept in a table that can be inspected from the
+ * debugger and are also printed to the PC over UART.
+ *
+ * On the MSP430X port interrupts run on the stack of the task they interrupt,
+ * so there is no separate ISR stack once the scheduler is running. The C
+ * system stack reserved by the linker (--stack_size) is only used by main()
+ * until vTaskStartScheduler() is called; its peak usage is reported as well so
+ * the reservation can be trimmed.
+ *
+ * With configUSE_HEAP_MAP set to 1 the report continues with the heap: the
+ * bytes held by each kind of kernel object, the free space and what is lost
+ * to alignment and block headers.
+ */
+
+#ifndef STACK_MONITOR_H_
+#define STACK_MONITOR_H_
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "uart.h"
+
+/**
+ * @brief Tasks the monitor has room for beyond those that exist when it starts
+ *
+ * The tables are allocated once, for the tasks that exist when
+ * vStackMonitorStart() is called, the monitor itself and this many more. A
+ * scan that finds more tasks than that reports only how many were not shown.
+ */
+#ifndef stackmonSPARE_TASKS
+#define stackmonSPARE_TASKS         ( 4 )
+#endif
+
+/**
+ * @brief Words added to the measured usage to cover interrupt frames
+ *
+ * An interrupt pushes PC and SR, the C handler saves up to twelve 20-bit
+ * registers and the FromISR call chain adds its own frames, all on the stack
+ * of whichever task is running. The high-water mark only shows the worst case
+ * that has been observed so far, so this headroom is always added.
+ */
+#ifndef stackmonISR_MARGIN_WORDS
+#define stackmonISR_MARGIN_WORDS    ( 40 )
+#endif
+
+/** @brief Stack report for a single task */
+typedef struct
+{
+    const char *pcTaskName;         /**< name of the task */
+    uint16_t usStackDepth;          /**< stack depth the task was created with, in words */
+    uint16_t usHighWaterMark;       /**< words that have never been used */
+    uint16_t usRecommendedDepth;    /**< recommended depth to pass to xTaskCreate(), in words */
+} StackReport_t;
+
+/**
+ * @brief Fill the unused part of the C system stack with a known pattern
+ *
+ * Must be called at the very beginning of main(), before any deep call chain
+ * has run, so that the peak usage of the system stack can be measured later.
+ */
+extern void vStackMonitorPaintSystemStack( void );
+
+/**
+ * @brief Create the stack monitor task
+ * @param uxPriority priority of the monitor task, should be low
+ * @param xPeriod time in ticks between two reports
+ * @param xPort UART port the reports are printed on
+ *
+ * Call once the tasks that run for good have been created, so the tables are
+ * sized for them.
+ */
+extern void vStackMonitorStart( UBaseType_t uxPriority, TickType_t xPeriod, UartHandle_t xPort );
+
+/**
+ * @brief Get the results of the last scan
+ * @param ppxReport set to point to the report table
+ * @return number of valid entries in the table
+ */
+extern UBaseType_t uxStackMonitorGetReport( const StackReport_t **ppxReport );
+
+/**
+ * @brief Get the peak usage of the C system stack
+ * @param pusStackSize set to the size of the system stack in bytes
+ * @return number of bytes of the system stack that have been used
+ */
+extern uint16_t usStackMonitorSystemStackUsed( uint16_t *pusStackSize );
+
+#endif /* STACK_MONITOR_H_ */
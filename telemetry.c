@@ -0,0 +1,442 @@
+/**
+ * @file telemetry.c
+ * @brief Framed binary telemetry over UART
+ *
+ * Frames records with a sequence number and CRC-16, encodes them with COBS and
+ * lends the frames to the UART with xUartSendZeroCopy, so they are sent from
+ * where they were encoded. A task streams the raw samples collected by
+ * vTelemetryPostSampleFromISR() and periodically sends the averages, the
+ * counters of the telemetry path and the energy estimate. Messages of the
+ * deferred log are taken out and sent by the same task.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "uart.h"
+#include "stream_buffer.h"
+#include "telemetry.h"
+#include "log.h"
+#include "energy.h"
+
+/* Stack depth of the telemetry task, in words. */
+#define telemetrySTACK_SIZE         ( 2 * configMINIMAL_STACK_SIZE )
+
+/* Size of the buffer raw samples wait in, in bytes. At the highest rate of the simulated ADC it holds more than one flush period. */
+#define telemetrySAMPLE_BUFFER_SIZE ( 256 )
+
+/* Time between two flushes of the sample buffer while samples are streamed. */
+#define telemetryFLUSH_PERIOD       ( pdMS_TO_TICKS( 10 ) )
+
+/* Longest time a logged message waits before it is sent. */
+#define telemetryLOG_PERIOD         ( pdMS_TO_TICKS( 100 ) )
+
+/* Block time for the frames of the telemetry task. */
+#define telemetryBLOCK_TIME         ( pdMS_TO_TICKS( 20 ) )
+
+/* Sequence number, type, payload and CRC. */
+#define telemetryMAX_RECORD         ( 2 + telemetryMAX_PAYLOAD + 2 )
+
+/* COBS adds one byte per 254, the frame is delimited by a zero on both sides. */
+#define telemetryMAX_FRAME          ( 1 + telemetryMAX_RECORD + ( telemetryMAX_RECORD / 254 ) + 1 + 1 )
+
+#if( ( 2 + ( telemetryMAX_LOG_ENTRIES * 10 ) ) > telemetryMAX_PAYLOAD )
+	#error A full log record must fit in the payload
+#endif
+
+/* Bits of a raw sample that hold the conversion result. */
+#define telemetryVALUE_MASK         ( 0x0FFF )
+#define telemetryCHANNEL_SHIFT      ( 12 )
+
+/** @brief CRC-16/CCITT of every value of a nibble, for a table four bits at a time */
+static const uint16_t usCrcTable[ 16 ] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+/** @brief Raw samples waiting to be sent, filled by vTelemetryPostSampleFromISR */
+static StreamBufferHandle_t xSampleBuffer = NULL;
+/** @brief Serializes senders, they share the frame buffers and the sequence number */
+static SemaphoreHandle_t xTelemetryMutex = NULL;
+/** @brief Counts the frame buffers not lent to the UART, given back by prvFrameSent */
+static SemaphoreHandle_t xFramesFree = NULL;
+/** @brief Telemetry task, notified when the settings change */
+static TaskHandle_t xTelemetryTask = NULL;
+/** @brief UART port frames are sent on */
+static UartHandle_t xTelemetryPort;
+/** @brief Provides the averages */
+static TelemetryAveragesFunction_t pxGetAverages;
+
+/** @brief Time between two averages and counters records in ms, 0 when stopped */
+static volatile uint16_t usReportPeriod = 0;
+/** @brief pdTRUE while raw samples are streamed */
+static volatile BaseType_t xRawEnabled = pdFALSE;
+
+/** @brief Sequence number of the next frame */
+static uint8_t ucSequence = 0;
+/** @brief Record being framed */
+static uint8_t ucRecord[ telemetryMAX_RECORD ];
+/** @brief Encoded frames, one is encoded while the one before it is sent */
+static uint8_t ucFrames[ telemetryFRAME_BUFFERS ][ telemetryMAX_FRAME ];
+/** @brief Frame buffer to encode into next; the UART hands them back in order */
+static uint8_t ucNextFrame = 0;
+/** @brief Payload built by the telemetry task, 16-bit aligned for its 16 and 32-bit fields */
+static uint16_t usPayload[ telemetryMAX_PAYLOAD / 2 ];
+
+/** @brief Log entries taken out of the log */
+static LogEntry_t xLogEntries[ telemetryMAX_LOG_ENTRIES ];
+
+/** @brief Raw samples that did not fit in the sample buffer */
+static volatile uint16_t usSamplesDropped = 0;
+/** @brief Frames that could not be queued on the UART */
+static volatile uint16_t usFramesDropped = 0;
+/** @brief Frames queued on the UART */
+static volatile uint16_t usFramesSent = 0;
+
+/**
+ * @brief Calculate CRC-16/CCITT-FALSE
+ * @param pucData bytes to calculate the CRC of
+ * @param usLength number of bytes
+ * @return the CRC
+ */
+static uint16_t prvCrc16( const uint8_t *pucData, uint16_t usLength )
+{
+    uint16_t usCrc = 0xFFFF;
+
+    while( usLength-- > 0 )
+    {
+        usCrc = ( usCrc << 4 ) ^ usCrcTable[ ( usCrc >> 12 ) ^ ( *pucData >> 4 ) ];
+        usCrc = ( usCrc << 4 ) ^ usCrcTable[ ( usCrc >> 12 ) ^ ( *pucData & 0x0F ) ];
+        pucData++;
+    }
+
+    return usCrc;
+}
+
+/**
+ * @brief Encode bytes with COBS
+ * @param pucData bytes to encode
+ * @param usLength number of bytes
+ * @param pucEncoded buffer for the encoded bytes, usLength + usLength / 254 + 1 long
+ * @return number of encoded bytes, none of them zero
+ *
+ * Every zero is replaced by the distance to the next one, the first distance
+ * is placed in front. A run of 254 non-zero bytes is followed by a new
+ * distance so it fits in a byte.
+ */
+static uint16_t prvCobsEncode( const uint8_t *pucData, uint16_t usLength, uint8_t *pucEncoded )
+{
+    uint8_t *pucCode = pucEncoded;
+    uint8_t *pucOut = pucEncoded + 1;
+    uint8_t ucCode = 1;
+
+    while( usLength-- > 0 )
+    {
+        if( *pucData != 0 )
+        {
+            *pucOut++ = *pucData;
+            ucCode++;
+        }
+
+        if( ( *pucData == 0 ) || ( ucCode == 0xFF ) )
+        {
+            *pucCode = ucCode;
+            pucCode = pucOut++;
+            ucCode = 1;
+        }
+
+        pucData++;
+    }
+
+    *pucCode = ucCode;
+
+    return ( uint16_t ) ( pucOut - pucEncoded );
+}
+
+/**
+ * @brief Take back a frame buffer the UART has sent
+ *
+ * Called from ISR context, see UartTxCompleteCallback_t.
+ */
+static void prvFrameSent( const uint8_t *pucData, void *pvContext, BaseType_t *pxHigherPriorityTaskWoken )
+{
+    ( void ) pucData;
+    ( void ) pvContext;
+
+    xSemaphoreGiveFromISR( xFramesFree, pxHigherPriorityTaskWoken );
+}
+
+BaseType_t xTelemetrySendRecord( TelemetryRecord_t eType, const void *pvPayload, uint16_t usLength, TickType_t xBlockTime )
+{
+    uint16_t usCrc, usFrameLength;
+    uint8_t *pucFrame;
+    BaseType_t xResult = pdFAIL;
+    TimeOut_t xTimeOut;
+
+    configASSERT( usLength <= telemetryMAX_PAYLOAD );
+
+    vTaskSetTimeOutState( &xTimeOut );
+
+    /* The sequence number advances for dropped frames too, so the PC sees the
+    gap. A sender that times out on the mutex takes its number without it, so
+    the number and the counters are changed in critical sections. */
+    if( xSemaphoreTake( xTelemetryMutex, xBlockTime ) != pdPASS )
+    {
+        taskENTER_CRITICAL();
+        ucSequence++;
+        usFramesDropped++;
+        taskEXIT_CRITICAL();
+
+        return pdFAIL;
+    }
+
+    taskENTER_CRITICAL();
+    ucRecord[ 0 ] = ucSequence++;
+    taskEXIT_CRITICAL();
+    ucRecord[ 1 ] = ( uint8_t ) eType;
+    memcpy( &ucRecord[ 2 ], pvPayload, usLength );
+    usLength += 2;
+
+    usCrc = prvCrc16( ucRecord, usLength );
+    ucRecord[ usLength++ ] = ( uint8_t ) usCrc;
+    ucRecord[ usLength++ ] = ( uint8_t ) ( usCrc >> 8 );
+
+    /* What is left of the block time is spent waiting for a frame buffer
+    and then for room in the UART's queue of lent buffers. */
+    ( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+    if( xSemaphoreTake( xFramesFree, xBlockTime ) == pdPASS )
+    {
+        pucFrame = ucFrames[ ucNextFrame ];
+
+        /* The leading zero separates the frame from text sent before it. */
+        pucFrame[ 0 ] = 0;
+        usFrameLength = 1 + prvCobsEncode( ucRecord, usLength, &pucFrame[ 1 ] );
+        pucFrame[ usFrameLength++ ] = 0;
+
+        ( void ) xTaskCheckForTimeOut( &xTimeOut, &xBlockTime );
+        xResult = xUartSendZeroCopy( xTelemetryPort, pucFrame, usFrameLength, prvFrameSent, NULL, xBlockTime );
+
+        if( xResult == pdPASS )
+        {
+            ucNextFrame = ( ucNextFrame + 1 ) % telemetryFRAME_BUFFERS;
+        }
+        else
+        {
+            xSemaphoreGive( xFramesFree );
+        }
+    }
+
+    taskENTER_CRITICAL();
+    if( xResult == pdPASS )
+    {
+        usFramesSent++;
+    }
+    else
+    {
+        usFramesDropped++;
+    }
+    taskEXIT_CRITICAL();
+
+    xSemaphoreGive( xTelemetryMutex );
+
+    return xResult;
+}
+
+void vTelemetryPostSampleFromISR( uint8_t ucChannel, uint16_t usValue )
+{
+    uint16_t usSample;
+
+    if( xRawEnabled == pdFALSE )
+    {
+        return;
+    }
+
+    /* Only whole samples are stored, the interrupt is the only producer so
+    the free space can only grow after the check. */
+    if( xStreamBufferSpacesAvailable( xSampleBuffer ) < sizeof( usSample ) )
+    {
+        usSamplesDropped++;
+        return;
+    }
+
+    /* The telemetry task never blocks on the buffer, so there is no task to
+    wake. */
+    usSample = ( ( uint16_t ) ucChannel << telemetryCHANNEL_SHIFT ) | ( usValue & telemetryVALUE_MASK );
+    ( void ) xStreamBufferSendFromISR( xSampleBuffer, &usSample, sizeof( usSample ), NULL );
+}
+
+/**
+ * @brief Send every raw sample waiting in the sample buffer
+ *
+ * Full records are sent while there are enough samples, the rest goes in a
+ * shorter one.
+ */
+static void prvSendSamples( void )
+{
+    uint16_t usBytes;
+
+    for( ;; )
+    {
+        usBytes = ( uint16_t ) xStreamBufferBytesAvailable( xSampleBuffer ) & ~1U;
+
+        if( usBytes == 0 )
+        {
+            break;
+        }
+
+        if( usBytes > ( 2 * telemetryMAX_SAMPLES ) )
+        {
+            usBytes = 2 * telemetryMAX_SAMPLES;
+        }
+
+        /* The MSP430 is little endian, so the words go out in frame order. */
+        usPayload[ 0 ] = usSamplesDropped;
+        ( void ) xStreamBufferReceive( xSampleBuffer, &usPayload[ 1 ], usBytes, 0 );
+
+        xTelemetrySendRecord( eTelemetrySamples, usPayload, usBytes + 2, telemetryBLOCK_TIME );
+    }
+}
+
+/**
+ * @brief Send every message waiting in the log
+ */
+static void prvSendLog( void )
+{
+    UBaseType_t uxCount;
+
+    for( ;; )
+    {
+        uxCount = uxLogRead( xLogEntries, telemetryMAX_LOG_ENTRIES );
+
+        if( uxCount == 0 )
+        {
+            break;
+        }
+
+        usPayload[ 0 ] = usLogDropped();
+        memcpy( &usPayload[ 1 ], xLogEntries, uxCount * sizeof( LogEntry_t ) );
+
+        xTelemetrySendRecord( eTelemetryLog, usPayload, 2 + ( uxCount * sizeof( LogEntry_t ) ), telemetryBLOCK_TIME );
+    }
+}
+
+/**
+ * @brief Send the averages, counters and energy records
+ */
+static void prvSendReport( void )
+{
+    UartStats_t xStats;
+    EnergyReport_t xEnergy;
+
+    pxGetAverages( usPayload );
+    xTelemetrySendRecord( eTelemetryAverages, usPayload, 2 * telemetryCHANNELS, telemetryBLOCK_TIME );
+
+    usPayload[ 0 ] = usSamplesDropped;
+    usPayload[ 1 ] = usFramesDropped;
+    usPayload[ 2 ] = usFramesSent;
+    vUartGetStats( NULL, &xStats );
+    usPayload[ 3 ] = xStats.usTxDropped;
+    usPayload[ 4 ] = xStats.usRxDropped;
+    usPayload[ 5 ] = xStats.usRxOverrun;
+    xTelemetrySendRecord( eTelemetryCounters, usPayload, 12, telemetryBLOCK_TIME );
+
+    vEnergyGetReport( &xEnergy );
+    memcpy( usPayload, &xEnergy, sizeof( xEnergy ) );
+    xTelemetrySendRecord( eTelemetryEnergy, usPayload, sizeof( xEnergy ), telemetryBLOCK_TIME );
+}
+
+/**
+ * @brief Telemetry task function
+ * @param pvParameters not used
+ *
+ * Sleeps until the next report is due, the next flush while samples are
+ * streamed, or the next check of the log. A notification means the settings
+ * were changed, the report period then starts over so a new rate applies at
+ * once.
+ */
+static void prvTelemetryTask( void *pvParameters )
+{
+    TickType_t xLastReport = xTaskGetTickCount();
+    TickType_t xPeriod, xElapsed, xWait;
+
+    for( ;; )
+    {
+        xPeriod = pdMS_TO_TICKS( usReportPeriod );
+
+        if( xPeriod == 0 )
+        {
+            xWait = telemetryLOG_PERIOD;
+        }
+        else
+        {
+            xElapsed = xTaskGetTickCount() - xLastReport;
+            xWait = ( xElapsed < xPeriod ) ? ( xPeriod - xElapsed ) : 0;
+
+            if( xWait > telemetryLOG_PERIOD )
+            {
+                xWait = telemetryLOG_PERIOD;
+            }
+        }
+
+        /* Samples left over after streaming was switched off are still sent. */
+        if( ( ( xRawEnabled != pdFALSE ) || ( xStreamBufferIsEmpty( xSampleBuffer ) == pdFALSE ) ) && ( xWait > telemetryFLUSH_PERIOD ) )
+        {
+            xWait = telemetryFLUSH_PERIOD;
+        }
+
+        if( ulTaskNotifyTake( pdTRUE, xWait ) != 0 )
+        {
+            xLastReport = xTaskGetTickCount();
+            continue;
+        }
+
+        prvSendSamples();
+        prvSendLog();
+
+        if( ( xPeriod != 0 ) && ( ( TickType_t ) ( xTaskGetTickCount() - xLastReport ) >= xPeriod ) )
+        {
+            xLastReport = xTaskGetTickCount();
+            prvSendReport();
+        }
+    }
+}
+
+void vTelemetrySetPeriod( uint16_t usPeriodMs )
+{
+    usReportPeriod = usPeriodMs;
+    xTaskNotifyGive( xTelemetryTask );
+}
+
+uint16_t usTelemetryGetPeriod( void )
+{
+    return usReportPeriod;
+}
+
+void vTelemetrySetRaw( BaseType_t xEnable )
+{
+    xRawEnabled = xEnable;
+    xTaskNotifyGive( xTelemetryTask );
+}
+
+BaseType_t xTelemetryGetRaw( void )
+{
+    return xRawEnabled;
+}
+
+void vTelemetryStart( UBaseType_t uxPriority, UartHandle_t xPort, TelemetryAveragesFunction_t pxAverages )
+{
+    xTelemetryPort = xPort;
+    pxGetAverages = pxAverages;
+
+    xSampleBuffer = xStreamBufferCreate( telemetrySAMPLE_BUFFER_SIZE, 1 );
+    xTelemetryMutex = xSemaphoreCreateMutex();
+    xFramesFree = xSemaphoreCreateCounting( telemetryFRAME_BUFFERS, telemetryFRAME_BUFFERS );
+    configASSERT( ( xSampleBuffer != NULL ) && ( xTelemetryMutex != NULL ) && ( xFramesFree != NULL ) );
+
+    xTaskCreate( prvTelemetryTask, "Tlm", telemetrySTACK_SIZE, NULL, uxPriority, &xTelemetryTask );
+}
@@ -0,0 +1,140 @@
+/**
+ * @file telemetry.h
+ * @brief Framed binary telemetry over UART
+ *
+ * Records are sent as frames that the PC can pick out of the byte stream even
+ * when text, such as command replies, is sent on the same UART. A frame is
+ *
+ *     00 | COBS( seq, type, payload..., crc_lo, crc_hi ) | 00
+ *
+ * COBS (consistent overhead byte stuffing) removes every zero byte from the
+ * encoded frame at the cost of one byte per 254, so a zero always marks the
+ * start or end of a frame. The CRC is CRC-16/CCITT-FALSE (polynomial 0x1021,
+ * initial value 0xFFFF) of seq, type and payload. seq counts every frame the
+ * board tried to send, so a gap on the PC means frames were lost on the way;
+ * frames the UART could not take are counted in the counters record too.
+ *
+ * All values are little endian. Records:
+ *
+ *     eTelemetrySamples   dropped u16, then up to telemetryMAX_SAMPLES
+ *                         samples u16: channel in bits 15..12, value in 11..0
+ *     eTelemetryAverages  one u16 average per channel
+ *     eTelemetryCounters  samples dropped u16, frames dropped u16,
+ *                         frames sent u16, UART bytes dropped u16: sent,
+ *                         received, overrun
+ *     eTelemetryLog       dropped u16, then up to telemetryMAX_LOG_ENTRIES
+ *                         LogEntry_t: id u8, ready u8, tick u16,
+ *                         3 arguments u16
+ *     eTelemetryEnergy    EnergyReport_t: ticks u32, samples u32,
+ *                         nJ per sample u32, uJ u32: total, active, LPM,
+ *                         ADC, UART
+ *
+ * dropped in a samples record is the running count of raw samples that did
+ * not fit in the sample buffer, so an increase between two records tells the
+ * PC how many samples are missing before the second one. dropped in a log
+ * record works the same way for log messages, see log.h. The UART counts are
+ * summed over every open port, see UartStats_t, so text lost on the console
+ * shows up here too. An energy record covers the time since the one before,
+ * see energy.h.
+ *
+ * tools/telemetry_decode.py decodes the stream on the PC.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "FreeRTOS.h"
+#include "uart.h"
+
+/** @brief Number of channels averages are reported for */
+#define telemetryCHANNELS           ( 2 )
+
+/** @brief Largest number of raw samples in one samples record */
+#define telemetryMAX_SAMPLES        ( 32 )
+
+/** @brief Largest number of log entries in one log record */
+#define telemetryMAX_LOG_ENTRIES    ( 6 )
+
+/** @brief Frame buffers lent to the UART at most, uxZeroCopyLength of the port must be at least this */
+#define telemetryFRAME_BUFFERS      ( 2 )
+
+/** @brief Largest payload of a record, a full samples record */
+#define telemetryMAX_PAYLOAD        ( 2 + ( 2 * telemetryMAX_SAMPLES ) )
+
+/** @brief Type of a record, the second byte of the frame */
+typedef enum
+{
+    eTelemetrySamples = 1,      /**< raw conversion results */
+    eTelemetryAverages,         /**< latest average of every channel */
+    eTelemetryCounters,         /**< health counters of the telemetry path */
+    eTelemetryLog,              /**< messages of the deferred log */
+    eTelemetryEnergy            /**< energy used since the last report */
+} TelemetryRecord_t;
+
+/**
+ * @brief Averages function pointer type
+ * @param pusAverages array of telemetryCHANNELS averages to fill
+ *
+ * Called from the telemetry task each time an averages record is sent.
+ */
+typedef void ( *TelemetryAveragesFunction_t )( uint16_t *pusAverages );
+
+/**
+ * @brief Create the telemetry task
+ * @param uxPriority priority of the telemetry task
+ * @param xPort UART port frames are sent on, opened with uxZeroCopyLength of at
+ * least telemetryFRAME_BUFFERS
+ * @param pxAverages function that provides the averages
+ *
+ * Telemetry starts switched off, see vTelemetrySetPeriod() and
+ * vTelemetrySetRaw().
+ */
+extern void vTelemetryStart( UBaseType_t uxPriority, UartHandle_t xPort, TelemetryAveragesFunction_t pxAverages );
+
+/**
+ * @brief Frame and send one record
+ * @param eType type of the record
+ * @param pvPayload payload of the record
+ * @param usLength number of payload bytes, at most telemetryMAX_PAYLOAD
+ * @param xBlockTime block time in ticks to wait for other senders and a free frame buffer
+ * @return pdPASS if the frame was queued on the UART, pdFAIL if it was dropped
+ *
+ * Can be called from any task once vTelemetryStart() has run.
+ */
+extern BaseType_t xTelemetrySendRecord( TelemetryRecord_t eType, const void *pvPayload, uint16_t usLength, TickType_t xBlockTime );
+
+/**
+ * @brief Set the time between two averages and counters records
+ * @param usPeriodMs period in ms, 0 stops the records
+ */
+extern void vTelemetrySetPeriod( uint16_t usPeriodMs );
+
+/**
+ * @brief Get the time between two averages and counters records
+ * @return period in ms, 0 if the records are stopped
+ */
+extern uint16_t usTelemetryGetPeriod( void );
+
+/**
+ * @brief Switch streaming of raw samples on or off
+ * @param xEnable pdTRUE to stream every sample passed to vTelemetryPostSampleFromISR()
+ */
+extern void vTelemetrySetRaw( BaseType_t xEnable );
+
+/**
+ * @brief Check whether raw samples are streamed
+ * @return pdTRUE if raw samples are streamed
+ */
+extern BaseType_t xTelemetryGetRaw( void );
+
+/**
+ * @brief Hand one raw sample over for streaming
+ * @param ucChannel channel of the sample, 0 to 15
+ * @param usValue 12-bit conversion result
+ *
+ * Called from the interrupt that produces the samples; there must be only one
+ * such interrupt at a time. Does nothing while raw streaming is off.
+ */
+extern void vTelemetryPostSampleFromISR( uint8_t ucChannel, uint16_t usValue );
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""Convert a recorded ADC capture to the C table replayed by adc_sim.c.
+
+Input formats:
+
+  CSV     one record per line: time_ms,a14,a15
+          time_ms is the absolute time of the conversion in milliseconds
+          (fractions allowed), a14 and a15 the ADC12MEM0 and ADC12MEM1
+          values. A first line that does not start with a number is taken
+          as a header and skipped.
+
+  binary  little endian records of <uint32 time_us><uint16 a14><uint16 a15>
+
+The first record is replayed adcsimCAPTURE_TICK_US after the replay starts;
+every later one keeps its distance to the record before it.
+
+Usage:
+  tools/adc_capture.py capture.csv -o adc_capture.c
+  tools/adc_capture.py --binary capture.bin -o adc_capture.c
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+
+# Must match adcsimCAPTURE_TICK_US in adc_sim.h
+TICK_US = 100
+MAX_DELAY = 0xFFFF
+MAX_RECORDS = 0xFFFF
+
+
+def read_csv(path):
+    records = []
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            if not row or row[0].strip().startswith("#"):
+                continue
+            try:
+                t_ms = float(row[0])
+            except ValueError:
+                if not records:
+                    continue  # header
+                raise
+            records.append((int(round(t_ms * 1000.0)), int(row[1], 0), int(row[2], 0)))
+    return records
+
+
+def read_binary(path):
+    fmt = struct.Struct("<IHH")
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) % fmt.size:
+        sys.exit("%s: size is not a multiple of %d bytes" % (path, fmt.size))
+    return [fmt.unpack_from(data, o) for o in range(0, len(data), fmt.size)]
+
+
+def to_delays(records):
+    out = []
+    prev_us = None
+    for t_us, a14, a15 in records:
+        for v in (a14, a15):
+            if not 0 <= v <= 0x0FFF:
+                sys.exit("value %d at %d us does not fit 12 bits" % (v, t_us))
+        if prev_us is None:
+            delay = 1
+        else:
+            if t_us < prev_us:
+                sys.exit("time goes backwards at %d us" % t_us)
+            delay = int(round((t_us - prev_us) / float(TICK_US)))
+        # Refuse gaps the delay field can not hold rather than shorten them.
+        if delay > MAX_DELAY:
+            sys.exit("gap of %d us before %d us is longer than %d us"
+                     % (t_us - prev_us, t_us, MAX_DELAY * TICK_US))
+        out.append((delay, a14, a15))
+        prev_us = t_us
+    if not out:
+        sys.exit("capture is empty")
+    if len(out) > MAX_RECORDS:
+        sys.exit("capture has more than %d records" % MAX_RECORDS)
+    return out
+
+
+def write_c(path, name, records):
+    lines = [
+        "/**",
+        " * @file %s" % os.path.basename(path),
+        " * @brief ADC capture replayed by adc_sim.c",
+        " *",
+        " * Generated by tools/adc_capture.py from %s, do not edit." % name,
+        " */",
+        "",
+        '#include "adc_sim.h"',
+        "",
+        "static const ADCCaptureRecord_t xRecords[] =",
+        "{",
+    ]
+    lines += ["    { %5u, 0x%03x, 0x%03x }," % r for r in records]
+    lines += [
+        "};",
+        "",
+        "const ADCCapture_t xADCCapture =",
+        "{",
+        '    "%s",' % name,
+        "    xRecords,",
+        "    sizeof( xRecords ) / sizeof( xRecords[ 0 ] )",
+        "};",
+        "",
+    ]
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("capture")
+    parser.add_argument("--binary", action="store_true", help="input is binary, not CSV")
+    parser.add_argument("-o", "--output", default="adc_capture.c")
+    args = parser.parse_args()
+
+    records = read_binary(args.capture) if args.binary else read_csv(args.capture)
+    delays = to_delays(records)
+    write_c(args.output, os.path.basename(args.capture), delays)
+
+    total_ms = sum(d for d, _, _ in delays) * TICK_US / 1000.0
+    print("%s: %d records, %.1f ms" % (args.output, len(delays), total_ms))
+
+
+if __name__ == "__main__":
+    main()
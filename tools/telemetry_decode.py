@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+"""Decode the framed binary telemetry sent by telemetry.c.
+
+Frames are COBS encoded and delimited by zero bytes. Each decoded frame is
+
+  seq u8, type u8, payload, crc u16
+
+with CRC-16/CCITT-FALSE over seq, type and payload, all little endian.
+By default frames go out on their own port (USCI_A1, mainTELEMETRY_PORT in
+main.c), while command replies and stack reports go to the console on
+USCI_A0. If main.c puts both on one port, the bytes between frames that
+are not a valid frame are that text, and they are printed as text.
+
+Drops are reported in two places: a gap in seq means frames were lost
+between the board and the PC, an increase of the dropped count in a
+samples or log record means raw samples or log messages did not fit in
+the board's buffer. Counters records add the bytes the board's UARTs
+dropped, summed over all ports, so text lost on the console is visible.
+
+Energy records carry the board's estimate of the energy used since the
+previous one, split by consumer, and the energy per delivered sample.
+
+Log records carry only message ids and arguments. The messages are
+rendered from the string table generated from log_messages.h, the same
+X-macro list the firmware builds its ids from.
+
+Usage:
+  tools/telemetry_decode.py /dev/ttyUSB0            (needs pyserial)
+  tools/telemetry_decode.py capture.bin
+  tools/telemetry_decode.py /dev/ttyUSB0 --samples samples.csv
+  tools/telemetry_decode.py /dev/ttyUSB0 --baud 115200  (after "baud 115200")
+  tools/telemetry_decode.py --log-table       (print the string table)
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+# Must match TelemetryRecord_t in telemetry.h
+SAMPLES = 1
+AVERAGES = 2
+COUNTERS = 3
+LOG = 4
+ENERGY = 5
+
+# Must match LogEntry_t in log.h: id, ready, tick, three arguments
+LOG_ENTRY = struct.Struct("<BBH3H")
+
+# Must match EnergyReport_t in energy.h
+ENERGY_REPORT = struct.Struct("<8I")
+
+LOG_MESSAGES_H = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "log_messages.h")
+
+# Must match mainTELEMETRY_BAUD in main.c, or the last baud command
+BAUD = 921600
+
+CHANNEL_NAMES = {0: "A14", 1: "A15"}
+
+
+def load_log_table(path):
+    """Return the format strings of log_messages.h, indexed by message id."""
+    with open(path) as f:
+        text = f.read()
+    table = [fmt for _, fmt in re.findall(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', text)]
+    if not table:
+        sys.exit("%s: no log messages found" % path)
+    return table
+
+
+def render_log(table, msg_id, args):
+    if msg_id >= len(table):
+        return "unknown log message %d %s" % (msg_id, args)
+    fmt = table[msg_id]
+    values = []
+    for conv in re.findall(r"%[-0-9]*([a-z])", fmt):
+        value = args[len(values)] if len(values) < len(args) else 0
+        # Arguments are 16-bit words, %d takes them as signed
+        values.append(value - 0x10000 if conv == "d" and value & 0x8000 else value)
+    try:
+        return fmt % tuple(values)
+    except (TypeError, ValueError):
+        return "%s %s" % (fmt, args)
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_frame(segment):
+    """Return (seq, type, payload) or None if the segment is not a frame."""
+    record = cobs_decode(segment)
+    if record is None or len(record) < 4:
+        return None
+    body, crc = record[:-2], struct.unpack("<H", record[-2:])[0]
+    if crc16(body) != crc:
+        return None
+    return body[0], body[1], body[2:]
+
+
+class Decoder:
+    def __init__(self, samples_out, log_table):
+        self.samples_out = samples_out
+        self.log_table = log_table
+        self.expected_seq = None
+        self.last_dropped = None
+        self.last_log_dropped = None
+        self.frames = 0
+        self.frames_lost = 0
+        self.samples = 0
+        self.samples_lost = 0
+
+    def segment(self, segment):
+        frame = parse_frame(segment) if segment else None
+        if frame is None:
+            text = segment.decode("ascii", "replace").strip()
+            if text:
+                print(text)
+            return
+        seq, rtype, payload = frame
+        self.frames += 1
+        if self.expected_seq is not None and seq != self.expected_seq:
+            lost = (seq - self.expected_seq) & 0xFF
+            self.frames_lost += lost
+            print("# %d frame(s) lost before seq %d" % (lost, seq))
+        self.expected_seq = (seq + 1) & 0xFF
+        self.record(seq, rtype, payload)
+
+    def record(self, seq, rtype, payload):
+        if rtype == SAMPLES and len(payload) >= 2 and len(payload) % 2 == 0:
+            words = struct.unpack("<%dH" % (len(payload) // 2), payload)
+            dropped = words[0]
+            if self.last_dropped is not None and dropped != self.last_dropped:
+                lost = (dropped - self.last_dropped) & 0xFFFF
+                self.samples_lost += lost
+                print("# %d sample(s) dropped on the board before seq %d" % (lost, seq))
+            self.last_dropped = dropped
+            for w in words[1:]:
+                channel, value = w >> 12, w & 0x0FFF
+                self.samples += 1
+                if self.samples_out:
+                    self.samples_out.write("%d,%s,%d\n" % (seq, CHANNEL_NAMES.get(channel, channel), value))
+        elif rtype == AVERAGES and len(payload) % 2 == 0:
+            avgs = struct.unpack("<%dH" % (len(payload) // 2), payload)
+            print("AVG " + " ".join("%s=%d" % (CHANNEL_NAMES.get(i, i), v) for i, v in enumerate(avgs)))
+        elif rtype == COUNTERS and len(payload) == 12:
+            print("CNT samples_dropped=%d frames_dropped=%d frames_sent=%d "
+                  "uart_tx_dropped=%d uart_rx_dropped=%d uart_rx_overrun=%d" % struct.unpack("<6H", payload))
+        elif rtype == LOG and len(payload) >= 2 and (len(payload) - 2) % LOG_ENTRY.size == 0:
+            dropped = struct.unpack_from("<H", payload)[0]
+            if self.last_log_dropped is not None and dropped != self.last_log_dropped:
+                print("# %d log message(s) dropped on the board" % ((dropped - self.last_log_dropped) & 0xFFFF))
+            self.last_log_dropped = dropped
+            for offset in range(2, len(payload), LOG_ENTRY.size):
+                msg_id, _, tick, *args = LOG_ENTRY.unpack_from(payload, offset)
+                print("LOG %5u %s" % (tick, render_log(self.log_table, msg_id, args)))
+        elif rtype == ENERGY and len(payload) == ENERGY_REPORT.size:
+            ticks, samples, per_sample, total, active, lpm, adc, uart = ENERGY_REPORT.unpack(payload)
+            print("NRG ticks=%d samples=%d nJ/sample=%d uJ=%d active=%d lpm=%d adc=%d uart=%d"
+                  % (ticks, samples, per_sample, total, active, lpm, adc, uart))
+        else:
+            print("# seq %d: unknown record type %d, %d bytes" % (seq, rtype, len(payload)))
+
+    def summary(self):
+        print("# %d frames, %d lost; %d samples, %d dropped on the board"
+              % (self.frames, self.frames_lost, self.samples, self.samples_lost), file=sys.stderr)
+
+
+def open_source(path, baud):
+    if os.path.isfile(path):
+        return open(path, "rb")
+    try:
+        import serial
+    except ImportError:
+        sys.exit("%s is not a file and pyserial is not installed" % path)
+    return serial.Serial(path, baud, timeout=0.1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("source", nargs="?", help="serial port or file with recorded bytes")
+    parser.add_argument("--samples", help="write raw samples as CSV: seq,channel,value")
+    parser.add_argument("--baud", type=int, default=BAUD, help="baud rate of the serial port")
+    parser.add_argument("--messages", default=LOG_MESSAGES_H, help="log_messages.h of the firmware")
+    parser.add_argument("--log-table", action="store_true", help="print the log string table and exit")
+    args = parser.parse_args()
+
+    log_table = load_log_table(args.messages)
+    if args.log_table:
+        for msg_id, fmt in enumerate(log_table):
+            print("%3d %s" % (msg_id, fmt))
+        return
+    if not args.source:
+        parser.error("source is required")
+
+    samples_out = open(args.samples, "w") if args.samples else None
+    if samples_out:
+        samples_out.write("seq,channel,value\n")
+    decoder = Decoder(samples_out, log_table)
+    source = open_source(args.source, args.baud)
+    pending = bytearray()
+    try:
+        while True:
+            data = source.read(256)
+            if not data:
+                if os.path.isfile(args.source):
+                    break
+                continue
+            pending += data
+            *segments, rest = pending.split(b"\x00")
+            pending = bytearray(rest)
+            for segment in segments:
+                decoder.segment(bytes(segment))
+    except KeyboardInterrupt:
+        pass
+    if pending:
+        decoder.segment(bytes(pending))
+    decoder.summary()
+    if samples_out:
+        samples_out.close()
+
+
+if __name__ == "__main__":
+    main()
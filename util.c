@@ -14,17 +14,58 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "timers.h"
+#include "dvfs.h"
+#include "lpm.h"
+#include "energy.h"
 
 /* Hardware includes. */
 #include "msp430.h"
 #include "hal_ETF5438A.h"
 
+/* ACLK frequency; REFO and XT1 both run at 32768 Hz, see hal_clock.h */
+#define utilACLK_HZ             ( 32768UL )
+
+/* Whole ACLK periods per tick and the fraction left over, in 1/configTICK_RATE_HZ */
+#define utilTICK_COUNTS         ( ( uint16_t ) ( utilACLK_HZ / configTICK_RATE_HZ ) )
+#define utilTICK_REMAINDER      ( ( uint16_t ) ( utilACLK_HZ % configTICK_RATE_HZ ) )
+
+/**
+ * @brief Spread the fraction of an ACLK period over the ticks
+ *
+ * 32768 Hz is not a multiple of the tick rate. Each tick lasts either
+ * utilTICK_COUNTS or one period more, chosen so the remainders add up, and
+ * the tick rate is exact on average instead of 0.7 % slow. Runs in the tick
+ * interrupt right after Timer_A0 restarted from zero, so the new compare
+ * value is never behind the counter.
+ */
+static void prvTrimTick( void )
+{
+    static uint16_t usFraction = 0;
+
+    usFraction += utilTICK_REMAINDER;
+    if( usFraction >= configTICK_RATE_HZ )
+    {
+        usFraction -= configTICK_RATE_HZ;
+        TA0CCR0 = utilTICK_COUNTS;
+    }
+    else
+    {
+        TA0CCR0 = utilTICK_COUNTS - 1;
+    }
+}
+
 /**
  * @brief Tick hook
+ *
+ * Keeps the tick rate exact, samples the CPU load for the governor, the
+ * low power mode residency and the current consumers for the energy estimate.
  */
 void vApplicationTickHook( void )
 {
-    ;
+    prvTrimTick();
+    vDvfsTickHook();
+    vLpmTickHook();
+    vEnergyTickHook();
 }
 
 /**
@@ -40,8 +81,6 @@ void vApplicationTickHook( void )
  */
 void vApplicationSetupTimerInterrupt( void )
 {
-    const unsigned short usACLK_Frequency_Hz = 32768;
-
     /* Ensure the timer is stopped. */
     TA0CTL = 0;
 
@@ -51,8 +90,9 @@ void vApplicationSetupTimerInterrupt( void )
     /* Clear everything to start with. */
     TA0CTL |= TACLR;
 
-    /* Set the compare match value according to the tick rate we want. */
-    TA0CCR0 = usACLK_Frequency_Hz / configTICK_RATE_HZ;
+    /* Set the compare match value according to the tick rate we want; the
+    tick hook adds the fraction of a period that is left over. */
+    TA0CCR0 = utilTICK_COUNTS - 1;
 
     /* Enable the interrupts. */
     TA0CCTL0 = CCIE;
@@ -70,9 +110,9 @@ void vApplicationSetupTimerInterrupt( void )
  */
 void vApplicationIdleHook( void )
 {
-    /* Called on each iteration of the idle task.  In this case the idle task
-    just enters a low(ish) power mode. */
-    __bis_SR_register( LPM0_bits + GIE );
+    /* Called on each iteration of the idle task.  Idle periods too short for
+    vLpmSleep() are spent in LPM0. */
+    vLpmIdleHook();
 }
 
 /**